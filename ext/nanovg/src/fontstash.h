@@ -55,14 +55,15 @@ enum FONSerrorCode {
 };
 
 struct FONSparams {
-	int width, height;
+	int width, height;	// Size of an atlas page
 	unsigned char flags;
 	void* userPtr;
 	int (*renderCreate)(void* uptr, int width, int height);
 	int (*renderResize)(void* uptr, int width, int height);
-	void (*renderUpdate)(void* uptr, int* rect, const unsigned char* data);
-	void (*renderDraw)(void* uptr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
+	void (*renderUpdate)(void* uptr, int page, int* rect, const unsigned char* data);
+	void (*renderDraw)(void* uptr, int page, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	void (*renderDelete)(void* uptr);
+	int maxPages;		// Number of pages the atlas may use, FONS_DEFAULT_MAX_PAGES if 0
 };
 typedef struct FONSparams FONSparams;
 
@@ -79,6 +80,8 @@ struct FONStextIter {
 	short isize, iblur;
 	struct FONSfont* font;
 	int prevGlyphIndex;
+	int page;	// Atlas page of the last glyph, -1 if its bitmap was not required, FONS_GLYPH_PENDING while it is rasterized
+	int sdf;	// Quads are of signed distance fields
 	const char* str;
 	const char* next;
 	const char* end;
@@ -87,7 +90,11 @@ struct FONStextIter {
 };
 typedef struct FONStextIter FONStextIter;
 
+// Page of a glyph whose bitmap is being rasterized by a FONSglyphJob, see fonsSetGlyphRasterizer().
+#define FONS_GLYPH_PENDING -2
+
 typedef struct FONScontext FONScontext;
+typedef struct FONSglyphJob FONSglyphJob;
 
 // Constructor and destructor.
 FONScontext* fonsCreateInternal(FONSparams* params);
@@ -101,10 +108,75 @@ int fonsExpandAtlas(FONScontext* s, int width, int height);
 // Resets the whole stash.
 int fonsResetAtlas(FONScontext* stash, int width, int height);
 
+// Glyphs are packed into atlas pages of the size given at creation, each of which the
+// renderer keeps in its own texture. When all pages are full, the least recently used
+// page that was not drawn from since the last call to fonsBeginFrame() is evicted.
+// Starts a new frame.
+void fonsBeginFrame(FONScontext* s);
+// Marks a page as used in the current frame, e.g. when drawing cached quads from it.
+void fonsTouchPage(FONScontext* s, int page);
+// Sets the number of pages the atlas may use. Surplus pages are released unless they
+// were used in the current frame.
+void fonsSetMaxPages(FONScontext* s, int maxPages);
+// Returns the number of page slots. Released pages keep their slot.
+int fonsGetPageCount(FONScontext* s);
+// Returns 1 if the page holds signed distance fields rather than coverage.
+int fonsIsSDFPage(FONScontext* s, int page);
+// Returns the number of pages evicted so far. Texture coordinates of glyphs that were
+// cached elsewhere are only valid as long as this does not change.
+int fonsGetEvictionCount(FONScontext* s);
+
+// Glyphs missing from the atlas may be rasterized elsewhere, e.g. on worker threads, rather than
+// while drawing. Each such glyph is passed to submit() once, as a job that must be handed back to
+// fonsFinishGlyphJobs() or fonsDeleteGlyphJob() on the thread of the stash, and before the stash
+// is deleted. Until then, the glyph is iterated with the page FONS_GLYPH_PENDING and not drawn,
+// for up to maxPendingFrames calls to fonsBeginFrame(), after which it is rasterized when drawn.
+// A NULL submit rasterizes all glyphs when drawn. Returns 0 if the font backend can not rasterize
+// concurrently, which is the case for FreeType.
+int fonsSetGlyphRasterizer(FONScontext* s, void (*submit)(void* uptr, FONSglyphJob* job), void* uptr, int maxPendingFrames);
+// Rasterizes the glyph of a job. Touches only the job and the font data, so that any thread may
+// rasterize jobs while the stash is in use.
+void fonsRasterizeGlyphJob(FONSglyphJob* job);
+// Packs the rasterized glyphs of the jobs into the atlas, tallest first, and deletes the jobs.
+// Glyphs that are no longer pending, e.g. after fonsResetAtlas(), are dropped. Returns the
+// number of glyphs added.
+int fonsFinishGlyphJobs(FONScontext* s, FONSglyphJob** jobs, int njobs);
+void fonsDeleteGlyphJob(FONSglyphJob* job);
+// Returns the number of glyphs rasterized while drawing so far, each of which stalled its frame.
+int fonsGetGlyphStalls(FONScontext* s);
+
+// Serializes the use of a stash by several threads, e.g. measuring text on one thread while
+// another draws. Calls between fonsLock() and fonsUnlock(), including those that set the
+// state, see the stash as if no other thread used it. Locks may be nested.
+void fonsLock(FONScontext* s);
+// Like fonsLock(), but lets the threads waiting in fonsLock() go first, so that threads that
+// keep locking the stash, e.g. to measure text ahead of time, never hold up the one drawing
+// for longer than a single lock. Must not be nested in another lock of the same thread.
+void fonsLockYielding(FONScontext* s);
+void fonsUnlock(FONScontext* s);
+
+// Pre-rasterized glyphs, as written by resources/bake_glyph_atlas.cpp. The data starts with
+// the magic "FONSBAKE", followed by little-endian 32-bit atlas width, height and font count.
+// Each font record holds the font name (64 bytes), the size of the font data it was baked
+// from and its glyph count, followed by that many glyph records: codepoint, glyph index,
+// then size, blur, x0, y0, x1, y1, xadv, xoff, yoff and a padding word as 16-bit values,
+// with coordinates relative to the baked atlas. The alpha image of the atlas comes last.
+// Returns the size of the baked atlas image, or 0 if the data is not valid.
+int fonsBakedGlyphsSize(const unsigned char* data, int ndata, int* width, int* height);
+// Copies pre-rasterized glyphs into the atlas. Fonts are matched by name and data size,
+// glyphs of other fonts and glyphs that are already cached are skipped. Returns the number
+// of glyphs added, or -1 if the baked atlas image does not fit into the atlas.
+int fonsAddBakedGlyphs(FONScontext* stash, const unsigned char* data, int ndata);
+
 // Add fonts
 int fonsAddFont(FONScontext* s, const char* name, const char* path);
 int fonsAddFontMem(FONScontext* s, const char* name, unsigned char* data, int ndata, int freeData);
 int fonsGetFontByName(FONScontext* s, const char* name);
+// Looks up which font of the fallback chain of the current font has each codepoint of the
+// string, so that drawing it later finds them resolved. Codepoints are otherwise resolved as
+// they are first drawn, once per font chain. Returns the number of codepoints that no font of
+// the chain has.
+int fonsResolveText(FONScontext* s, const char* string, const char* end);
 
 // State handling
 void fonsPushState(FONScontext* s);
@@ -118,6 +190,10 @@ void fonsSetSpacing(FONScontext* s, float spacing);
 void fonsSetBlur(FONScontext* s, float blur);
 void fonsSetAlign(FONScontext* s, int align);
 void fonsSetFont(FONScontext* s, int font);
+// Draws text of any size from signed distance fields of the glyphs, which are rasterized
+// once at FONS_SDF_SIZE and kept in pages of their own (see fonsIsSDFPage()). Applies to
+// text iterated with FONS_GLYPH_BITMAP_REQUIRED and without blur.
+void fonsSetSDF(FONScontext* s, int enabled);
 
 // Draw text
 float fonsDrawText(FONScontext* s, float x, float y, const char* string, const char* end);
@@ -131,9 +207,9 @@ void fonsVertMetrics(FONScontext* s, float* ascender, float* descender, float* l
 int fonsTextIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const char* str, const char* end, int bitmapOption);
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, struct FONSquad* quad);
 
-// Pull texture changes
-const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height);
-int fonsValidateTexture(FONScontext* s, int* dirty);
+// Pull texture changes of a page. The data is NULL for a released page.
+const unsigned char* fonsGetTextureData(FONScontext* stash, int page, int* width, int* height);
+int fonsValidateTexture(FONScontext* s, int page, int* dirty);
 
 // Draws the stash texture for debugging
 void fonsDrawDebug(FONScontext* s, float x, float y);
@@ -143,8 +219,20 @@ void fonsDrawDebug(FONScontext* s, float x, float y);
 
 #ifdef FONTSTASH_IMPLEMENTATION
 
+#include <pthread.h>
+
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+// Bump allocator for the font backend. Glyph jobs have their own, so that they can be
+// rasterized concurrently with the stash.
+struct FONSscratch
+{
+	unsigned char* data;
+	int size;
+	FONScontext* stash;	// Receives errors, NULL for glyph jobs
+};
+typedef struct FONSscratch FONSscratch;
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
@@ -252,11 +340,27 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 	return (int)((ftKerning.x + 32) >> 6);  // Round up and convert to integer
 }
 
+int fons__tt_getKernPairCount(FONSttFontImpl *font)
+{
+	// FreeType does not enumerate kerning pairs, they are queried one at a time.
+	FONS_NOTUSED(font);
+	return -1;
+}
+
+unsigned int fons__tt_getKernPair(FONSttFontImpl *font, int i, int *advance)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(i);
+	*advance = 0;
+	return 0;
+}
+
 #else
 
 #define STB_TRUETYPE_IMPLEMENTATION
 static void* fons__tmpalloc(size_t size, void* up);
 static void fons__tmpfree(void* ptr, void* up);
+static FONSscratch* fons__stashScratch(FONScontext* stash);
 #define STBTT_malloc(x,u)    fons__tmpalloc(x,u)
 #define STBTT_free(x,u)      fons__tmpfree(x,u)
 #include "stb_truetype.h"
@@ -283,7 +387,7 @@ int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char
 	int stbError;
 	FONS_NOTUSED(dataSize);
 
-	font->font.userdata = context;
+	font->font.userdata = fons__stashScratch(context);
 	stbError = stbtt_InitFont(&font->font, data, 0);
 	return stbError;
 }
@@ -323,14 +427,46 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
 }
 
+int fons__tt_getKernPairCount(FONSttFontImpl *font)
+{
+	stbtt_uint8 *data = font->font.data + font->font.kern;
+	// Only the first table is used, which must be horizontal and format 0 (see stbtt_GetGlyphKernAdvance()).
+	if (!font->font.kern || ttUSHORT(data+2) < 1 || ttUSHORT(data+8) != 1)
+		return 0;
+	return ttUSHORT(data+10);
+}
+
+unsigned int fons__tt_getKernPair(FONSttFontImpl *font, int i, int *advance)
+{
+	stbtt_uint8 *data = font->font.data + font->font.kern + 18 + i*6;
+	*advance = ttSHORT(data+4);
+	return ttULONG(data);
+}
+
 #endif
 
 #ifndef FONS_SCRATCH_BUF_SIZE
 #	define FONS_SCRATCH_BUF_SIZE 96000
 #endif
-#ifndef FONS_HASH_LUT_SIZE
-#	define FONS_HASH_LUT_SIZE 256
+#ifndef FONS_INIT_GLYPH_SLOTS
+#	define FONS_INIT_GLYPH_SLOTS 1024
+#endif
+#ifndef FONS_DEFAULT_MAX_PAGES
+#	define FONS_DEFAULT_MAX_PAGES 4
+#endif
+// Signed distance fields are rasterized at this size in pixels, FONS_SDF_UPSAMPLE times
+// larger for the distance transform, and reach FONS_SDF_PADDING pixels beyond the outline.
+#ifndef FONS_SDF_SIZE
+#	define FONS_SDF_SIZE 48
 #endif
+#ifndef FONS_SDF_UPSAMPLE
+#	define FONS_SDF_UPSAMPLE 4
+#endif
+#ifndef FONS_SDF_PADDING
+#	define FONS_SDF_PADDING 6
+#endif
+// Blur of the cached glyphs that hold signed distance fields.
+#define FONS_SDF_GLYPH -1
 #ifndef FONS_INIT_FONTS
 #	define FONS_INIT_FONTS 4
 #endif
@@ -375,17 +511,46 @@ struct FONSglyph
 {
 	unsigned int codepoint;
 	int index;
-	int next;
 	short size, blur;
+	short page;	// -1 while the glyph has no bitmap in the atlas, or FONS_GLYPH_PENDING
 	short x0,y0,x1,y1;
 	short xadv,xoff,yoff;
+	unsigned int requested;	// Frame in which a pending glyph was submitted
 };
 typedef struct FONSglyph FONSglyph;
 
+// Slot of the glyph table, which maps a font, codepoint, size and blur to a glyph of the font.
+struct FONSglyphSlot
+{
+	unsigned int codepoint;
+	short size, blur;
+	int font;	// -1 for an empty slot
+	int glyph;
+};
+typedef struct FONSglyphSlot FONSglyphSlot;
+
+// Codepoint resolved by a font chain: the font of the chain that has it, and its glyph index.
+struct FONSresolved
+{
+	unsigned int codepoint;
+	int font;	// -1 for an empty slot
+	int index;
+};
+typedef struct FONSresolved FONSresolved;
+
+// Kerning pair, with the glyph indices as glyph1 << 16 | glyph2. Zero marks an empty slot.
+struct FONSkernPair
+{
+	unsigned int pair;
+	int advance;
+};
+typedef struct FONSkernPair FONSkernPair;
+
 struct FONSfont
 {
 	FONSttFontImpl font;
 	char name[64];
+	int id;
 	unsigned char* data;
 	int dataSize;
 	unsigned char freeData;
@@ -395,9 +560,18 @@ struct FONSfont
 	FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
-	int lut[FONS_HASH_LUT_SIZE];
 	int fallbacks[FONS_MAX_FALLBACKS];
 	int nfallbacks;
+	// Open addressing table of the codepoints resolved by the font and its fallbacks, which
+	// is cleared when a fallback is added.
+	FONSresolved* resolved;
+	int resolvedMask;
+	int nresolved;
+	// Open addressing table of kerning pairs. nkern is 0 for fonts without kerning,
+	// and -1 when pairs have to be queried from the font one at a time.
+	FONSkernPair* kern;
+	int kernMask;
+	int nkern;
 };
 typedef struct FONSfont FONSfont;
 
@@ -409,6 +583,7 @@ struct FONSstate
 	unsigned int color;
 	float blur;
 	float spacing;
+	int sdf;
 };
 typedef struct FONSstate FONSstate;
 
@@ -426,26 +601,68 @@ struct FONSatlas
 };
 typedef struct FONSatlas FONSatlas;
 
+struct FONSpage
+{
+	FONSatlas* atlas;
+	unsigned char* texData;	// NULL for a released page
+	int dirtyRect[4];
+	unsigned int lastUsed;	// Frame in which the page was last drawn from
+	int sdf;		// Holds signed distance fields
+};
+typedef struct FONSpage FONSpage;
+
+struct FONSglyphJob
+{
+	FONSttFontImpl font;	// Copy of the rendering font, which allocates from scratch
+	FONSscratch scratch;
+	int fontId;
+	unsigned int codepoint;
+	short isize, iblur;
+	int index;
+	float scale;
+	int x0, y0;		// Top left corner of the glyph box
+	int width, height;	// Size of the bitmap, including the padding
+	int pad;
+	unsigned int generation;
+	unsigned char* bitmap;	// NULL until rasterized
+};
+
 struct FONScontext
 {
 	FONSparams params;
 	float itw,ith;
-	unsigned char* texData;
-	int dirtyRect[4];
+	FONSpage* pages;
+	int npages;
+	int drawPage;
+	unsigned int frame;
+	int evictions;
+	FONSglyphSlot* slots;
+	int slotMask;
+	int nslots;
 	FONSfont** fonts;
-	FONSatlas* atlas;
 	int cfonts;
 	int nfonts;
 	float verts[FONS_VERTEX_COUNT*2];
 	float tcoords[FONS_VERTEX_COUNT*2];
 	unsigned int colors[FONS_VERTEX_COUNT];
 	int nverts;
-	unsigned char* scratch;
-	int nscratch;
+	FONSscratch scratch;
+	void (*submitGlyph)(void* uptr, FONSglyphJob* job);
+	void* submitUptr;
+	int maxPendingFrames;
+	unsigned int generation;	// Bumped by fonsResetAtlas(), which drops pending glyphs
+	int glyphStalls;
 	FONSstate states[FONS_MAX_STATES];
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	// See fonsLock(). The lock is held while lockDepth > 0, lockUrgent counts the threads
+	// waiting in fonsLock().
+	pthread_mutex_t lockMutex;
+	pthread_cond_t lockFree;
+	pthread_t lockOwner;
+	int lockDepth;
+	int lockUrgent;
 };
 
 #ifdef STB_TRUETYPE_IMPLEMENTATION
@@ -453,18 +670,18 @@ struct FONScontext
 static void* fons__tmpalloc(size_t size, void* up)
 {
 	unsigned char* ptr;
-	FONScontext* stash = (FONScontext*)up;
+	FONSscratch* scratch = (FONSscratch*)up;
 
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
-	if (stash->nscratch+(int)size > FONS_SCRATCH_BUF_SIZE) {
-		if (stash->handleError)
-			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, stash->nscratch+(int)size);
+	if (scratch->size+(int)size > FONS_SCRATCH_BUF_SIZE) {
+		if (scratch->stash != NULL && scratch->stash->handleError)
+			scratch->stash->handleError(scratch->stash->errorUptr, FONS_SCRATCH_FULL, scratch->size+(int)size);
 		return NULL;
 	}
-	ptr = stash->scratch + stash->nscratch;
-	stash->nscratch += (int)size;
+	ptr = scratch->data + scratch->size;
+	scratch->size += (int)size;
 	return ptr;
 }
 
@@ -475,6 +692,11 @@ static void fons__tmpfree(void* ptr, void* up)
 	// empty
 }
 
+static FONSscratch* fons__stashScratch(FONScontext* stash)
+{
+	return &stash->scratch;
+}
+
 #endif // STB_TRUETYPE_IMPLEMENTATION
 
 // Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
@@ -698,25 +920,226 @@ static int fons__atlasAddRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry
 	return 1;
 }
 
+static void fons__clearDirtyRect(FONScontext* stash, FONSpage* page)
+{
+	page->dirtyRect[0] = stash->params.width;
+	page->dirtyRect[1] = stash->params.height;
+	page->dirtyRect[2] = 0;
+	page->dirtyRect[3] = 0;
+}
+
+static void fons__addDirtyRect(FONSpage* page, int x0, int y0, int x1, int y1)
+{
+	page->dirtyRect[0] = fons__mini(page->dirtyRect[0], x0);
+	page->dirtyRect[1] = fons__mini(page->dirtyRect[1], y0);
+	page->dirtyRect[2] = fons__maxi(page->dirtyRect[2], x1);
+	page->dirtyRect[3] = fons__maxi(page->dirtyRect[3], y1);
+}
+
 static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 {
 	int x, y, gx, gy;
 	unsigned char* dst;
-	if (fons__atlasAddRect(stash->atlas, w, h, &gx, &gy) == 0)
+	FONSpage* page = &stash->pages[0];
+	if (page->texData == NULL || fons__atlasAddRect(page->atlas, w, h, &gx, &gy) == 0)
 		return;
 
 	// Rasterize
-	dst = &stash->texData[gx + gy * stash->params.width];
+	dst = &page->texData[gx + gy * stash->params.width];
 	for (y = 0; y < h; y++) {
 		for (x = 0; x < w; x++)
 			dst[x] = 0xff;
 		dst += stash->params.width;
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], gx);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], gy);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], gx+w);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], gy+h);
+	fons__addDirtyRect(page, gx, gy, gx+w, gy+h);
+}
+
+static void fons__releasePage(FONSpage* page)
+{
+	if (page->atlas) fons__deleteAtlas(page->atlas);
+	if (page->texData) free(page->texData);
+	page->atlas = NULL;
+	page->texData = NULL;
+}
+
+// Allocates an empty page in the first free slot, or returns -1.
+static int fons__allocPage(FONScontext* stash, int sdf)
+{
+	int i, w = stash->params.width, h = stash->params.height;
+	FONSpage* page;
+	for (i = 0; i < stash->npages; i++) {
+		if (stash->pages[i].texData == NULL)
+			break;
+	}
+	if (i == stash->npages) {
+		FONSpage* pages = (FONSpage*)realloc(stash->pages, sizeof(FONSpage) * (stash->npages+1));
+		if (pages == NULL) return -1;
+		stash->pages = pages;
+		memset(&stash->pages[stash->npages++], 0, sizeof(FONSpage));
+	}
+	page = &stash->pages[i];
+	page->atlas = fons__allocAtlas(w, h, FONS_INIT_ATLAS_NODES);
+	page->texData = (unsigned char*)calloc(w * h, 1);
+	if (page->atlas == NULL || page->texData == NULL) {
+		fons__releasePage(page);
+		return -1;
+	}
+	fons__clearDirtyRect(stash, page);
+	page->lastUsed = stash->frame;
+	page->sdf = sdf;
+	if (i == 0 && !sdf) {
+		// Add white rect at 0,0 for debug drawing.
+		fons__addWhiteRect(stash, 2,2);
+	}
+	return i;
+}
+
+// Drops the bitmaps of all glyphs in the page and clears it.
+static void fons__evictPage(FONScontext* stash, int i)
+{
+	int j, k;
+	FONSpage* page = &stash->pages[i];
+	for (j = 0; j < stash->nfonts; j++) {
+		FONSfont* font = stash->fonts[j];
+		for (k = 0; k < font->nglyphs; k++) {
+			FONSglyph* glyph = &font->glyphs[k];
+			if (glyph->page != i) continue;
+			// Keep the size of the glyph box, which measuring uses.
+			glyph->x1 = (short)(glyph->x1 - glyph->x0 - 1);
+			glyph->y1 = (short)(glyph->y1 - glyph->y0 - 1);
+			glyph->x0 = -1;
+			glyph->y0 = -1;
+			glyph->page = -1;
+		}
+	}
+	fons__atlasReset(page->atlas, stash->params.width, stash->params.height);
+	memset(page->texData, 0, stash->params.width * stash->params.height);
+	page->dirtyRect[0] = 0;
+	page->dirtyRect[1] = 0;
+	page->dirtyRect[2] = stash->params.width;
+	page->dirtyRect[3] = stash->params.height;
+	page->lastUsed = stash->frame;
+	stash->evictions++;
+	if (i == 0 && !page->sdf)
+		fons__addWhiteRect(stash, 2,2);
+}
+
+// Returns the least recently used page that was not used in the current frame, or -1.
+static int fons__leastRecentlyUsedPage(FONScontext* stash)
+{
+	int i, lru = -1;
+	for (i = 0; i < stash->npages; i++) {
+		FONSpage* page = &stash->pages[i];
+		if (page->texData == NULL || page->lastUsed == stash->frame)
+			continue;
+		if (lru == -1 || page->lastUsed - stash->pages[lru].lastUsed > 0x80000000u)
+			lru = i;
+	}
+	return lru;
+}
+
+static int fons__livePages(FONScontext* stash)
+{
+	int i, n = 0;
+	for (i = 0; i < stash->npages; i++)
+		n += stash->pages[i].texData != NULL;
+	return n;
+}
+
+// Finds room for a rectangle in the pages of the atlas that hold coverage or signed distance
+// fields, as given by sdf. When they are full, a page is added while there are less than the
+// maximum, otherwise the least recently used one of either kind is evicted.
+static int fons__atlasAllocRect(FONScontext* stash, int w, int h, int sdf, int* page, int* x, int* y)
+{
+	int i;
+	for (i = 0; i < stash->npages; i++) {
+		FONSpage* p = &stash->pages[i];
+		if (p->texData != NULL && p->sdf == sdf && fons__atlasAddRect(p->atlas, w, h, x, y)) {
+			*page = i;
+			return 1;
+		}
+	}
+	if (fons__livePages(stash) < stash->params.maxPages) {
+		i = fons__allocPage(stash, sdf);
+	} else if ((i = fons__leastRecentlyUsedPage(stash)) != -1) {
+		stash->pages[i].sdf = sdf;
+		fons__evictPage(stash, i);
+	}
+	if (i == -1 || fons__atlasAddRect(stash->pages[i].atlas, w, h, x, y) == 0)
+		return 0;
+	*page = i;
+	return 1;
+}
+
+static unsigned int fons__glyphHash(int font, unsigned int codepoint, short isize, short iblur)
+{
+	return fons__hashint(codepoint ^ ((unsigned int)font << 24)) ^
+		   fons__hashint(((unsigned int)(unsigned short)isize << 16) | (unsigned short)iblur);
+}
+
+// Returns the slot of the glyph, or the empty slot to insert it into.
+static int fons__findGlyphSlot(FONScontext* stash, int font, unsigned int codepoint, short isize, short iblur)
+{
+	int i = (int)(fons__glyphHash(font, codepoint, isize, iblur) & (unsigned int)stash->slotMask);
+	for (;;) {
+		FONSglyphSlot* slot = &stash->slots[i];
+		if (slot->font == -1 ||
+			(slot->codepoint == codepoint && slot->font == font && slot->size == isize && slot->blur == iblur))
+			return i;
+		i = (i+1) & stash->slotMask;
+	}
+}
+
+static int fons__allocGlyphSlots(FONScontext* stash, int size)
+{
+	int i;
+	FONSglyphSlot* slots = (FONSglyphSlot*)malloc(sizeof(FONSglyphSlot) * size);
+	if (slots == NULL) return 0;
+	for (i = 0; i < size; i++)
+		slots[i].font = -1;
+	if (stash->slots) free(stash->slots);
+	stash->slots = slots;
+	stash->slotMask = size-1;
+	stash->nslots = 0;
+	return 1;
+}
+
+// Adds a glyph to the table, keeping it at most half full.
+static int fons__insertGlyph(FONScontext* stash, FONSfont* font, int glyph)
+{
+	FONSglyph* g = &font->glyphs[glyph];
+	FONSglyphSlot* slot;
+	if ((stash->nslots+1)*2 > stash->slotMask+1) {
+		FONSglyphSlot* old = stash->slots;
+		int i, size = stash->slotMask+1;
+		stash->slots = NULL;
+		if (!fons__allocGlyphSlots(stash, size*2)) {
+			stash->slots = old;
+			return 0;
+		}
+		for (i = 0; i < size; i++) {
+			if (old[i].font != -1) {
+				stash->slots[fons__findGlyphSlot(stash, old[i].font, old[i].codepoint, old[i].size, old[i].blur)] = old[i];
+				stash->nslots++;
+			}
+		}
+		free(old);
+	}
+	slot = &stash->slots[fons__findGlyphSlot(stash, font->id, g->codepoint, g->size, g->blur)];
+	slot->codepoint = g->codepoint;
+	slot->size = g->size;
+	slot->blur = g->blur;
+	slot->font = font->id;
+	slot->glyph = glyph;
+	stash->nslots++;
+	return 1;
+}
+
+static FONSglyph* fons__findGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint, short isize, short iblur)
+{
+	FONSglyphSlot* slot = &stash->slots[fons__findGlyphSlot(stash, font->id, codepoint, isize, iblur)];
+	return slot->font == -1 ? NULL : &font->glyphs[slot->glyph];
 }
 
 FONScontext* fonsCreateInternal(FONSparams* params)
@@ -728,11 +1151,15 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	if (stash == NULL) goto error;
 	memset(stash, 0, sizeof(FONScontext));
 
+	pthread_mutex_init(&stash->lockMutex, NULL);
+	pthread_cond_init(&stash->lockFree, NULL);
+
 	stash->params = *params;
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
-	if (stash->scratch == NULL) goto error;
+	stash->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	if (stash->scratch.data == NULL) goto error;
+	stash->scratch.stash = stash;
 
 	// Initialize implementation library
 	if (!fons__tt_init(stash)) goto error;
@@ -742,8 +1169,9 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 			goto error;
 	}
 
-	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
-	if (stash->atlas == NULL) goto error;
+	if (stash->params.maxPages <= 0)
+		stash->params.maxPages = FONS_DEFAULT_MAX_PAGES;
+	if (!fons__allocGlyphSlots(stash, FONS_INIT_GLYPH_SLOTS)) goto error;
 
 	// Allocate space for fonts.
 	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
@@ -752,20 +1180,10 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	stash->cfonts = FONS_INIT_FONTS;
 	stash->nfonts = 0;
 
-	// Create texture for the cache.
+	// Create the first page of the cache.
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
-	stash->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
-	if (stash->texData == NULL) goto error;
-	memset(stash->texData, 0, stash->params.width * stash->params.height);
-
-	stash->dirtyRect[0] = stash->params.width;
-	stash->dirtyRect[1] = stash->params.height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
-
-	// Add white rect at 0,0 for debug drawing.
-	fons__addWhiteRect(stash, 2,2);
+	if (fons__allocPage(stash, 0) == -1) goto error;
 
 	fonsPushState(stash);
 	fonsClearState(stash);
@@ -785,13 +1203,87 @@ static FONSstate* fons__getState(FONScontext* stash)
 int fonsAddFallbackFont(FONScontext* stash, int base, int fallback)
 {
 	FONSfont* baseFont = stash->fonts[base];
+	int i;
 	if (baseFont->nfallbacks < FONS_MAX_FALLBACKS) {
 		baseFont->fallbacks[baseFont->nfallbacks++] = fallback;
+		// Codepoints that the chain lacked so far may resolve to the new fallback.
+		if (baseFont->nresolved > 0) {
+			for (i = 0; i <= baseFont->resolvedMask; i++)
+				baseFont->resolved[i].font = -1;
+			baseFont->nresolved = 0;
+		}
 		return 1;
 	}
 	return 0;
 }
 
+// Returns the slot of the codepoint, or the empty slot to insert it into.
+static FONSresolved* fons__findResolved(FONSfont* font, unsigned int codepoint)
+{
+	int i = (int)(fons__hashint(codepoint) & (unsigned int)font->resolvedMask);
+	while (font->resolved[i].font != -1 && font->resolved[i].codepoint != codepoint)
+		i = (i+1) & font->resolvedMask;
+	return &font->resolved[i];
+}
+
+// Grows the table of resolved codepoints to size slots.
+static int fons__growResolved(FONSfont* font, int size)
+{
+	FONSresolved* old = font->resolved;
+	int i, oldSize = old != NULL ? font->resolvedMask+1 : 0;
+	FONSresolved* resolved = (FONSresolved*)malloc(sizeof(FONSresolved) * size);
+	if (resolved == NULL) return 0;
+	for (i = 0; i < size; i++)
+		resolved[i].font = -1;
+	font->resolved = resolved;
+	font->resolvedMask = size-1;
+	for (i = 0; i < oldSize; i++) {
+		if (old[i].font != -1)
+			*fons__findResolved(font, old[i].codepoint) = old[i];
+	}
+	free(old);
+	return 1;
+}
+
+// Returns the glyph index of the codepoint in the first font of the chain of font that has
+// it, or 0 with the font itself if none has. The answer is kept for the next lookup.
+static int fons__resolveGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint, FONSfont** renderFont)
+{
+	FONSresolved* slot = NULL;
+	int i, g;
+
+	if (font->resolved != NULL || fons__growResolved(font, 256)) {
+		slot = fons__findResolved(font, codepoint);
+		if (slot->font != -1) {
+			*renderFont = stash->fonts[slot->font];
+			return slot->index;
+		}
+	}
+
+	*renderFont = font;
+	g = fons__tt_getGlyphIndex(&font->font, codepoint);
+	for (i = 0; g == 0 && i < font->nfallbacks; ++i) {
+		FONSfont* fallbackFont = stash->fonts[font->fallbacks[i]];
+		int fallbackIndex = fons__tt_getGlyphIndex(&fallbackFont->font, codepoint);
+		if (fallbackIndex != 0) {
+			g = fallbackIndex;
+			*renderFont = fallbackFont;
+		}
+	}
+
+	// Keep the table at most half full, the answer is simply not kept if it can not grow.
+	if (slot != NULL && (font->nresolved+1)*2 > font->resolvedMask+1) {
+		slot = fons__growResolved(font, (font->resolvedMask+1)*2) ? fons__findResolved(font, codepoint) : NULL;
+	}
+	if (slot != NULL) {
+		slot->codepoint = codepoint;
+		slot->font = (*renderFont)->id;
+		slot->index = g;
+		font->nresolved++;
+	}
+	return g;
+}
+
 void fonsSetSize(FONScontext* stash, float size)
 {
 	fons__getState(stash)->size = size;
@@ -812,6 +1304,11 @@ void fonsSetBlur(FONScontext* stash, float blur)
 	fons__getState(stash)->blur = blur;
 }
 
+void fonsSetSDF(FONScontext* stash, int enabled)
+{
+	fons__getState(stash)->sdf = enabled;
+}
+
 void fonsSetAlign(FONScontext* stash, int align)
 {
 	fons__getState(stash)->align = align;
@@ -852,6 +1349,7 @@ void fonsClearState(FONScontext* stash)
 	state->font = 0;
 	state->blur = 0;
 	state->spacing = 0;
+	state->sdf = 0;
 	state->align = FONS_ALIGN_LEFT | FONS_ALIGN_BASELINE;
 }
 
@@ -859,6 +1357,8 @@ static void fons__freeFont(FONSfont* font)
 {
 	if (font == NULL) return;
 	if (font->glyphs) free(font->glyphs);
+	if (font->kern) free(font->kern);
+	if (font->resolved) free(font->resolved);
 	if (font->freeData && font->data) free(font->data);
 	free(font);
 }
@@ -880,6 +1380,7 @@ static int fons__allocFont(FONScontext* stash)
 	if (font->glyphs == NULL) goto error;
 	font->cglyphs = FONS_INIT_GLYPHS;
 	font->nglyphs = 0;
+	font->id = stash->nfonts;
 
 	stash->fonts[stash->nfonts++] = font;
 	return stash->nfonts-1;
@@ -918,9 +1419,55 @@ error:
 	return FONS_INVALID;
 }
 
+// Copies the kerning pairs of the font into a hash table, which is faster to query than the font.
+static void fons__buildKernTable(FONSfont* font)
+{
+	int i, n, size, advance;
+	unsigned int pair, j;
+
+	n = fons__tt_getKernPairCount(&font->font);
+	font->nkern = n;
+	if (n <= 0) return;
+
+	// Keep the table at most half full, so that looking up a pair without kerning,
+	// which is the common case, stops after a probe or two.
+	for (size = 16; size < n*2; size *= 2);
+	font->kern = (FONSkernPair*)calloc(size, sizeof(FONSkernPair));
+	if (font->kern == NULL) {
+		font->nkern = -1;
+		return;
+	}
+	font->kernMask = size-1;
+
+	for (i = 0; i < n; i++) {
+		pair = fons__tt_getKernPair(&font->font, i, &advance);
+		if (pair == 0 || advance == 0) continue;
+		for (j = fons__hashint(pair) & font->kernMask; font->kern[j].pair != 0 && font->kern[j].pair != pair; j = (j+1) & font->kernMask);
+		if (font->kern[j].pair == 0) {
+			font->kern[j].pair = pair;
+			font->kern[j].advance = advance;
+		}
+	}
+}
+
+static int fons__getKernAdvance(FONSfont* font, int glyph1, int glyph2)
+{
+	unsigned int pair, i;
+	if (font->nkern == 0)
+		return 0;
+	if (font->nkern < 0)
+		return fons__tt_getGlyphKernAdvance(&font->font, glyph1, glyph2);
+	pair = (unsigned int)glyph1 << 16 | (unsigned int)glyph2;
+	for (i = fons__hashint(pair) & font->kernMask; font->kern[i].pair != 0; i = (i+1) & font->kernMask) {
+		if (font->kern[i].pair == pair)
+			return font->kern[i].advance;
+	}
+	return 0;
+}
+
 int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, int dataSize, int freeData)
 {
-	int i, ascent, descent, fh, lineGap;
+	int ascent, descent, fh, lineGap;
 	FONSfont* font;
 
 	int idx = fons__allocFont(stash);
@@ -932,17 +1479,13 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	strncpy(font->name, name, sizeof(font->name));
 	font->name[sizeof(font->name)-1] = '\0';
 
-	// Init hash lookup.
-	for (i = 0; i < FONS_HASH_LUT_SIZE; ++i)
-		font->lut[i] = -1;
-
 	// Read in the font data.
 	font->dataSize = dataSize;
 	font->data = data;
 	font->freeData = (unsigned char)freeData;
 
 	// Init font
-	stash->nscratch = 0;
+	stash->scratch.size = 0;
 	if (!fons__tt_loadFont(stash, &font->font, data, dataSize)) goto error;
 
 	// Store normalized line height. The real line height is got
@@ -953,6 +1496,8 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->descender = (float)descent / (float)fh;
 	font->lineh = (float)(fh + lineGap) / (float)fh;
 
+	fons__buildKernTable(font);
+
 	return idx;
 
 error:
@@ -971,6 +1516,32 @@ int fonsGetFontByName(FONScontext* s, const char* name)
 	return FONS_INVALID;
 }
 
+int fonsResolveText(FONScontext* stash, const char* str, const char* end)
+{
+	FONSstate* state = fons__getState(stash);
+	unsigned int codepoint;
+	unsigned int utf8state = 0;
+	FONSfont* font;
+	FONSfont* renderFont;
+	int missing = 0;
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	font = stash->fonts[state->font];
+	if (font->data == NULL) return 0;
+
+	if (end == NULL)
+		end = str + strlen(str);
+
+	for (; str != end; ++str) {
+		if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
+			continue;
+		if (fons__resolveGlyph(stash, font, codepoint, &renderFont) == 0)
+			missing++;
+	}
+	return missing;
+}
+
 
 static FONSglyph* fons__allocGlyph(FONSfont* font)
 {
@@ -1049,17 +1620,176 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+#define FONS_SDF_INF 1e20f
+
+// Squared Euclidean distance transform of n samples of the grid, which are stride apart,
+// after Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions".
+static void fons__edt1d(float* grid, int stride, int n, float* f, float* d, int* v, float* z)
+{
+	int q, k = 0;
+	float s;
+	for (q = 0; q < n; q++)
+		f[q] = grid[q*stride];
+	v[0] = 0;
+	z[0] = -FONS_SDF_INF;
+	z[1] = FONS_SDF_INF;
+	for (q = 1; q < n; q++) {
+		s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+		while (s <= z[k]) {
+			k--;
+			s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = FONS_SDF_INF;
+	}
+	for (q = 0, k = 0; q < n; q++) {
+		while (z[k+1] < q)
+			k++;
+		d[q] = (q - v[k])*(q - v[k]) + f[v[k]];
+	}
+	for (q = 0; q < n; q++)
+		grid[q*stride] = d[q];
+}
+
+static void fons__edt(float* grid, int w, int h, float* f, float* d, int* v, float* z)
+{
+	int x, y;
+	for (x = 0; x < w; x++)
+		fons__edt1d(&grid[x], w, h, f, d, v, z);
+	for (y = 0; y < h; y++)
+		fons__edt1d(&grid[y*w], 1, w, f, d, v, z);
+}
+
+// Rasterizes the glyph FONS_SDF_UPSAMPLE times larger than the distance field of w*h pixels,
+// whose top left corner is at x0,y0, and stores the signed distance to its outline at the
+// center of each pixel, 128 on the outline and larger inside.
+static int fons__renderGlyphSDF(FONSttFontImpl* font, int g, float scale,
+								int x0, int y0, int w, int h, unsigned char* dst, int dstStride)
+{
+	const int up = FONS_SDF_UPSAMPLE;
+	int hx0, hy0, hx1, hy1, advance, lsb, i, x, y, sx, sy;
+	int hw = w*up, hh = h*up, n = fons__maxi(hw, hh);
+	unsigned char* coverage = (unsigned char*)calloc(hw*hh, 1);
+	float* outside = (float*)malloc(sizeof(float) * hw*hh);
+	float* inside = (float*)malloc(sizeof(float) * hw*hh);
+	float* f = (float*)malloc(sizeof(float) * (3*n+1));
+	int* v = (int*)malloc(sizeof(int) * n);
+	int ok = coverage != NULL && outside != NULL && inside != NULL && f != NULL && v != NULL;
+
+	if (ok) {
+		fons__tt_buildGlyphBitmap(font, g, FONS_SDF_SIZE*up, scale*up, &advance, &lsb, &hx0, &hy0, &hx1, &hy1);
+		fons__tt_renderGlyphBitmap(font, &coverage[(hx0 - x0*up) + (hy0 - y0*up) * hw],
+								   hx1-hx0, hy1-hy0, hw, scale*up, scale*up, g);
+
+		// Squared distances to the nearest pixel inside and outside of the outline
+		for (i = 0; i < hw*hh; i++) {
+			outside[i] = coverage[i] >= 128 ? 0.0f : FONS_SDF_INF;
+			inside[i] = coverage[i] >= 128 ? FONS_SDF_INF : 0.0f;
+		}
+		fons__edt(outside, hw, hh, f, f+n, v, f+2*n);
+		fons__edt(inside, hw, hh, f, f+n, v, f+2*n);
+
+		// Average the 2x2 samples around the center of each pixel
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				float dist = 0.0f;
+				for (sy = y*up + up/2 - 1; sy <= y*up + up/2; sy++) {
+					for (sx = x*up + up/2 - 1; sx <= x*up + up/2; sx++) {
+						i = sx + sy*hw;
+						if (outside[i] > 0.0f)
+							dist += sqrtf(outside[i]) - 0.5f;
+						else
+							dist -= sqrtf(inside[i]) - 0.5f;
+					}
+				}
+				dist = 128.0f - dist / (4.0f*up) * (128.0f / FONS_SDF_PADDING);
+				dst[x + y*dstStride] = (unsigned char)fons__maxi(0, fons__mini(255, (int)(dist + 0.5f)));
+			}
+		}
+	}
+
+	free(coverage);
+	free(outside);
+	free(inside);
+	free(f);
+	free(v);
+	return ok;
+}
+
+// Rasterizes the glyph with box x0,y0 into the w*h pixels at dst, which include an empty border
+// of pad pixels, and blurs it.
+static void fons__rasterizeGlyph(FONSttFontImpl* font, int g, float scale, short iblur,
+								 int x0, int y0, int w, int h, int pad, unsigned char* dst, int dstStride)
+{
+	int x, y;
+
+	if (iblur == FONS_SDF_GLYPH)
+		fons__renderGlyphSDF(font, g, scale, x0, y0, w-pad*2, h-pad*2, &dst[pad + pad*dstStride], dstStride);
+	else
+		fons__tt_renderGlyphBitmap(font, &dst[pad + pad*dstStride], w-pad*2, h-pad*2, dstStride, scale, scale, g);
+
+	// Make sure there is one pixel empty border.
+	for (y = 0; y < h; y++) {
+		dst[y*dstStride] = 0;
+		dst[w-1 + y*dstStride] = 0;
+	}
+	for (x = 0; x < w; x++) {
+		dst[x] = 0;
+		dst[x + (h-1)*dstStride] = 0;
+	}
+
+	// Debug code to color the glyph background
+/*	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			int a = (int)dst[x+y*dstStride] + 20;
+			if (a > 255) a = 255;
+			dst[x+y*dstStride] = a;
+		}
+	}*/
+
+	// Blur
+	if (iblur > 0)
+		fons__blur(NULL, dst, w, h, dstStride, iblur);
+}
+
+static FONSglyphJob* fons__newGlyphJob(FONScontext* stash, FONSfont* font, FONSfont* renderFont,
+									   unsigned int codepoint, short isize, short iblur,
+									   int g, float scale, int x0, int y0, int gw, int gh, int pad)
+{
+	FONSglyphJob* job = (FONSglyphJob*)malloc(sizeof(FONSglyphJob));
+	if (job == NULL) return NULL;
+	memset(job, 0, sizeof(FONSglyphJob));
+	job->font = renderFont->font;
+#ifndef FONS_USE_FREETYPE
+	job->font.font.userdata = &job->scratch;
+#endif
+	job->fontId = font->id;
+	job->codepoint = codepoint;
+	job->isize = isize;
+	job->iblur = iblur;
+	job->index = g;
+	job->scale = scale;
+	job->x0 = x0;
+	job->y0 = y0;
+	job->width = gw;
+	job->height = gh;
+	job->pad = pad;
+	job->generation = stash->generation;
+	return job;
+}
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur, int bitmapOption)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	int g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, gp;
 	float scale;
 	FONSglyph* glyph = NULL;
-	unsigned int h;
+	FONSglyphJob* job = NULL;
+	FONSpage* page;
 	float size = isize/10.0f;
 	int pad, added;
-	unsigned char* bdst;
-	unsigned char* dst;
 	FONSfont* renderFont = font;
 
 	if (isize < 2) return NULL;
@@ -1067,56 +1797,62 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	pad = iblur+2;
 
 	// Reset allocator.
-	stash->nscratch = 0;
+	stash->scratch.size = 0;
 
 	// Find code point and size.
-	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
-	i = font->lut[h];
-	while (i != -1) {
-		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur) {
-			glyph = &font->glyphs[i];
-			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
-			  return glyph;
-			}
-			// At this point, glyph exists but the bitmap data is not yet created.
-			break;
+	glyph = fons__findGlyph(stash, font, codepoint, isize, iblur);
+	if (glyph != NULL) {
+		if (glyph->page >= 0) {
+			if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED)
+				stash->pages[glyph->page].lastUsed = stash->frame;
+			return glyph;
 		}
-		i = font->glyphs[i].next;
+		if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL)
+			return glyph;
+		// Wait for the glyph job, unless it took too long.
+		if (glyph->page == FONS_GLYPH_PENDING && stash->frame - glyph->requested < (unsigned int)stash->maxPendingFrames)
+			return glyph;
+		// At this point, glyph exists but the bitmap data is not yet created.
 	}
 
-	// Create a new glyph or rasterize bitmap data for a cached glyph.
-	g = fons__tt_getGlyphIndex(&font->font, codepoint);
-	// Try to find the glyph in fallback fonts.
-	if (g == 0) {
-		for (i = 0; i < font->nfallbacks; ++i) {
-			FONSfont* fallbackFont = stash->fonts[font->fallbacks[i]];
-			int fallbackIndex = fons__tt_getGlyphIndex(&fallbackFont->font, codepoint);
-			if (fallbackIndex != 0) {
-				g = fallbackIndex;
-				renderFont = fallbackFont;
-				break;
-			}
-		}
-		// It is possible that we did not find a fallback glyph.
-		// In that case the glyph index 'g' is 0, and we'll proceed below and cache empty glyph.
-	}
+	// Create a new glyph or rasterize bitmap data for a cached glyph. If no font of the chain
+	// has the codepoint, the glyph index 'g' is 0, and we'll proceed below and cache empty glyph.
+	g = fons__resolveGlyph(stash, font, codepoint, &renderFont);
 	scale = fons__tt_getPixelHeightScale(&renderFont->font, size);
 	fons__tt_buildGlyphBitmap(&renderFont->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
+	if (iblur == FONS_SDF_GLYPH) {
+		// The distance field reaches beyond the outline, and has a one pixel empty border.
+		x0 -= FONS_SDF_PADDING;
+		y0 -= FONS_SDF_PADDING;
+		x1 += FONS_SDF_PADDING;
+		y1 += FONS_SDF_PADDING;
+		pad = 1;
+	}
 	gw = x1-x0 + pad*2;
 	gh = y1-y0 + pad*2;
 
+	// Hand new glyphs to the glyph rasterizer, if any.
+	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED && stash->submitGlyph != NULL &&
+		(glyph == NULL || glyph->page != FONS_GLYPH_PENDING))
+		job = fons__newGlyphJob(stash, font, renderFont, codepoint, isize, iblur, g, scale, x0, y0, gw, gh, pad);
+
 	// Determines the spot to draw glyph in the atlas.
-	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED) {
-		// Find free spot for the rect in the atlas
-		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+	if (job != NULL) {
+		gp = FONS_GLYPH_PENDING;
+		gx = -1;
+		gy = -1;
+	} else if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED) {
+		// Find free spot for the rect in the atlas, evicting a page if needed
+		added = fons__atlasAllocRect(stash, gw, gh, iblur == FONS_SDF_GLYPH, &gp, &gx, &gy);
 		if (added == 0 && stash->handleError != NULL) {
-			// Atlas is full, let the user to resize the atlas (or not), and try again.
+			// All pages were used in this frame, let the user to raise the limit (or not), and try again.
 			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
-			added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+			added = fons__atlasAllocRect(stash, gw, gh, iblur == FONS_SDF_GLYPH, &gp, &gx, &gy);
 		}
 		if (added == 0) return NULL;
 	} else {
 		// Negative coordinate indicates there is no bitmap data created.
+		gp = -1;
 		gx = -1;
 		gy = -1;
 	}
@@ -1124,16 +1860,23 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	// Init glyph.
 	if (glyph == NULL) {
 		glyph = fons__allocGlyph(font);
+		if (glyph == NULL) {
+			fonsDeleteGlyphJob(job);
+			return NULL;
+		}
 		glyph->codepoint = codepoint;
 		glyph->size = isize;
 		glyph->blur = iblur;
-		glyph->next = 0;
 
 		// Insert char to hash lookup.
-		glyph->next = font->lut[h];
-		font->lut[h] = font->nglyphs-1;
+		if (!fons__insertGlyph(stash, font, font->nglyphs-1)) {
+			font->nglyphs--;
+			fonsDeleteGlyphJob(job);
+			return NULL;
+		}
 	}
 	glyph->index = g;
+	glyph->page = (short)gp;
 	glyph->x0 = (short)gx;
 	glyph->y0 = (short)gy;
 	glyph->x1 = (short)(glyph->x0+gw);
@@ -1146,42 +1889,19 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		return glyph;
 	}
 
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
-
-	// Make sure there is one pixel empty border.
-	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		dst[y*stash->params.width] = 0;
-		dst[gw-1 + y*stash->params.width] = 0;
-	}
-	for (x = 0; x < gw; x++) {
-		dst[x] = 0;
-		dst[x + (gh-1)*stash->params.width] = 0;
-	}
-
-	// Debug code to color the glyph background
-/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		for (x = 0; x < gw; x++) {
-			int a = (int)fdst[x+y*stash->params.width] + 20;
-			if (a > 255) a = 255;
-			fdst[x+y*stash->params.width] = a;
-		}
-	}*/
-
-	// Blur
-	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
+	if (job != NULL) {
+		glyph->requested = stash->frame;
+		stash->submitGlyph(stash->submitUptr, job);
+		return glyph;
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+	// Rasterize
+	stash->glyphStalls++;
+	page = &stash->pages[gp];
+	page->lastUsed = stash->frame;
+	fons__rasterizeGlyph(&renderFont->font, g, scale, iblur, x0, y0, gw, gh, pad,
+						 &page->texData[glyph->x0 + glyph->y0 * stash->params.width], stash->params.width);
+	fons__addDirtyRect(page, glyph->x0, glyph->y0, glyph->x1, glyph->y1);
 
 	return glyph;
 }
@@ -1193,7 +1913,7 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
 
 	if (prevGlyphIndex != -1) {
-		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
+		float adv = fons__getKernAdvance(font, prevGlyphIndex, glyph->index) * scale;
 		*x += (int)(adv + spacing + 0.5f);
 	}
 
@@ -1238,23 +1958,61 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	*x += (int)(glyph->xadv / 10.0f + 0.5f);
 }
 
+// Places the glyph as fons__getQuad() does, but draws it from the distance field,
+// which is scaled to the size of the text.
+static void fons__getSDFQuad(FONScontext* stash, FONSfont* font,
+							 int prevGlyphIndex, FONSglyph* glyph, FONSglyph* field, short isize,
+							 float scale, float spacing, float* x, float* y, FONSquad* q)
+{
+	float s = isize / (FONS_SDF_SIZE*10.0f), x0, y0, x1, y1;
+
+	if (prevGlyphIndex != -1) {
+		float adv = fons__getKernAdvance(font, prevGlyphIndex, glyph->index) * scale;
+		*x += (int)(adv + spacing + 0.5f);
+	}
+
+	// Inset by the empty border.
+	x0 = (float)(field->x0+1);
+	y0 = (float)(field->y0+1);
+	x1 = (float)(field->x1-1);
+	y1 = (float)(field->y1-1);
+
+	q->x0 = *x + (field->xoff+1)*s;
+	q->x1 = q->x0 + (x1 - x0)*s;
+	if (stash->params.flags & FONS_ZERO_TOPLEFT) {
+		q->y0 = *y + (field->yoff+1)*s;
+		q->y1 = q->y0 + (y1 - y0)*s;
+	} else {
+		q->y0 = *y - (field->yoff+1)*s;
+		q->y1 = q->y0 - (y1 - y0)*s;
+	}
+
+	q->s0 = x0 * stash->itw;
+	q->t0 = y0 * stash->ith;
+	q->s1 = x1 * stash->itw;
+	q->t1 = y1 * stash->ith;
+
+	*x += (int)(glyph->xadv / 10.0f + 0.5f);
+}
+
 static void fons__flush(FONScontext* stash)
 {
-	// Flush texture
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		if (stash->params.renderUpdate != NULL)
-			stash->params.renderUpdate(stash->params.userPtr, stash->dirtyRect, stash->texData);
-		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+	int i;
+
+	// Flush textures
+	for (i = 0; i < stash->npages; i++) {
+		FONSpage* page = &stash->pages[i];
+		if (page->dirtyRect[0] < page->dirtyRect[2] && page->dirtyRect[1] < page->dirtyRect[3]) {
+			if (stash->params.renderUpdate != NULL)
+				stash->params.renderUpdate(stash->params.userPtr, i, page->dirtyRect, page->texData);
+			fons__clearDirtyRect(stash, page);
+		}
 	}
 
 	// Flush triangles
 	if (stash->nverts > 0) {
 		if (stash->params.renderDraw != NULL)
-			stash->params.renderDraw(stash->params.userPtr, stash->verts, stash->tcoords, stash->colors, stash->nverts);
+			stash->params.renderDraw(stash->params.userPtr, stash->drawPage, stash->verts, stash->tcoords, stash->colors, stash->nverts);
 		stash->nverts = 0;
 	}
 }
@@ -1340,9 +2098,11 @@ float fonsDrawText(FONScontext* stash,
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph != NULL) {
 			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
-
-			if (stash->nverts+6 > FONS_VERTEX_COUNT)
+		}
+		if (glyph != NULL && glyph->page >= 0) {
+			if (stash->nverts+6 > FONS_VERTEX_COUNT || (stash->nverts > 0 && glyph->page != stash->drawPage))
 				fons__flush(stash);
+			stash->drawPage = glyph->page;
 
 			fons__vertex(stash, q.x0, q.y0, q.s0, q.t0, state->color);
 			fons__vertex(stash, q.x1, q.y1, q.s1, q.t1, state->color);
@@ -1400,6 +2160,8 @@ int fonsTextIterInit(FONScontext* stash, FONStextIter* iter,
 	iter->end = end;
 	iter->codepoint = 0;
 	iter->prevGlyphIndex = -1;
+	iter->page = -1;
+	iter->sdf = state->sdf && bitmapOption == FONS_GLYPH_BITMAP_REQUIRED && iter->iblur == 0;
 	iter->bitmapOption = bitmapOption;
 
 	return 1;
@@ -1408,6 +2170,7 @@ int fonsTextIterInit(FONScontext* stash, FONStextIter* iter,
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 {
 	FONSglyph* glyph = NULL;
+	FONSglyph* field = NULL;
 	const char* str = iter->next;
 	iter->str = iter->next;
 
@@ -1421,11 +2184,24 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		// Get glyph and quad
 		iter->x = iter->nextx;
 		iter->y = iter->nexty;
-		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
-		// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
-		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+		if (iter->sdf) {
+			// Metrics of the glyph at its size, so that text is laid out as measured.
+			glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, FONS_GLYPH_BITMAP_OPTIONAL);
+			if (glyph != NULL)
+				field = fons__getGlyph(stash, iter->font, iter->codepoint, FONS_SDF_SIZE*10, FONS_SDF_GLYPH, FONS_GLYPH_BITMAP_REQUIRED);
+			if (field != NULL)
+				fons__getSDFQuad(stash, iter->font, iter->prevGlyphIndex, glyph, field, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			else
+				glyph = NULL;
+		} else {
+			glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
+			// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
+			if (glyph != NULL)
+				fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			field = glyph;
+		}
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
+		iter->page = field != NULL ? field->page : -1;
 		break;
 	}
 	iter->next = str;
@@ -1440,9 +2216,14 @@ void fonsDrawDebug(FONScontext* stash, float x, float y)
 	int h = stash->params.height;
 	float u = w == 0 ? 0 : (1.0f / w);
 	float v = h == 0 ? 0 : (1.0f / h);
+	FONSatlas* atlas = stash->pages[0].atlas;
 
-	if (stash->nverts+6+6 > FONS_VERTEX_COUNT)
+	// Draws the first page, which has the white rect.
+	if (atlas == NULL)
+		return;
+	if (stash->nverts+6+6 > FONS_VERTEX_COUNT || (stash->nverts > 0 && stash->drawPage != 0))
 		fons__flush(stash);
+	stash->drawPage = 0;
 
 	// Draw background
 	fons__vertex(stash, x+0, y+0, u, v, 0x0fffffff);
@@ -1463,8 +2244,8 @@ void fonsDrawDebug(FONScontext* stash, float x, float y)
 	fons__vertex(stash, x+w, y+h, 1, 1, 0xffffffff);
 
 	// Drawbug draw atlas
-	for (i = 0; i < stash->atlas->nnodes; i++) {
-		FONSatlasNode* n = &stash->atlas->nodes[i];
+	for (i = 0; i < atlas->nnodes; i++) {
+		FONSatlasNode* n = &atlas->nodes[i];
 
 		if (stash->nverts+6 > FONS_VERTEX_COUNT)
 			fons__flush(stash);
@@ -1602,32 +2383,153 @@ void fonsLineBounds(FONScontext* stash, float y, float* miny, float* maxy)
 	}
 }
 
-const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height)
+const unsigned char* fonsGetTextureData(FONScontext* stash, int page, int* width, int* height)
 {
 	if (width != NULL)
 		*width = stash->params.width;
 	if (height != NULL)
 		*height = stash->params.height;
-	return stash->texData;
+	if (page < 0 || page >= stash->npages)
+		return NULL;
+	return stash->pages[page].texData;
 }
 
-int fonsValidateTexture(FONScontext* stash, int* dirty)
+int fonsValidateTexture(FONScontext* stash, int page, int* dirty)
 {
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		dirty[0] = stash->dirtyRect[0];
-		dirty[1] = stash->dirtyRect[1];
-		dirty[2] = stash->dirtyRect[2];
-		dirty[3] = stash->dirtyRect[3];
+	FONSpage* p;
+	if (page < 0 || page >= stash->npages)
+		return 0;
+	p = &stash->pages[page];
+	if (p->dirtyRect[0] < p->dirtyRect[2] && p->dirtyRect[1] < p->dirtyRect[3]) {
+		dirty[0] = p->dirtyRect[0];
+		dirty[1] = p->dirtyRect[1];
+		dirty[2] = p->dirtyRect[2];
+		dirty[3] = p->dirtyRect[3];
 		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+		fons__clearDirtyRect(stash, p);
 		return 1;
 	}
 	return 0;
 }
 
+void fonsBeginFrame(FONScontext* stash)
+{
+	if (stash == NULL) return;
+	stash->frame++;
+}
+
+void fonsTouchPage(FONScontext* stash, int page)
+{
+	if (stash == NULL || page < 0 || page >= stash->npages) return;
+	stash->pages[page].lastUsed = stash->frame;
+}
+
+void fonsSetMaxPages(FONScontext* stash, int maxPages)
+{
+	int i;
+	if (stash == NULL) return;
+	stash->params.maxPages = fons__maxi(maxPages, 1);
+	while (fons__livePages(stash) > stash->params.maxPages) {
+		if ((i = fons__leastRecentlyUsedPage(stash)) == -1)
+			break;
+		fons__evictPage(stash, i);
+		fons__releasePage(&stash->pages[i]);
+	}
+}
+
+int fonsGetPageCount(FONScontext* stash)
+{
+	return stash != NULL ? stash->npages : 0;
+}
+
+int fonsIsSDFPage(FONScontext* stash, int page)
+{
+	if (stash == NULL || page < 0 || page >= stash->npages) return 0;
+	return stash->pages[page].sdf;
+}
+
+int fonsGetEvictionCount(FONScontext* stash)
+{
+	return stash != NULL ? stash->evictions : 0;
+}
+
+int fonsSetGlyphRasterizer(FONScontext* stash, void (*submit)(void* uptr, FONSglyphJob* job), void* uptr, int maxPendingFrames)
+{
+	if (stash == NULL) return 0;
+#ifdef FONS_USE_FREETYPE
+	// The glyphs of a face are loaded into its glyph slot, one at a time.
+	if (submit != NULL) return 0;
+#endif
+	stash->submitGlyph = submit;
+	stash->submitUptr = uptr;
+	stash->maxPendingFrames = fons__maxi(maxPendingFrames, 0);
+	return 1;
+}
+
+void fonsRasterizeGlyphJob(FONSglyphJob* job)
+{
+	if (job == NULL || job->bitmap != NULL) return;
+	job->bitmap = (unsigned char*)calloc(job->width * job->height, 1);
+	job->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	if (job->bitmap != NULL && job->scratch.data != NULL)
+		fons__rasterizeGlyph(&job->font, job->index, job->scale, job->iblur, job->x0, job->y0,
+							 job->width, job->height, job->pad, job->bitmap, job->width);
+	free(job->scratch.data);
+	job->scratch.data = NULL;
+}
+
+static int fons__compareJobHeight(const void* a, const void* b)
+{
+	return (*(FONSglyphJob* const*)b)->height - (*(FONSglyphJob* const*)a)->height;
+}
+
+int fonsFinishGlyphJobs(FONScontext* stash, FONSglyphJob** jobs, int njobs)
+{
+	int i, y, gp, gx, gy, added = 0;
+
+	// Tall glyphs first pack tighter into the skyline.
+	qsort(jobs, njobs, sizeof(FONSglyphJob*), fons__compareJobHeight);
+
+	for (i = 0; i < njobs; i++) {
+		FONSglyphJob* job = jobs[i];
+		FONSglyph* glyph = NULL;
+		FONSpage* page;
+		if (job->bitmap != NULL && job->generation == stash->generation &&
+			job->fontId >= 0 && job->fontId < stash->nfonts)
+			glyph = fons__findGlyph(stash, stash->fonts[job->fontId], job->codepoint, job->isize, job->iblur);
+		// The glyph may have been rasterized when drawn in the meantime.
+		if (glyph != NULL && glyph->page == FONS_GLYPH_PENDING &&
+			fons__atlasAllocRect(stash, job->width, job->height, job->iblur == FONS_SDF_GLYPH, &gp, &gx, &gy)) {
+			page = &stash->pages[gp];
+			for (y = 0; y < job->height; y++)
+				memcpy(&page->texData[gx + (gy + y) * stash->params.width], &job->bitmap[y * job->width], job->width);
+			fons__addDirtyRect(page, gx, gy, gx + job->width, gy + job->height);
+			page->lastUsed = stash->frame;
+			glyph->page = (short)gp;
+			glyph->x0 = (short)gx;
+			glyph->y0 = (short)gy;
+			glyph->x1 = (short)(gx + job->width);
+			glyph->y1 = (short)(gy + job->height);
+			added++;
+		}
+		fonsDeleteGlyphJob(job);
+	}
+
+	return added;
+}
+
+void fonsDeleteGlyphJob(FONSglyphJob* job)
+{
+	if (job == NULL) return;
+	free(job->bitmap);
+	free(job);
+}
+
+int fonsGetGlyphStalls(FONScontext* stash)
+{
+	return stash != NULL ? stash->glyphStalls : 0;
+}
+
 void fonsDeleteInternal(FONScontext* stash)
 {
 	int i;
@@ -1639,14 +2541,52 @@ void fonsDeleteInternal(FONScontext* stash)
 	for (i = 0; i < stash->nfonts; ++i)
 		fons__freeFont(stash->fonts[i]);
 
-	if (stash->atlas) fons__deleteAtlas(stash->atlas);
+	for (i = 0; i < stash->npages; ++i)
+		fons__releasePage(&stash->pages[i]);
+	if (stash->pages) free(stash->pages);
+	if (stash->slots) free(stash->slots);
 	if (stash->fonts) free(stash->fonts);
-	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
+	if (stash->scratch.data) free(stash->scratch.data);
+	pthread_cond_destroy(&stash->lockFree);
+	pthread_mutex_destroy(&stash->lockMutex);
 	free(stash);
 	fons__tt_done(stash);
 }
 
+void fonsLock(FONScontext* stash)
+{
+	pthread_mutex_lock(&stash->lockMutex);
+	if (stash->lockDepth > 0 && pthread_equal(stash->lockOwner, pthread_self())) {
+		stash->lockDepth++;
+	} else {
+		stash->lockUrgent++;
+		while (stash->lockDepth > 0)
+			pthread_cond_wait(&stash->lockFree, &stash->lockMutex);
+		stash->lockUrgent--;
+		stash->lockOwner = pthread_self();
+		stash->lockDepth = 1;
+	}
+	pthread_mutex_unlock(&stash->lockMutex);
+}
+
+void fonsLockYielding(FONScontext* stash)
+{
+	pthread_mutex_lock(&stash->lockMutex);
+	while (stash->lockDepth > 0 || stash->lockUrgent > 0)
+		pthread_cond_wait(&stash->lockFree, &stash->lockMutex);
+	stash->lockOwner = pthread_self();
+	stash->lockDepth = 1;
+	pthread_mutex_unlock(&stash->lockMutex);
+}
+
+void fonsUnlock(FONScontext* stash)
+{
+	pthread_mutex_lock(&stash->lockMutex);
+	if (--stash->lockDepth == 0)
+		pthread_cond_broadcast(&stash->lockFree);
+	pthread_mutex_unlock(&stash->lockMutex);
+}
+
 void fonsSetErrorCallback(FONScontext* stash, void (*callback)(void* uptr, int error, int val), void* uptr)
 {
 	if (stash == NULL) return;
@@ -1663,7 +2603,7 @@ void fonsGetAtlasSize(FONScontext* stash, int* width, int* height)
 
 int fonsExpandAtlas(FONScontext* stash, int width, int height)
 {
-	int i, maxy = 0;
+	int i, j, maxy;
 	unsigned char* data = NULL;
 	if (stash == NULL) return 0;
 
@@ -1681,33 +2621,39 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 		if (stash->params.renderResize(stash->params.userPtr, width, height) == 0)
 			return 0;
 	}
-	// Copy old texture data over.
-	data = (unsigned char*)malloc(width * height);
-	if (data == NULL)
-		return 0;
-	for (i = 0; i < stash->params.height; i++) {
-		unsigned char* dst = &data[i*width];
-		unsigned char* src = &stash->texData[i*stash->params.width];
-		memcpy(dst, src, stash->params.width);
-		if (width > stash->params.width)
-			memset(dst+stash->params.width, 0, width - stash->params.width);
-	}
-	if (height > stash->params.height)
-		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
-
-	free(stash->texData);
-	stash->texData = data;
-
-	// Increase atlas size
-	fons__atlasExpand(stash->atlas, width, height);
-
-	// Add existing data as dirty.
-	for (i = 0; i < stash->atlas->nnodes; i++)
-		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
-	stash->dirtyRect[0] = 0;
-	stash->dirtyRect[1] = 0;
-	stash->dirtyRect[2] = stash->params.width;
-	stash->dirtyRect[3] = maxy;
+	for (j = 0; j < stash->npages; j++) {
+		FONSpage* page = &stash->pages[j];
+		if (page->texData == NULL) continue;
+
+		// Copy old texture data over.
+		data = (unsigned char*)malloc(width * height);
+		if (data == NULL)
+			return 0;
+		for (i = 0; i < stash->params.height; i++) {
+			unsigned char* dst = &data[i*width];
+			unsigned char* src = &page->texData[i*stash->params.width];
+			memcpy(dst, src, stash->params.width);
+			if (width > stash->params.width)
+				memset(dst+stash->params.width, 0, width - stash->params.width);
+		}
+		if (height > stash->params.height)
+			memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
+
+		free(page->texData);
+		page->texData = data;
+
+		// Increase atlas size
+		fons__atlasExpand(page->atlas, width, height);
+
+		// Add existing data as dirty.
+		maxy = 0;
+		for (i = 0; i < page->atlas->nnodes; i++)
+			maxy = fons__maxi(maxy, page->atlas->nodes[i].y);
+		page->dirtyRect[0] = 0;
+		page->dirtyRect[1] = 0;
+		page->dirtyRect[2] = stash->params.width;
+		page->dirtyRect[3] = maxy;
+	}
 
 	stash->params.width = width;
 	stash->params.height = height;
@@ -1719,7 +2665,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 
 int fonsResetAtlas(FONScontext* stash, int width, int height)
 {
-	int i, j;
+	int i;
 	if (stash == NULL) return 0;
 
 	// Flush pending glyphs.
@@ -1731,38 +2677,139 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 			return 0;
 	}
 
-	// Reset atlas
-	fons__atlasReset(stash->atlas, width, height);
-
-	// Clear texture data.
-	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
-	if (stash->texData == NULL) return 0;
-	memset(stash->texData, 0, width * height);
-
-	// Reset dirty rect
-	stash->dirtyRect[0] = width;
-	stash->dirtyRect[1] = height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
-
-	// Reset cached glyphs
-	for (i = 0; i < stash->nfonts; i++) {
-		FONSfont* font = stash->fonts[i];
-		font->nglyphs = 0;
-		for (j = 0; j < FONS_HASH_LUT_SIZE; j++)
-			font->lut[j] = -1;
-	}
-
+	// Release all pages but an empty first one.
+	for (i = 0; i < stash->npages; i++)
+		fons__releasePage(&stash->pages[i]);
 	stash->params.width = width;
 	stash->params.height = height;
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
+	if (fons__allocPage(stash, 0) == -1) return 0;
 
-	// Add white rect at 0,0 for debug drawing.
-	fons__addWhiteRect(stash, 2,2);
+	// Reset cached glyphs, along with the pending ones
+	for (i = 0; i < stash->nfonts; i++)
+		stash->fonts[i]->nglyphs = 0;
+	stash->generation++;
+	for (i = 0; i <= stash->slotMask; i++)
+		stash->slots[i].font = -1;
+	stash->nslots = 0;
 
 	return 1;
 }
 
+#define FONS_BAKED_HEADER_SIZE 20
+#define FONS_BAKED_FONT_SIZE 72
+#define FONS_BAKED_GLYPH_SIZE 28
+
+static unsigned int fons__readU32(const unsigned char* p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static short fons__readS16(const unsigned char* p)
+{
+	return (short)(p[0] | (p[1] << 8));
+}
+
+int fonsBakedGlyphsSize(const unsigned char* data, int ndata, int* width, int* height)
+{
+	unsigned int i, w, h, nfonts;
+	size_t size = FONS_BAKED_HEADER_SIZE;
+	if (data == NULL || ndata < FONS_BAKED_HEADER_SIZE || memcmp(data, "FONSBAKE", 8) != 0)
+		return 0;
+	w = fons__readU32(data + 8);
+	h = fons__readU32(data + 12);
+	nfonts = fons__readU32(data + 16);
+	if (w == 0 || h == 0 || w > 32767 || h > 32767)
+		return 0;
+	for (i = 0; i < nfonts; i++) {
+		if (size + FONS_BAKED_FONT_SIZE > (size_t)ndata)
+			return 0;
+		size += FONS_BAKED_FONT_SIZE + (size_t)fons__readU32(data + size + 68) * FONS_BAKED_GLYPH_SIZE;
+	}
+	if (size + (size_t)w * h != (size_t)ndata)
+		return 0;
+	*width = (int)w;
+	*height = (int)h;
+	return 1;
+}
+
+static FONSfont* fons__bakedFont(FONScontext* stash, const unsigned char* rec)
+{
+	char name[64];
+	int i;
+	memcpy(name, rec, 63);
+	name[63] = '\0';
+	i = fonsGetFontByName(stash, name);
+	if (i == FONS_INVALID || stash->fonts[i]->dataSize != (int)fons__readU32(rec + 64))
+		return NULL;
+	return stash->fonts[i];
+}
+
+int fonsAddBakedGlyphs(FONScontext* stash, const unsigned char* data, int ndata)
+{
+	const unsigned char *rec, *pixels;
+	unsigned int i, j, nfonts, nglyphs;
+	int w, h, gx = 0, gy = 0, gp = 0, y, pass, added = 0;
+	if (stash == NULL || !fonsBakedGlyphsSize(data, ndata, &w, &h))
+		return 0;
+	nfonts = fons__readU32(data + 16);
+	pixels = data + ndata - (size_t)w * h;
+
+	// The first pass counts the missing glyphs, the second one adds them.
+	for (pass = 0; pass < 2; pass++) {
+		rec = data + FONS_BAKED_HEADER_SIZE;
+		for (i = 0; i < nfonts; i++) {
+			FONSfont* font = fons__bakedFont(stash, rec);
+			nglyphs = fons__readU32(rec + 68);
+			rec += FONS_BAKED_FONT_SIZE;
+			for (j = 0; font != NULL && j < nglyphs; j++) {
+				const unsigned char* g = rec + j * FONS_BAKED_GLYPH_SIZE;
+				unsigned int codepoint = fons__readU32(g);
+				short isize = fons__readS16(g + 8), iblur = fons__readS16(g + 10);
+				FONSglyph* glyph = fons__findGlyph(stash, font, codepoint, isize, iblur);
+				if (glyph != NULL && glyph->page >= 0)
+					continue;
+				if (pass == 0) {
+					added++;
+					continue;
+				}
+				if (glyph == NULL) {
+					glyph = fons__allocGlyph(font);
+					if (glyph == NULL) return 0;
+					glyph->codepoint = codepoint;
+					glyph->size = isize;
+					glyph->blur = iblur;
+					if (!fons__insertGlyph(stash, font, font->nglyphs-1)) {
+						font->nglyphs--;
+						return 0;
+					}
+				}
+				glyph->page = (short)gp;
+				glyph->index = (int)fons__readU32(g + 4);
+				glyph->x0 = (short)(gx + fons__readS16(g + 12));
+				glyph->y0 = (short)(gy + fons__readS16(g + 14));
+				glyph->x1 = (short)(gx + fons__readS16(g + 16));
+				glyph->y1 = (short)(gy + fons__readS16(g + 18));
+				glyph->xadv = fons__readS16(g + 20);
+				glyph->xoff = fons__readS16(g + 22);
+				glyph->yoff = fons__readS16(g + 24);
+			}
+			rec += nglyphs * FONS_BAKED_GLYPH_SIZE;
+		}
+
+		if (pass == 0) {
+			if (added == 0)
+				return 0;
+			if (fons__atlasAllocRect(stash, w, h, 0, &gp, &gx, &gy) == 0)
+				return -1;
+			for (y = 0; y < h; y++)
+				memcpy(&stash->pages[gp].texData[gx + (gy + y) * stash->params.width], &pixels[y * w], w);
+			fons__addDirtyRect(&stash->pages[gp], gx, gy, gx+w, gy+h);
+		}
+	}
+	return added;
+}
+
 
 #endif
@@ -37,15 +37,17 @@
 #pragma warning(disable: 4706)  // assignment within conditional expression
 #endif
 
-#define NVG_INIT_FONTIMAGE_SIZE  512
-#define NVG_MAX_FONTIMAGE_SIZE   2048
-#define NVG_MAX_FONTIMAGES       4
+#define NVG_FONT_PAGE_SIZE       1024
+#define NVG_DEFAULT_FONT_PAGES   4
+#define NVG_MAX_FONTIMAGES       16
 
 #define NVG_INIT_COMMANDS_SIZE 256
 #define NVG_INIT_POINTS_SIZE 128
 #define NVG_INIT_PATHS_SIZE 16
 #define NVG_INIT_VERTS_SIZE 256
 #define NVG_MAX_STATES 32
+#define NVG_MAX_RECORDINGS 16
+#define NVG_MAX_CLIPS 64
 
 #define NVG_KAPPA90 0.5522847493f	// Length proportional to radius of a cubic bezier handle for 90deg arcs.
 
@@ -84,11 +86,20 @@ struct NVGstate {
 	float letterSpacing;
 	float lineHeight;
 	float fontBlur;
+	int fontSDF;
 	int textAlign;
 	int fontId;
 };
 typedef struct NVGstate NVGstate;
 
+struct NVGclip {
+	float xform[6];
+	NVGscissor scissor;
+	int nstates;		// State stack depth at nvgPushClip().
+	int saved;			// Set once the state has been pushed onto the state stack.
+};
+typedef struct NVGclip NVGclip;
+
 struct NVGpoint {
 	float x,y;
 	float dx, dy;
@@ -127,11 +138,71 @@ struct NVGcontext {
 	float devicePxRatio;
 	struct FONScontext* fs;
 	int fontImages[NVG_MAX_FONTIMAGES];
-	int fontImageIdx;
+	int fontImageSDF[NVG_MAX_FONTIMAGES];
+	int fontDirty[NVG_MAX_FONTIMAGES][4];	// Regions of the font textures to upload
+	NVGcontext* fontShareNext;	// Ring of the contexts sharing the font stash
+	int fontMetrics;	// Measures text with the fonts of other contexts, see nvgCreateMetrics()
+	int fontEvictions;
+	int glyphPlaceholders;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
 	int textTriCount;
+	int atlasGeneration;
+	NVGdisplayList* recordings[NVG_MAX_RECORDINGS];
+	int nrecordings;
+	int firstRecording;
+	NVGclip clips[NVG_MAX_CLIPS];
+	int nclips;
+};
+
+enum NVGrecordedCallType {
+	NVG_RECORDED_FILL,
+	NVG_RECORDED_STROKE,
+	NVG_RECORDED_TRIANGLES,
+};
+
+struct NVGrecordedCall {
+	int type;
+	NVGpaint paint;
+	NVGcompositeOperationState compositeOperation;
+	NVGscissor scissor;
+	float fringe;
+	float strokeWidth;
+	float bounds[4];
+	int path0, npaths;
+	int vert0, nverts;
+};
+typedef struct NVGrecordedCall NVGrecordedCall;
+
+struct NVGrecordedPath {
+	NVGpath path;
+	int fill0, stroke0;
+};
+typedef struct NVGrecordedPath NVGrecordedPath;
+
+struct NVGdisplayList {
+	NVGrecordedCall* calls;
+	int ncalls, ccalls;
+	NVGrecordedPath* paths;
+	int npaths, cpaths;
+	NVGvertex* verts;
+	int nverts, cverts;
+
+	// Scratch space for translated replays
+	NVGvertex* tverts;
+	int ctverts;
+	NVGpath* tpaths;
+	int ctpaths;
+
+	// State at the start of the recording
+	float xform[6];
+	NVGscissor scissor;
+	float alpha;
+	float devicePxRatio;
+	int atlasGeneration;
+	int glyphPlaceholders;
+	int valid;
 };
 
 static float nvg__sqrtf(float a) { return sqrtf(a); }
@@ -163,6 +234,19 @@ static float nvg__normalize(float *x, float* y)
 	return d;
 }
 
+static int nvg__reserve(void** buf, int* cap, int size, int count)
+{
+	void* mem;
+	int ccount;
+	if (count <= *cap) return 1;
+	ccount = nvg__maxi(count, *cap + *cap/2);
+	mem = realloc(*buf, (size_t)ccount * size);
+	if (mem == NULL) return 0;
+	*buf = mem;
+	*cap = ccount;
+	return 1;
+}
+
 
 static void nvg__deletePathCache(NVGpathCache* c)
 {
@@ -286,7 +370,24 @@ static NVGstate* nvg__getState(NVGcontext* ctx)
 	return &ctx->states[ctx->nstates-1];
 }
 
-NVGcontext* nvgCreateInternal(NVGparams* params)
+// Returns the current state for changes other than to the transform and scissor.
+// The first such change after nvgPushClip() does what nvgSave() would have done,
+// unless it affects a state pushed later on (which nvgRestore() takes care of).
+static NVGstate* nvg__editState(NVGcontext* ctx)
+{
+	if (ctx->nclips > 0 && ctx->nclips <= NVG_MAX_CLIPS) {
+		NVGclip* clip = &ctx->clips[ctx->nclips-1];
+		if (!clip->saved && ctx->nstates == clip->nstates && ctx->nstates < NVG_MAX_STATES) {
+			memcpy(&ctx->states[ctx->nstates], &ctx->states[ctx->nstates-1], sizeof(NVGstate));
+			ctx->nstates++;
+			clip->saved = 1;
+		}
+	}
+	return &ctx->states[ctx->nstates-1];
+}
+
+// Creates a context that draws with its own fonts, or measures text with the given ones.
+static NVGcontext* nvg__createContext(NVGparams* params, struct FONScontext* metricsFonts)
 {
 	FONSparams fontParams;
 	NVGcontext* ctx = (NVGcontext*)malloc(sizeof(NVGcontext));
@@ -297,6 +398,7 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	ctx->params = *params;
 	for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
 		ctx->fontImages[i] = 0;
+	ctx->fontShareNext = ctx;
 
 	ctx->commands = (float*)malloc(sizeof(float)*NVG_INIT_COMMANDS_SIZE);
 	if (!ctx->commands) goto error;
@@ -313,10 +415,17 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 
 	if (ctx->params.renderCreate(ctx->params.userPtr) == 0) goto error;
 
+	if (metricsFonts != NULL) {
+		ctx->fs = metricsFonts;
+		ctx->fontMetrics = 1;
+		return ctx;
+	}
+
 	// Init font rendering
 	memset(&fontParams, 0, sizeof(fontParams));
-	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
-	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
+	fontParams.width = NVG_FONT_PAGE_SIZE;
+	fontParams.height = NVG_FONT_PAGE_SIZE;
+	fontParams.maxPages = NVG_DEFAULT_FONT_PAGES;
 	fontParams.flags = FONS_ZERO_TOPLEFT;
 	fontParams.renderCreate = NULL;
 	fontParams.renderUpdate = NULL;
@@ -326,10 +435,9 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	ctx->fs = fonsCreateInternal(&fontParams);
 	if (ctx->fs == NULL) goto error;
 
-	// Create font texture
+	// Create the texture of the first font atlas page, the others are created on demand
 	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
 	if (ctx->fontImages[0] == 0) goto error;
-	ctx->fontImageIdx = 0;
 
 	return ctx;
 
@@ -338,6 +446,103 @@ error:
 	return 0;
 }
 
+NVGcontext* nvgCreateInternal(NVGparams* params)
+{
+	return nvg__createContext(params, NULL);
+}
+
+// Renderer of measuring contexts, which draw nothing.
+static int nvg__metricsCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int nvg__metricsCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(type); NVG_NOTUSED(w); NVG_NOTUSED(h); NVG_NOTUSED(imageFlags); NVG_NOTUSED(data);
+	return 0;
+}
+
+static int nvg__metricsDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image);
+	return 0;
+}
+
+static int nvg__metricsUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image); NVG_NOTUSED(x); NVG_NOTUSED(y); NVG_NOTUSED(w); NVG_NOTUSED(h); NVG_NOTUSED(data);
+	return 0;
+}
+
+static int nvg__metricsGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image); NVG_NOTUSED(w); NVG_NOTUSED(h);
+	return 0;
+}
+
+static void nvg__metricsViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(width); NVG_NOTUSED(height); NVG_NOTUSED(devicePixelRatio);
+}
+
+static void nvg__metricsFlush(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static void nvg__metricsFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							 const float* bounds, const NVGpath* paths, int npaths)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(paint); NVG_NOTUSED(compositeOperation); NVG_NOTUSED(scissor); NVG_NOTUSED(fringe);
+	NVG_NOTUSED(bounds); NVG_NOTUSED(paths); NVG_NOTUSED(npaths);
+}
+
+static void nvg__metricsStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							   float strokeWidth, const NVGpath* paths, int npaths)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(paint); NVG_NOTUSED(compositeOperation); NVG_NOTUSED(scissor); NVG_NOTUSED(fringe);
+	NVG_NOTUSED(strokeWidth); NVG_NOTUSED(paths); NVG_NOTUSED(npaths);
+}
+
+static void nvg__metricsTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								  const NVGvertex* verts, int nverts)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(paint); NVG_NOTUSED(compositeOperation); NVG_NOTUSED(scissor);
+	NVG_NOTUSED(verts); NVG_NOTUSED(nverts);
+}
+
+NVGcontext* nvgCreateMetrics(NVGcontext* other)
+{
+	NVGparams params;
+	NVGcontext* ctx;
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = nvg__metricsCreate;
+	params.renderCreateTexture = nvg__metricsCreateTexture;
+	params.renderDeleteTexture = nvg__metricsDeleteTexture;
+	params.renderUpdateTexture = nvg__metricsUpdateTexture;
+	params.renderGetTextureSize = nvg__metricsGetTextureSize;
+	params.renderViewport = nvg__metricsViewport;
+	params.renderCancel = nvg__metricsFlush;
+	params.renderFlush = nvg__metricsFlush;
+	params.renderFill = nvg__metricsFill;
+	params.renderStroke = nvg__metricsStroke;
+	params.renderTriangles = nvg__metricsTriangles;
+	params.edgeAntiAlias = other->params.edgeAntiAlias;
+
+	ctx = nvg__createContext(&params, other->fs);
+	if (ctx != NULL)
+		nvg__setDevicePixelRatio(ctx, other->devicePxRatio);
+	return ctx;
+}
+
+struct FONScontext* nvgFontStash(NVGcontext* ctx)
+{
+	return ctx->fs;
+}
+
 NVGparams* nvgInternalParams(NVGcontext* ctx)
 {
     return &ctx->params;
@@ -350,8 +555,15 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
 
-	if (ctx->fs)
+	if (ctx->fontShareNext != ctx) {
+		// Leave the fonts to the other contexts
+		NVGcontext* prev = ctx->fontShareNext;
+		while (prev->fontShareNext != ctx)
+			prev = prev->fontShareNext;
+		prev->fontShareNext = ctx->fontShareNext;
+	} else if (ctx->fs && !ctx->fontMetrics) {
 		fonsDeleteInternal(ctx->fs);
+	}
 
 	for (i = 0; i < NVG_MAX_FONTIMAGES; i++) {
 		if (ctx->fontImages[i] != 0) {
@@ -366,6 +578,29 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	free(ctx);
 }
 
+// Measuring contexts let contexts that draw go first.
+static void nvg__lockFonts(NVGcontext* ctx)
+{
+	if (ctx->fontMetrics)
+		fonsLockYielding(ctx->fs);
+	else
+		fonsLock(ctx->fs);
+}
+
+static void nvg__unlockFonts(NVGcontext* ctx)
+{
+	fonsUnlock(ctx->fs);
+}
+
+static void nvg__checkFontEvictions(NVGcontext* ctx)
+{
+	// Glyph coordinates recorded in display lists are no longer valid
+	if (fonsGetEvictionCount(ctx->fs) != ctx->fontEvictions) {
+		ctx->fontEvictions = fonsGetEvictionCount(ctx->fs);
+		ctx->atlasGeneration++;
+	}
+}
+
 void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio)
 {
 /*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
@@ -373,6 +608,7 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
 		ctx->fillTriCount+ctx->strokeTriCount+ctx->textTriCount);*/
 
 	ctx->nstates = 0;
+	ctx->nclips = 0;
 	nvgSave(ctx);
 	nvgReset(ctx);
 
@@ -384,6 +620,15 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
 	ctx->fillTriCount = 0;
 	ctx->strokeTriCount = 0;
 	ctx->textTriCount = 0;
+
+	if (ctx->fontMetrics) return;
+
+	nvg__lockFonts(ctx);
+	// Font atlas pages drawn from in this frame are kept from eviction
+	fonsBeginFrame(ctx->fs);
+	// Contexts sharing the fonts may have evicted pages since the last frame
+	nvg__checkFontEvictions(ctx);
+	nvg__unlockFonts(ctx);
 }
 
 void nvgCancelFrame(NVGcontext* ctx)
@@ -394,31 +639,6 @@ void nvgCancelFrame(NVGcontext* ctx)
 void nvgEndFrame(NVGcontext* ctx)
 {
 	ctx->params.renderFlush(ctx->params.userPtr);
-	if (ctx->fontImageIdx != 0) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
-		int i, j, iw, ih;
-		// delete images that smaller than current one
-		if (fontImage == 0)
-			return;
-		nvgImageSize(ctx, fontImage, &iw, &ih);
-		for (i = j = 0; i < ctx->fontImageIdx; i++) {
-			if (ctx->fontImages[i] != 0) {
-				int nw, nh;
-				nvgImageSize(ctx, ctx->fontImages[i], &nw, &nh);
-				if (nw < iw || nh < ih)
-					nvgDeleteImage(ctx, ctx->fontImages[i]);
-				else
-					ctx->fontImages[j++] = ctx->fontImages[i];
-			}
-		}
-		// make current font image to first
-		ctx->fontImages[j++] = ctx->fontImages[0];
-		ctx->fontImages[0] = fontImage;
-		ctx->fontImageIdx = 0;
-		// clear all images after j
-		for (i = j; i < NVG_MAX_FONTIMAGES; i++)
-			ctx->fontImages[i] = 0;
-	}
 }
 
 NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
@@ -643,7 +863,7 @@ void nvgRestore(NVGcontext* ctx)
 
 void nvgReset(NVGcontext* ctx)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	memset(state, 0, sizeof(*state));
 
 	nvg__setPaintColor(&state->fill, nvgRGBA(255,255,255,255));
@@ -664,6 +884,7 @@ void nvgReset(NVGcontext* ctx)
 	state->letterSpacing = 0.0f;
 	state->lineHeight = 1.0f;
 	state->fontBlur = 0.0f;
+	state->fontSDF = 0;
 	state->textAlign = NVG_ALIGN_LEFT | NVG_ALIGN_BASELINE;
 	state->fontId = 0;
 }
@@ -671,37 +892,37 @@ void nvgReset(NVGcontext* ctx)
 // State setting
 void nvgShapeAntiAlias(NVGcontext* ctx, int enabled)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->shapeAntiAlias = enabled;
 }
 
 void nvgStrokeWidth(NVGcontext* ctx, float width)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->strokeWidth = width;
 }
 
 void nvgMiterLimit(NVGcontext* ctx, float limit)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->miterLimit = limit;
 }
 
 void nvgLineCap(NVGcontext* ctx, int cap)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->lineCap = cap;
 }
 
 void nvgLineJoin(NVGcontext* ctx, int join)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->lineJoin = join;
 }
 
 void nvgGlobalAlpha(NVGcontext* ctx, float alpha)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->alpha = alpha;
 }
 
@@ -767,26 +988,26 @@ void nvgCurrentTransform(NVGcontext* ctx, float* xform)
 
 void nvgStrokeColor(NVGcontext* ctx, NVGcolor color)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	nvg__setPaintColor(&state->stroke, color);
 }
 
 void nvgStrokePaint(NVGcontext* ctx, NVGpaint paint)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->stroke = paint;
 	nvgTransformMultiply(state->stroke.xform, state->xform);
 }
 
 void nvgFillColor(NVGcontext* ctx, NVGcolor color)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	nvg__setPaintColor(&state->fill, color);
 }
 
 void nvgFillPaint(NVGcontext* ctx, NVGpaint paint)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->fill = paint;
 	nvgTransformMultiply(state->fill.xform, state->xform);
 }
@@ -987,35 +1208,73 @@ static void nvg__isectRects(float* dst,
 	dst[3] = nvg__maxf(0.0f, maxy - miny);
 }
 
-void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h)
+static int nvg__isTranslation(const float* t)
+{
+	return t[0] == 1.0f && t[1] == 0.0f && t[2] == 0.0f && t[3] == 1.0f;
+}
+
+// Computes the bounds of the current scissor rect in current transform space.
+static void nvg__scissorBounds(NVGstate* state, float* bounds)
 {
-	NVGstate* state = nvg__getState(ctx);
 	float pxform[6], invxorm[6];
-	float rect[4];
 	float ex, ey, tex, tey;
 
-	// If no previous scissor has been set, set the scissor as current scissor.
-	if (state->scissor.extent[0] < 0) {
-		nvgScissor(ctx, x, y, w, h);
+	ex = state->scissor.extent[0];
+	ey = state->scissor.extent[1];
+
+	// Both transforms are translations in the common case of nested widgets. Taking
+	// the difference gives the same result as the general case, without the inverse.
+	if (nvg__isTranslation(state->xform) && nvg__isTranslation(state->scissor.xform)) {
+		bounds[0] = (state->scissor.xform[4] - state->xform[4]) - ex;
+		bounds[1] = (state->scissor.xform[5] - state->xform[5]) - ey;
+		bounds[2] = ex*2;
+		bounds[3] = ey*2;
 		return;
 	}
 
-	// Transform the current scissor rect into current transform space.
 	// If there is difference in rotation, this will be approximation.
 	memcpy(pxform, state->scissor.xform, sizeof(float)*6);
-	ex = state->scissor.extent[0];
-	ey = state->scissor.extent[1];
 	nvgTransformInverse(invxorm, state->xform);
 	nvgTransformMultiply(pxform, invxorm);
 	tex = ex*nvg__absf(pxform[0]) + ey*nvg__absf(pxform[2]);
 	tey = ex*nvg__absf(pxform[1]) + ey*nvg__absf(pxform[3]);
 
+	bounds[0] = pxform[4]-tex;
+	bounds[1] = pxform[5]-tey;
+	bounds[2] = tex*2;
+	bounds[3] = tey*2;
+}
+
+void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float bounds[4];
+	float rect[4];
+
+	// If no previous scissor has been set, set the scissor as current scissor.
+	if (state->scissor.extent[0] < 0) {
+		nvgScissor(ctx, x, y, w, h);
+		return;
+	}
+
+	// Transform the current scissor rect into current transform space.
+	nvg__scissorBounds(state, bounds);
+
 	// Intersect rects.
-	nvg__isectRects(rect, pxform[4]-tex,pxform[5]-tey,tex*2,tey*2, x,y,w,h);
+	nvg__isectRects(rect, bounds[0],bounds[1],bounds[2],bounds[3], x,y,w,h);
 
 	nvgScissor(ctx, rect[0], rect[1], rect[2], rect[3]);
 }
 
+int nvgCurrentScissor(NVGcontext* ctx, float* bounds)
+{
+	NVGstate* state = nvg__getState(ctx);
+	if (state->scissor.extent[0] < 0)
+		return 0;
+	nvg__scissorBounds(state, bounds);
+	return 1;
+}
+
 void nvgResetScissor(NVGcontext* ctx)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -1024,10 +1283,69 @@ void nvgResetScissor(NVGcontext* ctx)
 	state->scissor.extent[1] = -1.0f;
 }
 
+void nvgPushClip(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGclip* clip;
+	float rect[4], ex, ey, tx, ty;
+
+	if (ctx->nclips >= NVG_MAX_CLIPS) {
+		ctx->nclips++;
+		nvgSave(ctx);
+		nvgIntersectScissor(ctx, x, y, w, h);
+		return;
+	}
+
+	clip = &ctx->clips[ctx->nclips++];
+	memcpy(clip->xform, state->xform, sizeof(float)*6);
+	clip->scissor = state->scissor;
+	clip->nstates = ctx->nstates;
+	clip->saved = 0;
+
+	if (state->scissor.extent[0] < 0 || !nvg__isTranslation(state->xform) ||
+		!nvg__isTranslation(state->scissor.xform)) {
+		nvgIntersectScissor(ctx, x, y, w, h);
+		return;
+	}
+
+	// Same as nvgIntersectScissor() for translations, without the matrix products.
+	ex = state->scissor.extent[0];
+	ey = state->scissor.extent[1];
+	tx = state->xform[4];
+	ty = state->xform[5];
+	nvg__isectRects(rect, (state->scissor.xform[4] - tx) - ex, (state->scissor.xform[5] - ty) - ey,
+					ex*2, ey*2, x, y, w, h);
+	w = nvg__maxf(0.0f, rect[2]);
+	h = nvg__maxf(0.0f, rect[3]);
+	state->scissor.xform[4] = (rect[0] + w*0.5f) + tx;
+	state->scissor.xform[5] = (rect[1] + h*0.5f) + ty;
+	state->scissor.extent[0] = w*0.5f;
+	state->scissor.extent[1] = h*0.5f;
+}
+
+void nvgPopClip(NVGcontext* ctx)
+{
+	NVGstate* state;
+	NVGclip* clip;
+
+	if (ctx->nclips <= 0)
+		return;
+	if (--ctx->nclips >= NVG_MAX_CLIPS) {
+		nvgRestore(ctx);
+		return;
+	}
+
+	clip = &ctx->clips[ctx->nclips];
+	ctx->nstates = clip->nstates;
+	state = nvg__getState(ctx);
+	memcpy(state->xform, clip->xform, sizeof(float)*6);
+	state->scissor = clip->scissor;
+}
+
 // Global composite operation.
 void nvgGlobalCompositeOperation(NVGcontext* ctx, int op)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->compositeOperation = nvg__compositeOperationState(op);
 }
 
@@ -1044,7 +1362,7 @@ void nvgGlobalCompositeBlendFuncSeparate(NVGcontext* ctx, int srcRGB, int dstRGB
 	op.srcAlpha = srcAlpha;
 	op.dstAlpha = dstAlpha;
 
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->compositeOperation = op;
 }
 
@@ -2219,6 +2537,94 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
 	}
 }
 
+static void nvg__recordCall(NVGdisplayList* list, int type, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+							NVGscissor* scissor, float fringe, float strokeWidth, const float* bounds,
+							const NVGpath* paths, int npaths, const NVGvertex* verts, int nverts)
+{
+	NVGrecordedCall* call;
+	int i, count = nverts;
+
+	if (!list->valid) return;
+	for (i = 0; i < npaths; i++)
+		count += paths[i].nfill + paths[i].nstroke;
+	if (!nvg__reserve((void**)&list->calls, &list->ccalls, sizeof(NVGrecordedCall), list->ncalls+1) ||
+		!nvg__reserve((void**)&list->paths, &list->cpaths, sizeof(NVGrecordedPath), list->npaths+npaths) ||
+		!nvg__reserve((void**)&list->verts, &list->cverts, sizeof(NVGvertex), list->nverts+count)) {
+		list->valid = 0;
+		return;
+	}
+
+	call = &list->calls[list->ncalls++];
+	call->type = type;
+	call->paint = *paint;
+	call->compositeOperation = compositeOperation;
+	call->scissor = *scissor;
+	call->fringe = fringe;
+	call->strokeWidth = strokeWidth;
+	if (bounds != NULL)
+		memcpy(call->bounds, bounds, sizeof(float)*4);
+	else
+		memset(call->bounds, 0, sizeof(float)*4);
+	call->path0 = list->npaths;
+	call->npaths = npaths;
+	call->vert0 = list->nverts;
+	call->nverts = nverts;
+
+	if (nverts > 0) {
+		memcpy(&list->verts[list->nverts], verts, sizeof(NVGvertex)*nverts);
+		list->nverts += nverts;
+	}
+
+	for (i = 0; i < npaths; i++) {
+		NVGrecordedPath* rp = &list->paths[list->npaths++];
+		rp->path = paths[i];
+		rp->path.fill = NULL;
+		rp->path.stroke = NULL;
+		rp->fill0 = list->nverts;
+		if (paths[i].nfill > 0)
+			memcpy(&list->verts[list->nverts], paths[i].fill, sizeof(NVGvertex)*paths[i].nfill);
+		list->nverts += paths[i].nfill;
+		rp->stroke0 = list->nverts;
+		if (paths[i].nstroke > 0)
+			memcpy(&list->verts[list->nverts], paths[i].stroke, sizeof(NVGvertex)*paths[i].nstroke);
+		list->nverts += paths[i].nstroke;
+	}
+}
+
+static void nvg__recordCalls(NVGcontext* ctx, int type, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+							 NVGscissor* scissor, float fringe, float strokeWidth, const float* bounds,
+							 const NVGpath* paths, int npaths, const NVGvertex* verts, int nverts)
+{
+	int i, n = nvg__mini(ctx->nrecordings, NVG_MAX_RECORDINGS);
+	for (i = ctx->firstRecording; i < n; i++)
+		nvg__recordCall(ctx->recordings[i], type, paint, compositeOperation, scissor, fringe, strokeWidth,
+						bounds, paths, npaths, verts, nverts);
+}
+
+static void nvg__submitFill(NVGcontext* ctx, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							float fringe, const float* bounds, const NVGpath* paths, int npaths)
+{
+	ctx->params.renderFill(ctx->params.userPtr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+	if (ctx->nrecordings > ctx->firstRecording)
+		nvg__recordCalls(ctx, NVG_RECORDED_FILL, paint, compositeOperation, scissor, fringe, 0.0f, bounds, paths, npaths, NULL, 0);
+}
+
+static void nvg__submitStroke(NVGcontext* ctx, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							  float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+{
+	ctx->params.renderStroke(ctx->params.userPtr, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+	if (ctx->nrecordings > ctx->firstRecording)
+		nvg__recordCalls(ctx, NVG_RECORDED_STROKE, paint, compositeOperation, scissor, fringe, strokeWidth, NULL, paths, npaths, NULL, 0);
+}
+
+static void nvg__submitTriangles(NVGcontext* ctx, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								 const NVGvertex* verts, int nverts)
+{
+	ctx->params.renderTriangles(ctx->params.userPtr, paint, compositeOperation, scissor, verts, nverts);
+	if (ctx->nrecordings > ctx->firstRecording)
+		nvg__recordCalls(ctx, NVG_RECORDED_TRIANGLES, paint, compositeOperation, scissor, 0.0f, 0.0f, NULL, NULL, 0, verts, nverts);
+}
+
 void nvgFill(NVGcontext* ctx)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2236,8 +2642,8 @@ void nvgFill(NVGcontext* ctx)
 	fillPaint.innerColor.a *= state->alpha;
 	fillPaint.outerColor.a *= state->alpha;
 
-	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+	nvg__submitFill(ctx, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+					ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
 
 	// Count triangles
 	for (i = 0; i < ctx->cache->npaths; i++) {
@@ -2278,8 +2684,8 @@ void nvgStroke(NVGcontext* ctx)
 	else
 		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
 
-	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+	nvg__submitStroke(ctx, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+					  strokeWidth, ctx->cache->paths, ctx->cache->npaths);
 
 	// Count triangles
 	for (i = 0; i < ctx->cache->npaths; i++) {
@@ -2289,28 +2695,198 @@ void nvgStroke(NVGcontext* ctx)
 	}
 }
 
+NVGdisplayList* nvgCreateDisplayList(void)
+{
+	NVGdisplayList* list = (NVGdisplayList*)malloc(sizeof(NVGdisplayList));
+	if (list == NULL) return NULL;
+	memset(list, 0, sizeof(NVGdisplayList));
+	return list;
+}
+
+void nvgDeleteDisplayList(NVGdisplayList* list)
+{
+	if (list == NULL) return;
+	free(list->calls);
+	free(list->paths);
+	free(list->verts);
+	free(list->tverts);
+	free(list->tpaths);
+	free(list);
+}
+
+void nvgBeginDisplayList(NVGcontext* ctx, NVGdisplayList* list)
+{
+	NVGstate* state = nvg__getState(ctx);
+
+	list->ncalls = list->npaths = list->nverts = 0;
+	memcpy(list->xform, state->xform, sizeof(float)*6);
+	list->scissor = state->scissor;
+	list->alpha = state->alpha;
+	list->devicePxRatio = ctx->devicePxRatio;
+	list->atlasGeneration = ctx->atlasGeneration;
+	list->glyphPlaceholders = ctx->glyphPlaceholders;
+	list->valid = ctx->nrecordings < NVG_MAX_RECORDINGS;
+
+	if (ctx->nrecordings < NVG_MAX_RECORDINGS)
+		ctx->recordings[ctx->nrecordings] = list;
+	ctx->nrecordings++;
+}
+
+int nvgEndDisplayList(NVGcontext* ctx)
+{
+	NVGdisplayList* list;
+	if (ctx->nrecordings <= 0) return 0;
+	ctx->nrecordings--;
+	if (ctx->nrecordings >= NVG_MAX_RECORDINGS) return 0;
+	list = ctx->recordings[ctx->nrecordings];
+	// Text without some glyphs must be recorded again once they are rasterized
+	if (list->atlasGeneration != ctx->atlasGeneration || list->glyphPlaceholders != ctx->glyphPlaceholders)
+		list->valid = 0;
+	return list->valid;
+}
+
+int nvgSuspendDisplayLists(NVGcontext* ctx)
+{
+	int first = ctx->firstRecording;
+	ctx->firstRecording = ctx->nrecordings;
+	return first;
+}
+
+void nvgResumeDisplayLists(NVGcontext* ctx, int state)
+{
+	ctx->firstRecording = state;
+}
+
+static int nvg__sameTranslation(float dx, float dy, const float* a, const float* b)
+{
+	return nvg__absf(a[4] - b[4] - dx) < 1e-3f && nvg__absf(a[5] - b[5] - dy) < 1e-3f;
+}
+
+int nvgReplayDisplayList(NVGcontext* ctx, NVGdisplayList* list, float x, float y)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGvertex* verts;
+	float dx, dy;
+	int i, j, translate;
+
+	if (list == NULL || !list->valid ||
+		list->atlasGeneration != ctx->atlasGeneration ||
+		list->devicePxRatio != ctx->devicePxRatio ||
+		list->alpha != state->alpha ||
+		memcmp(list->xform, state->xform, sizeof(float)*4) != 0)
+		return 0;
+
+	dx = state->xform[4] - list->xform[4] + state->xform[0]*x + state->xform[2]*y;
+	dy = state->xform[5] - list->xform[5] + state->xform[1]*x + state->xform[3]*y;
+
+	// The scissor must have moved along with the content
+	if (state->scissor.extent[0] < 0.0f || list->scissor.extent[0] < 0.0f) {
+		if (state->scissor.extent[0] >= 0.0f || list->scissor.extent[0] >= 0.0f)
+			return 0;
+	} else if (memcmp(state->scissor.extent, list->scissor.extent, sizeof(float)*2) != 0 ||
+			   memcmp(state->scissor.xform, list->scissor.xform, sizeof(float)*4) != 0 ||
+			   !nvg__sameTranslation(dx, dy, state->scissor.xform, list->scissor.xform)) {
+		return 0;
+	}
+
+	translate = dx != 0.0f || dy != 0.0f;
+	verts = list->verts;
+	if (translate) {
+		if (!nvg__reserve((void**)&list->tverts, &list->ctverts, sizeof(NVGvertex), list->nverts))
+			return 0;
+		for (i = 0; i < list->nverts; i++) {
+			list->tverts[i] = list->verts[i];
+			list->tverts[i].x += dx;
+			list->tverts[i].y += dy;
+		}
+		verts = list->tverts;
+	}
+
+	for (i = 0; i < list->ncalls; i++) {
+		NVGrecordedCall* call = &list->calls[i];
+		NVGpaint paint = call->paint;
+		NVGscissor scissor = call->scissor;
+		float bounds[4];
+
+		paint.xform[4] += dx;
+		paint.xform[5] += dy;
+		scissor.xform[4] += dx;
+		scissor.xform[5] += dy;
+		bounds[0] = call->bounds[0] + dx;
+		bounds[1] = call->bounds[1] + dy;
+		bounds[2] = call->bounds[2] + dx;
+		bounds[3] = call->bounds[3] + dy;
+
+		if (call->type == NVG_RECORDED_TRIANGLES) {
+			// Keep the font atlas page of the glyphs from being evicted in this frame
+			nvg__lockFonts(ctx);
+			for (j = 0; j < NVG_MAX_FONTIMAGES; j++) {
+				if (paint.image != 0 && ctx->fontImages[j] == paint.image)
+					fonsTouchPage(ctx->fs, j);
+			}
+			nvg__unlockFonts(ctx);
+			nvg__submitTriangles(ctx, &paint, call->compositeOperation, &scissor, &verts[call->vert0], call->nverts);
+			ctx->drawCallCount++;
+			continue;
+		}
+
+		if (!nvg__reserve((void**)&list->tpaths, &list->ctpaths, sizeof(NVGpath), call->npaths))
+			return 0;
+		for (j = 0; j < call->npaths; j++) {
+			NVGrecordedPath* rp = &list->paths[call->path0 + j];
+			list->tpaths[j] = rp->path;
+			list->tpaths[j].fill = &verts[rp->fill0];
+			list->tpaths[j].stroke = &verts[rp->stroke0];
+		}
+
+		if (call->type == NVG_RECORDED_FILL)
+			nvg__submitFill(ctx, &paint, call->compositeOperation, &scissor, call->fringe, bounds, list->tpaths, call->npaths);
+		else
+			nvg__submitStroke(ctx, &paint, call->compositeOperation, &scissor, call->fringe, call->strokeWidth, list->tpaths, call->npaths);
+		ctx->drawCallCount += call->npaths;
+	}
+
+	return 1;
+}
+
 // Add fonts
 int nvgCreateFont(NVGcontext* ctx, const char* name, const char* path)
 {
-	return fonsAddFont(ctx->fs, name, path);
+	int font;
+	nvg__lockFonts(ctx);
+	font = fonsAddFont(ctx->fs, name, path);
+	nvg__unlockFonts(ctx);
+	return font;
 }
 
 int nvgCreateFontMem(NVGcontext* ctx, const char* name, unsigned char* data, int ndata, int freeData)
 {
-	return fonsAddFontMem(ctx->fs, name, data, ndata, freeData);
+	int font;
+	nvg__lockFonts(ctx);
+	font = fonsAddFontMem(ctx->fs, name, data, ndata, freeData);
+	nvg__unlockFonts(ctx);
+	return font;
 }
 
 int nvgFindFont(NVGcontext* ctx, const char* name)
 {
+	int font;
 	if (name == NULL) return -1;
-	return fonsGetFontByName(ctx->fs, name);
+	nvg__lockFonts(ctx);
+	font = fonsGetFontByName(ctx->fs, name);
+	nvg__unlockFonts(ctx);
+	return font;
 }
 
 
 int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fallbackFont)
 {
+	int added;
 	if(baseFont == -1 || fallbackFont == -1) return 0;
-	return fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
+	nvg__lockFonts(ctx);
+	added = fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
+	nvg__unlockFonts(ctx);
+	return added;
 }
 
 int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallbackFont)
@@ -2318,47 +2894,67 @@ int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallba
 	return nvgAddFallbackFontId(ctx, nvgFindFont(ctx, baseFont), nvgFindFont(ctx, fallbackFont));
 }
 
+int nvgResolveText(NVGcontext* ctx, const char* string, const char* end)
+{
+	NVGstate* state = nvg__getState(ctx);
+	int n;
+	if (state->fontId == FONS_INVALID) return 0;
+	nvg__lockFonts(ctx);
+	fonsSetFont(ctx->fs, state->fontId);
+	n = fonsResolveText(ctx->fs, string, end);
+	nvg__unlockFonts(ctx);
+	return n;
+}
+
 // State setting
 void nvgFontSize(NVGcontext* ctx, float size)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->fontSize = size;
 }
 
 void nvgFontBlur(NVGcontext* ctx, float blur)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->fontBlur = blur;
 }
 
+void nvgFontSDF(NVGcontext* ctx, int enabled)
+{
+	NVGstate* state = nvg__editState(ctx);
+	state->fontSDF = enabled;
+}
+
 void nvgTextLetterSpacing(NVGcontext* ctx, float spacing)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->letterSpacing = spacing;
 }
 
 void nvgTextLineHeight(NVGcontext* ctx, float lineHeight)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->lineHeight = lineHeight;
 }
 
 void nvgTextAlign(NVGcontext* ctx, int align)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->textAlign = align;
 }
 
 void nvgFontFaceId(NVGcontext* ctx, int font)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
 	state->fontId = font;
 }
 
 void nvgFontFace(NVGcontext* ctx, const char* font)
 {
-	NVGstate* state = nvg__getState(ctx);
+	NVGstate* state = nvg__editState(ctx);
+	nvg__lockFonts(ctx);
 	state->fontId = fonsGetFontByName(ctx->fs, font);
+	nvg__unlockFonts(ctx);
 }
 
 static float nvg__quantize(float a, float d)
@@ -2371,77 +2967,198 @@ static float nvg__getFontScale(NVGstate* state)
 	return nvg__minf(nvg__quantize(nvg__getAverageScale(state->xform), 0.01f), 4.0f);
 }
 
+static void nvg__addFontDirty(NVGcontext* ctx, int i, int x0, int y0, int x1, int y1)
+{
+	int* rect = ctx->fontDirty[i];
+	if (rect[0] >= rect[2] || rect[1] >= rect[3]) {
+		rect[0] = x0;
+		rect[1] = y0;
+		rect[2] = x1;
+		rect[3] = y1;
+	} else {
+		rect[0] = nvg__mini(rect[0], x0);
+		rect[1] = nvg__mini(rect[1], y0);
+		rect[2] = nvg__maxi(rect[2], x1);
+		rect[3] = nvg__maxi(rect[3], y1);
+	}
+}
+
 static void nvg__flushTextTexture(NVGcontext* ctx)
 {
 	int dirty[4];
-
-	if (fonsValidateTexture(ctx->fs, dirty)) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
+	int* rect;
+	int i, iw, ih, sdf, npages;
+	NVGcontext* other;
+
+	// The atlas is uploaded by the contexts that draw with it
+	if (ctx->fontMetrics) return;
+
+	nvg__lockFonts(ctx);
+	npages = nvg__mini(fonsGetPageCount(ctx->fs), NVG_MAX_FONTIMAGES);
+	for (i = 0; i < npages; i++) {
+		const unsigned char* data = fonsGetTextureData(ctx->fs, i, &iw, &ih);
+		if (data == NULL) {
+			// The page was released
+			if (ctx->fontImages[i] != 0) {
+				nvgDeleteImage(ctx, ctx->fontImages[i]);
+				ctx->fontImages[i] = 0;
+			}
+			continue;
+		}
+		// Changes of the page are uploaded by each context sharing it
+		if (fonsValidateTexture(ctx->fs, i, dirty)) {
+			other = ctx;
+			do {
+				nvg__addFontDirty(other, i, dirty[0], dirty[1], dirty[2], dirty[3]);
+				other = other->fontShareNext;
+			} while (other != ctx);
+		}
+		// Evicted pages may be reused for the other kind of glyphs
+		sdf = fonsIsSDFPage(ctx->fs, i);
+		if (ctx->fontImages[i] != 0 && ctx->fontImageSDF[i] != sdf) {
+			nvgDeleteImage(ctx, ctx->fontImages[i]);
+			ctx->fontImages[i] = 0;
+		}
+		if (ctx->fontImages[i] == 0) {
+			ctx->fontImages[i] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, sdf ? NVG_IMAGE_SDF : 0, NULL);
+			if (ctx->fontImages[i] == 0)
+				continue;
+			ctx->fontImageSDF[i] = sdf;
+			// The page may have been filled through another context
+			if (ctx->fontShareNext != ctx)
+				nvg__addFontDirty(ctx, i, 0, 0, iw, ih);
+		}
 		// Update texture
-		if (fontImage != 0) {
-			int iw, ih;
-			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
-			int x = dirty[0];
-			int y = dirty[1];
-			int w = dirty[2] - dirty[0];
-			int h = dirty[3] - dirty[1];
-			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
+		rect = ctx->fontDirty[i];
+		if (rect[0] < rect[2] && rect[1] < rect[3]) {
+			int x = rect[0];
+			int y = rect[1];
+			int w = rect[2] - rect[0];
+			int h = rect[3] - rect[1];
+			ctx->params.renderUpdateTexture(ctx->params.userPtr, ctx->fontImages[i], x,y, w,h, data);
+			rect[0] = rect[1] = rect[2] = rect[3] = 0;
 		}
 	}
+
+	nvg__checkFontEvictions(ctx);
+	nvg__unlockFonts(ctx);
 }
 
-static int nvg__allocTextAtlas(NVGcontext* ctx)
+int nvgAddBakedGlyphs(NVGcontext* ctx, const unsigned char* data, int ndata)
+{
+	int added;
+	nvg__lockFonts(ctx);
+	added = fonsAddBakedGlyphs(ctx->fs, data, ndata);
+	nvg__unlockFonts(ctx);
+	return added;
+}
+
+void nvgSetFontAtlasLimit(NVGcontext* ctx, int maxBytes)
 {
 	int iw, ih;
+	nvg__lockFonts(ctx);
+	fonsGetAtlasSize(ctx->fs, &iw, &ih);
+	fonsSetMaxPages(ctx->fs, nvg__clampi(maxBytes / (iw*ih), 1, NVG_MAX_FONTIMAGES));
 	nvg__flushTextTexture(ctx);
-	if (ctx->fontImageIdx >= NVG_MAX_FONTIMAGES-1)
-		return 0;
-	// if next fontImage already have a texture
-	if (ctx->fontImages[ctx->fontImageIdx+1] != 0)
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx+1], &iw, &ih);
-	else { // calculate the new font image size and create it.
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
-		if (iw > ih)
-			ih *= 2;
-		else
-			iw *= 2;
-		if (iw > NVG_MAX_FONTIMAGE_SIZE || ih > NVG_MAX_FONTIMAGE_SIZE)
-			iw = ih = NVG_MAX_FONTIMAGE_SIZE;
-		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
+	nvg__unlockFonts(ctx);
+}
+
+int nvgShareFonts(NVGcontext* ctx, NVGcontext* other)
+{
+	int i;
+	if (ctx == other || ctx->fontShareNext != ctx || ctx->fontMetrics || other->fontMetrics) return 0;
+
+	fonsDeleteInternal(ctx->fs);
+	ctx->fs = other->fs;
+	ctx->fontShareNext = other->fontShareNext;
+	other->fontShareNext = ctx;
+
+	// Textures of the dropped atlas are filled again when text is drawn next
+	for (i = 0; i < NVG_MAX_FONTIMAGES; i++) {
+		if (ctx->fontImages[i] != 0) {
+			nvgDeleteImage(ctx, ctx->fontImages[i]);
+			ctx->fontImages[i] = 0;
+		}
 	}
-	++ctx->fontImageIdx;
-	fonsResetAtlas(ctx->fs, iw, ih);
+	ctx->fontEvictions = fonsGetEvictionCount(ctx->fs);
+	ctx->atlasGeneration++;
 	return 1;
 }
 
-static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
+int nvgSetGlyphRasterizer(NVGcontext* ctx, void (*submit)(void* uptr, NVGglyphJob* job), void* uptr, int maxPendingFrames)
+{
+	int supported;
+	nvg__lockFonts(ctx);
+	supported = fonsSetGlyphRasterizer(ctx->fs, submit, uptr, maxPendingFrames);
+	nvg__unlockFonts(ctx);
+	return supported;
+}
+
+void nvgRasterizeGlyph(NVGglyphJob* job)
+{
+	fonsRasterizeGlyphJob(job);
+}
+
+int nvgFinishGlyphs(NVGcontext* ctx, NVGglyphJob** jobs, int njobs)
+{
+	int added;
+	nvg__lockFonts(ctx);
+	added = fonsFinishGlyphJobs(ctx->fs, jobs, njobs);
+	nvg__unlockFonts(ctx);
+	return added;
+}
+
+void nvgDeleteGlyphJob(NVGglyphJob* job)
+{
+	fonsDeleteGlyphJob(job);
+}
+
+int nvgGlyphStalls(NVGcontext* ctx)
+{
+	int stalls;
+	nvg__lockFonts(ctx);
+	stalls = fonsGetGlyphStalls(ctx->fs);
+	nvg__unlockFonts(ctx);
+	return stalls;
+}
+
+int nvgGlyphPlaceholders(NVGcontext* ctx)
+{
+	return ctx->glyphPlaceholders;
+}
+
+static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts, int page)
 {
 	NVGstate* state = nvg__getState(ctx);
 	NVGpaint paint = state->fill;
 
+	// Upload the glyphs before the first draw that uses them.
+	nvg__flushTextTexture(ctx);
+
 	// Render triangles.
-	paint.image = ctx->fontImages[ctx->fontImageIdx];
+	paint.image = ctx->fontImages[page];
 
 	// Apply global alpha
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
-	ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts);
+	nvg__submitTriangles(ctx, &paint, state->compositeOperation, &state->scissor, verts, nverts);
 
 	ctx->drawCallCount++;
 	ctx->textTriCount += nverts/3;
 }
 
-float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+static float nvg__text(NVGcontext* ctx, float x, float y, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	NVGvertex* verts;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
 	int cverts = 0;
 	int nverts = 0;
+	int page = 0;
 
 	if (end == NULL)
 		end = string + strlen(string);
@@ -2451,6 +3168,7 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, state->fontSDF);
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
@@ -2459,22 +3177,21 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	if (verts == NULL) return x;
 
 	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED);
-	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
 		float c[4*2];
-		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
+		if (iter.prevGlyphIndex == -1) // all pages are in use by this frame
+			continue;
+		if (iter.page < 0) { // the glyph is still being rasterized
+			ctx->glyphPlaceholders++;
+			continue;
+		}
+		if (iter.page != page) {
 			if (nverts != 0) {
-				nvg__renderText(ctx, verts, nverts);
+				nvg__renderText(ctx, verts, nverts, page);
 				nverts = 0;
 			}
-			if (!nvg__allocTextAtlas(ctx))
-				break; // no memory :(
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-			if (iter.prevGlyphIndex == -1) // still can not find glyph?
-				break;
+			page = iter.page;
 		}
-		prevIter = iter;
 		// Transform corners.
 		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
 		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale, q.y0*invscale);
@@ -2491,14 +3208,31 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 		}
 	}
 
-	// TODO: add back-end bit to do this just once per frame.
-	nvg__flushTextTexture(ctx);
-
-	nvg__renderText(ctx, verts, nverts);
+	if (nverts != 0)
+		nvg__renderText(ctx, verts, nverts, page);
+	else
+		nvg__flushTextTexture(ctx);
 
 	return iter.nextx / scale;
 }
 
+float nvgTextScale(NVGcontext* ctx)
+{
+	return nvg__getFontScale(nvg__getState(ctx)) * ctx->devicePxRatio;
+}
+
+float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+	float nextx;
+	// Measuring contexts never rasterize glyphs into the atlas
+	if (ctx->fontMetrics)
+		return x + nvgTextBounds(ctx, x, y, string, end, NULL);
+	nvg__lockFonts(ctx);
+	nextx = nvg__text(ctx, x, y, string, end);
+	nvg__unlockFonts(ctx);
+	return nextx;
+}
+
 void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2532,12 +3266,12 @@ void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const ch
 	state->textAlign = oldAlign;
 }
 
-int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string, const char* end, NVGglyphPosition* positions, int maxPositions)
+static int nvg__textGlyphPositions(NVGcontext* ctx, float x, float y, const char* string, const char* end, NVGglyphPosition* positions, int maxPositions)
 {
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	int npos = 0;
 
@@ -2556,13 +3290,7 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 	fonsSetFont(ctx->fs, state->fontId);
 
 	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
-	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		if (iter.prevGlyphIndex < 0 && nvg__allocTextAtlas(ctx)) { // can not retrieve glyph?
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-		}
-		prevIter = iter;
 		positions[npos].str = iter.str;
 		positions[npos].x = iter.x * invscale;
 		positions[npos].minx = nvg__minf(iter.x, q.x0) * invscale;
@@ -2582,12 +3310,21 @@ enum NVGcodepointType {
 	NVG_CJK_CHAR,
 };
 
-int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
+int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string, const char* end, NVGglyphPosition* positions, int maxPositions)
+{
+	int npos;
+	nvg__lockFonts(ctx);
+	npos = nvg__textGlyphPositions(ctx, x, y, string, end, positions, maxPositions);
+	nvg__unlockFonts(ctx);
+	return npos;
+}
+
+static int nvg__textBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
 {
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	int nrows = 0;
 	float rowStartX = 0;
@@ -2622,13 +3359,7 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 	breakRowWidth *= scale;
 
 	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
-	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		if (iter.prevGlyphIndex < 0 && nvg__allocTextAtlas(ctx)) { // can not retrieve glyph?
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-		}
-		prevIter = iter;
 		switch (iter.codepoint) {
 			case 9:			// \t
 			case 11:		// \v
@@ -2788,6 +3519,15 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 	return nrows;
 }
 
+int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
+{
+	int nrows;
+	nvg__lockFonts(ctx);
+	nrows = nvg__textBreakLines(ctx, string, end, breakRowWidth, rows, maxRows);
+	nvg__unlockFonts(ctx);
+	return nrows;
+}
+
 float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2797,6 +3537,7 @@ float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const
 
 	if (state->fontId == FONS_INVALID) return 0;
 
+	nvg__lockFonts(ctx);
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
@@ -2804,9 +3545,11 @@ float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const
 	fonsSetFont(ctx->fs, state->fontId);
 
 	width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, bounds);
-	if (bounds != NULL) {
-		// Use line bounds for height.
+	// Use line bounds for height.
+	if (bounds != NULL)
 		fonsLineBounds(ctx->fs, y*scale, &bounds[1], &bounds[3]);
+	nvg__unlockFonts(ctx);
+	if (bounds != NULL) {
 		bounds[0] *= invscale;
 		bounds[1] *= invscale;
 		bounds[2] *= invscale;
@@ -2841,12 +3584,14 @@ void nvgTextBoxBounds(NVGcontext* ctx, float x, float y, float breakRowWidth, co
 	minx = maxx = x;
 	miny = maxy = y;
 
+	nvg__lockFonts(ctx);
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 	fonsLineBounds(ctx->fs, 0, &rminy, &rmaxy);
+	nvg__unlockFonts(ctx);
 	rminy *= invscale;
 	rmaxy *= invscale;
 
@@ -2892,6 +3637,7 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 
 	if (state->fontId == FONS_INVALID) return;
 
+	nvg__lockFonts(ctx);
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
@@ -2899,6 +3645,7 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 	fonsSetFont(ctx->fs, state->fontId);
 
 	fonsVertMetrics(ctx->fs, ascender, descender, lineh);
+	nvg__unlockFonts(ctx);
 	if (ascender != NULL)
 		*ascender *= invscale;
 	if (descender != NULL)
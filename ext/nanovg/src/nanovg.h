@@ -158,6 +158,7 @@ enum NVGimageFlags {
 	NVG_IMAGE_FLIPY				= 1<<3,		// Flips (inverses) image in Y direction when rendered.
 	NVG_IMAGE_PREMULTIPLIED		= 1<<4,		// Image data has premultiplied alpha.
 	NVG_IMAGE_NEAREST			= 1<<5,		// Image interpolation is Nearest instead Linear
+	NVG_IMAGE_SDF				= 1<<6,		// Alpha image holds signed distances, 0.5 on the edge.
 };
 
 // Begin drawing a new frame
@@ -454,6 +455,19 @@ extern NVG_EXPORT void nvgScissor(NVGcontext* ctx, float x, float y, float w, fl
 // transform space. The resulting shape is always rectangle.
 extern NVG_EXPORT void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h);
 
+// Same as nvgSave() followed by nvgIntersectScissor(), but cheaper: only the
+// transform and scissor are saved up front. The full state is copied only once
+// something else changes before the matching nvgPopClip(). Every nvgSave() in
+// between must be matched by an nvgRestore().
+extern NVG_EXPORT void nvgPushClip(NVGcontext* ctx, float x, float y, float w, float h);
+
+// Restores the state saved by the matching nvgPushClip().
+extern NVG_EXPORT void nvgPopClip(NVGcontext* ctx);
+
+// Stores the bounding box of the current scissor rectangle in the current
+// transform space to bounds as [x y w h]. Returns 0 if scissoring is disabled.
+extern NVG_EXPORT int nvgCurrentScissor(NVGcontext* ctx, float* bounds);
+
 // Reset and disables scissoring.
 extern NVG_EXPORT void nvgResetScissor(NVGcontext* ctx);
 
@@ -566,6 +580,71 @@ extern NVG_EXPORT int nvgCreateFont(NVGcontext* ctx, const char* name, const cha
 // Returns handle to the font.
 extern NVG_EXPORT int nvgCreateFontMem(NVGcontext* ctx, const char* name, unsigned char* data, int ndata, int freeData);
 
+// Seeds the glyph cache with glyphs rasterized ahead of time (see fonsAddBakedGlyphs()).
+// Only glyphs of already created fonts are added. Like all others, the glyphs are dropped
+// when their atlas page is evicted, and rasterized again when drawn. Returns the number
+// of glyphs added, or -1 if the baked atlas image does not fit into a font atlas page.
+extern NVG_EXPORT int nvgAddBakedGlyphs(NVGcontext* ctx, const unsigned char* data, int ndata);
+
+// Limits the memory of the font atlas, which holds glyphs in pages of 1024x1024 pixels.
+// Once the pages are full, the least recently drawn one is evicted to make room.
+// The default limit is 4 MB, at least one and at most 16 pages are used.
+extern NVG_EXPORT void nvgSetFontAtlasLimit(NVGcontext* ctx, int maxBytes);
+
+// Makes ctx use the fonts and font atlas of other, e.g. for several windows. Fonts created
+// through either context are available in both, and each glyph is rasterized once, while
+// every context uploads the atlas into textures of its own. The fonts of ctx are dropped,
+// so call this before creating any. Contexts sharing fonts must be used from one thread.
+// Returns 0 if ctx already shares the fonts of another context.
+extern NVG_EXPORT int nvgShareFonts(NVGcontext* ctx, NVGcontext* other);
+
+// Creates a context that measures text with the fonts of other, e.g. to lay out widgets on a
+// worker thread. Glyph metrics are looked up in, and added to, the glyph cache that other
+// draws from, so text measured ahead of time is not measured again when drawn. The font
+// atlas is left to the contexts that draw: nvgText() only returns x plus the advance of the
+// text, other drawing calls do nothing, and nvgBeginFrame() only resets the state and sets
+// the pixel ratio. A measuring context may be used by one thread at a time, concurrently
+// with the other contexts using the fonts, which are serialized on a lock held for each
+// text call. Create it after nvgShareFonts(), and delete it with nvgDeleteInternal()
+// before the last context drawing with the fonts.
+extern NVG_EXPORT NVGcontext* nvgCreateMetrics(NVGcontext* other);
+
+// Returns the font stash of the context, which contexts sharing their fonts and their
+// measuring contexts have in common.
+extern NVG_EXPORT struct FONScontext* nvgFontStash(NVGcontext* ctx);
+
+// Returns the scale from font sizes to the pixels text is rasterized at, which is the scale
+// of the current transform (quantized) times the device pixel ratio. Text metrics depend on it.
+extern NVG_EXPORT float nvgTextScale(NVGcontext* ctx);
+
+// Glyphs missing from the font atlas may be rasterized off the drawing thread (see
+// fonsSetGlyphRasterizer()). Each one is passed to submit() once, as a job to rasterize with
+// nvgRasterizeGlyph() on any thread, and to hand back to nvgFinishGlyphs() on the thread of the
+// context before it is deleted. In the meantime, text is drawn without the glyph for up to
+// maxPendingFrames frames, after which drawing rasterizes it itself. Display lists that recorded
+// text without some glyph are not valid. A NULL submit rasterizes glyphs when drawn, the default.
+// Returns 0 if the font backend can not rasterize concurrently.
+typedef struct FONSglyphJob NVGglyphJob;
+extern NVG_EXPORT int nvgSetGlyphRasterizer(NVGcontext* ctx, void (*submit)(void* uptr, NVGglyphJob* job), void* uptr, int maxPendingFrames);
+
+// Rasterizes the glyph of a job. Safe to call on any thread.
+extern NVG_EXPORT void nvgRasterizeGlyph(NVGglyphJob* job);
+
+// Packs the rasterized glyphs of the jobs into the font atlas and deletes the jobs. Each atlas
+// page is uploaded in a single update of the region that changed, when text is drawn next.
+// Returns the number of glyphs added.
+extern NVG_EXPORT int nvgFinishGlyphs(NVGcontext* ctx, NVGglyphJob** jobs, int njobs);
+
+// Deletes a job without adding its glyph.
+extern NVG_EXPORT void nvgDeleteGlyphJob(NVGglyphJob* job);
+
+// Returns the number of glyphs that drawing had to rasterize itself so far, each of which
+// stalled its frame.
+extern NVG_EXPORT int nvgGlyphStalls(NVGcontext* ctx);
+
+// Returns the number of glyphs left out of text so far, because they were not rasterized yet.
+extern NVG_EXPORT int nvgGlyphPlaceholders(NVGcontext* ctx);
+
 // Finds a loaded font of specified name, and returns handle to it, or -1 if the font is not found.
 extern NVG_EXPORT int nvgFindFont(NVGcontext* ctx, const char* name);
 
@@ -575,12 +654,23 @@ extern NVG_EXPORT int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fa
 // Adds a fallback font by name.
 extern NVG_EXPORT int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallbackFont);
 
+// Looks up which font of the fallback chain of the current font face has each codepoint of
+// the string. Each codepoint is resolved once per font chain, when first drawn or measured,
+// so this only moves that cost ahead, e.g. to when a label is set rather than when it is
+// first drawn. Returns the number of codepoints that no font of the chain has.
+extern NVG_EXPORT int nvgResolveText(NVGcontext* ctx, const char* string, const char* end);
+
 // Sets the font size of current text style.
 extern NVG_EXPORT void nvgFontSize(NVGcontext* ctx, float size);
 
 // Sets the blur of current text style.
 extern NVG_EXPORT void nvgFontBlur(NVGcontext* ctx, float blur);
 
+// Sets whether text is drawn from signed distance fields of the glyphs, which are
+// rasterized once and scaled to any font size, rather than from glyphs rasterized at
+// each size. Blurred text is always drawn from rasterized glyphs.
+extern NVG_EXPORT void nvgFontSDF(NVGcontext* ctx, int enabled);
+
 // Sets the letter spacing of current text style.
 extern NVG_EXPORT void nvgTextLetterSpacing(NVGcontext* ctx, float spacing);
 
@@ -628,6 +718,47 @@ extern NVG_EXPORT void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* d
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
 extern NVG_EXPORT int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows);
 
+//
+// Display lists
+//
+// A display list records the render calls (tessellated paths and text quads) issued
+// between nvgBeginDisplayList() and nvgEndDisplayList(), so that they can later be
+// submitted again without flattening, tessellating or shaping anything.
+// Recordings may be nested, and replaying a list while recording another one
+// records the replayed calls as well.
+
+typedef struct NVGdisplayList NVGdisplayList;
+
+// Creates an empty display list.
+extern NVG_EXPORT NVGdisplayList* nvgCreateDisplayList(void);
+
+// Deletes a display list.
+extern NVG_EXPORT void nvgDeleteDisplayList(NVGdisplayList* list);
+
+// Clears the list and starts recording into it. The current transform, scissor,
+// global alpha and device pixel ratio are remembered.
+extern NVG_EXPORT void nvgBeginDisplayList(NVGcontext* ctx, NVGdisplayList* list);
+
+// Stops the innermost recording. Returns 0 if the list could not be recorded
+// (e.g. because the font atlas was reset in the meantime, or glyphs were missing).
+extern NVG_EXPORT int nvgEndDisplayList(NVGcontext* ctx);
+
+// Stops adding render calls to the recordings that are currently active, e.g. while
+// drawing into an offscreen render target. Recordings started afterwards are not
+// affected. Returns a value that must be passed to nvgResumeDisplayLists().
+extern NVG_EXPORT int nvgSuspendDisplayLists(NVGcontext* ctx);
+
+// Undoes the matching nvgSuspendDisplayLists() call.
+extern NVG_EXPORT void nvgResumeDisplayLists(NVGcontext* ctx, int state);
+
+// Submits the recorded calls again, translated by (x,y) in local coordinates plus the
+// difference between the current and the recorded transform. The current scissor must
+// equal the recorded one moved by the same amount. Returns 0 without drawing anything
+// if the list is invalid or the state differs in any other way (scale, rotation,
+// scissor, global alpha, device pixel ratio, font atlas); the caller must then draw
+// (and possibly re-record) the content itself.
+extern NVG_EXPORT int nvgReplayDisplayList(NVGcontext* ctx, NVGdisplayList* list, float x, float y);
+
 //
 // Internal Render API
 //
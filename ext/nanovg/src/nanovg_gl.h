@@ -61,9 +61,17 @@ enum NVGcreateFlags {
 NVGcontext* nvgCreateGL2(int flags);
 void nvgDeleteGL2(NVGcontext* ctx);
 
+// Creates a context whose GL context shares objects with the one of share, so that
+// it reuses the shader program of share and its fonts (see nvgShareFonts()).
+NVGcontext* nvgCreateSharedGL2(NVGcontext* share, int flags);
+
 int nvglCreateImageFromHandleGL2(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGL2(NVGcontext* ctx, int image);
 
+// Restricts all subsequent rendering to a framebuffer rectangle (pixels, origin
+// at the bottom left) using the GL scissor test. Pass w < 0 to disable.
+void nvglScissorRectGL2(NVGcontext* ctx, int x, int y, int w, int h);
+
 #endif
 
 #if defined NANOVG_GL3
@@ -71,9 +79,17 @@ GLuint nvglImageHandleGL2(NVGcontext* ctx, int image);
 NVGcontext* nvgCreateGL3(int flags);
 void nvgDeleteGL3(NVGcontext* ctx);
 
+// Creates a context whose GL context shares objects with the one of share, so that
+// it reuses the shader program of share and its fonts (see nvgShareFonts()).
+NVGcontext* nvgCreateSharedGL3(NVGcontext* share, int flags);
+
 int nvglCreateImageFromHandleGL3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGL3(NVGcontext* ctx, int image);
 
+// Restricts all subsequent rendering to a framebuffer rectangle (pixels, origin
+// at the bottom left) using the GL scissor test. Pass w < 0 to disable.
+void nvglScissorRectGL3(NVGcontext* ctx, int x, int y, int w, int h);
+
 #endif
 
 #if defined NANOVG_GLES2
@@ -81,9 +97,17 @@ GLuint nvglImageHandleGL3(NVGcontext* ctx, int image);
 NVGcontext* nvgCreateGLES2(int flags);
 void nvgDeleteGLES2(NVGcontext* ctx);
 
+// Creates a context whose GL context shares objects with the one of share, so that
+// it reuses the shader program of share and its fonts (see nvgShareFonts()).
+NVGcontext* nvgCreateSharedGLES2(NVGcontext* share, int flags);
+
 int nvglCreateImageFromHandleGLES2(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGLES2(NVGcontext* ctx, int image);
 
+// Restricts all subsequent rendering to a framebuffer rectangle (pixels, origin
+// at the bottom left) using the GL scissor test. Pass w < 0 to disable.
+void nvglScissorRectGLES2(NVGcontext* ctx, int x, int y, int w, int h);
+
 #endif
 
 #if defined NANOVG_GLES3
@@ -91,9 +115,17 @@ GLuint nvglImageHandleGLES2(NVGcontext* ctx, int image);
 NVGcontext* nvgCreateGLES3(int flags);
 void nvgDeleteGLES3(NVGcontext* ctx);
 
+// Creates a context whose GL context shares objects with the one of share, so that
+// it reuses the shader program of share and its fonts (see nvgShareFonts()).
+NVGcontext* nvgCreateSharedGLES3(NVGcontext* share, int flags);
+
 int nvglCreateImageFromHandleGLES3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image);
 
+// Restricts all subsequent rendering to a framebuffer rectangle (pixels, origin
+// at the bottom left) using the GL scissor test. Pass w < 0 to disable.
+void nvglScissorRectGLES3(NVGcontext* ctx, int x, int y, int w, int h);
+
 #endif
 
 // These are additional flags on top of NVGimageFlags.
@@ -232,6 +264,8 @@ typedef struct GLNVGfragUniforms GLNVGfragUniforms;
 
 struct GLNVGcontext {
 	GLNVGshader shader;
+	int* shaderRefs;	// Contexts using the shader program, which they share
+	struct GLNVGcontext* share;	// Context to share the program of, while creating
 	GLNVGtexture* textures;
 	float view[2];
 	int ntextures;
@@ -246,6 +280,7 @@ struct GLNVGcontext {
 #endif
 	int fragSize;
 	int flags;
+	int scissorRect[4];
 
 	// Per frame buffers
 	GLNVGcall* calls;
@@ -616,6 +651,15 @@ static int glnvg__renderCreate(void* uptr)
 		"	sc = vec2(0.5,0.5) - sc * scissorScale;\n"
 		"	return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);\n"
 		"}\n"
+		"// Coverage from a signed distance field, antialiased over about one pixel.\n"
+		"float sdfMask(float d) {\n"
+		"#ifdef NANOVG_GL3\n"
+		"	float w = 0.7 * fwidth(d);\n"
+		"#else\n"
+		"	float w = 0.1;\n"
+		"#endif\n"
+		"	return smoothstep(0.5 - w, 0.5 + w, d);\n"
+		"}\n"
 		"#ifdef EDGE_AA\n"
 		"// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.\n"
 		"float strokeMask() {\n"
@@ -650,6 +694,7 @@ static int glnvg__renderCreate(void* uptr)
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
 		"		if (texType == 2) color = vec4(color.x);"
+		"		if (texType == 3) color = vec4(sdfMask(color.x));"
 		"		// Apply color tint and alpha.\n"
 		"		color *= innerCol;\n"
 		"		// Combine alpha\n"
@@ -665,6 +710,7 @@ static int glnvg__renderCreate(void* uptr)
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
 		"		if (texType == 2) color = vec4(color.x);"
+		"		if (texType == 3) color = vec4(sdfMask(color.x));"
 		"		color *= scissor;\n"
 		"		result = color * innerCol;\n"
 		"	}\n"
@@ -677,16 +723,29 @@ static int glnvg__renderCreate(void* uptr)
 
 	glnvg__checkError(gl, "init");
 
-	if (gl->flags & NVG_ANTIALIAS) {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, "#define EDGE_AA 1\n", fillVertShader, fillFragShader) == 0)
-			return 0;
+	if (gl->share != NULL && gl->share->shaderRefs != NULL &&
+		(gl->share->flags & NVG_ANTIALIAS) == (gl->flags & NVG_ANTIALIAS)) {
+		// The GL contexts share objects, the program is compiled already
+		gl->shader = gl->share->shader;
+		gl->shaderRefs = gl->share->shaderRefs;
+		(*gl->shaderRefs)++;
 	} else {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, NULL, fillVertShader, fillFragShader) == 0)
-			return 0;
-	}
+		if (gl->flags & NVG_ANTIALIAS) {
+			if (glnvg__createShader(&gl->shader, "shader", shaderHeader, "#define EDGE_AA 1\n", fillVertShader, fillFragShader) == 0)
+				return 0;
+		} else {
+			if (glnvg__createShader(&gl->shader, "shader", shaderHeader, NULL, fillVertShader, fillFragShader) == 0)
+				return 0;
+		}
+
+		glnvg__checkError(gl, "uniform locations");
+		glnvg__getUniforms(&gl->shader);
 
-	glnvg__checkError(gl, "uniform locations");
-	glnvg__getUniforms(&gl->shader);
+		gl->shaderRefs = (int*)malloc(sizeof(int));
+		if (gl->shaderRefs != NULL)
+			*gl->shaderRefs = 1;
+	}
+	gl->share = NULL;
 
 	// Create dynamic vertex array
 #if defined NANOVG_GL3
@@ -951,12 +1010,12 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 		if (tex->type == NVG_TEXTURE_RGBA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
 		else
-			frag->texType = 2;
+			frag->texType = (tex->flags & NVG_IMAGE_SDF) ? 3 : 2;
 		#else
 		if (tex->type == NVG_TEXTURE_RGBA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0.0f : 1.0f;
 		else
-			frag->texType = 2.0f;
+			frag->texType = (tex->flags & NVG_IMAGE_SDF) ? 3.0f : 2.0f;
 		#endif
 //		printf("frag->texType = %d\n", frag->texType);
 	} else {
@@ -1182,7 +1241,12 @@ static void glnvg__renderFlush(void* uptr)
 		glFrontFace(GL_CCW);
 		glEnable(GL_BLEND);
 		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_SCISSOR_TEST);
+		if (gl->scissorRect[2] >= 0) {
+			glEnable(GL_SCISSOR_TEST);
+			glScissor(gl->scissorRect[0], gl->scissorRect[1], gl->scissorRect[2], gl->scissorRect[3]);
+		} else {
+			glDisable(GL_SCISSOR_TEST);
+		}
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glStencilMask(0xffffffff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
@@ -1523,7 +1587,10 @@ static void glnvg__renderDelete(void* uptr)
 	int i;
 	if (gl == NULL) return;
 
-	glnvg__deleteShader(&gl->shader);
+	if (gl->shaderRefs == NULL || --(*gl->shaderRefs) == 0) {
+		glnvg__deleteShader(&gl->shader);
+		free(gl->shaderRefs);
+	}
 
 #if NANOVG_GL3
 #if NANOVG_GL_USE_UNIFORMBUFFER
@@ -1551,21 +1618,14 @@ static void glnvg__renderDelete(void* uptr)
 }
 
 
-#if defined NANOVG_GL2
-NVGcontext* nvgCreateGL2(int flags)
-#elif defined NANOVG_GL3
-NVGcontext* nvgCreateGL3(int flags)
-#elif defined NANOVG_GLES2
-NVGcontext* nvgCreateGLES2(int flags)
-#elif defined NANOVG_GLES3
-NVGcontext* nvgCreateGLES3(int flags)
-#endif
+static NVGcontext* glnvg__create(int flags, GLNVGcontext* share)
 {
 	NVGparams params;
 	NVGcontext* ctx = NULL;
 	GLNVGcontext* gl = (GLNVGcontext*)malloc(sizeof(GLNVGcontext));
 	if (gl == NULL) goto error;
 	memset(gl, 0, sizeof(GLNVGcontext));
+	gl->scissorRect[2] = -1;
 
 	memset(&params, 0, sizeof(params));
 	params.renderCreate = glnvg__renderCreate;
@@ -1584,6 +1644,7 @@ NVGcontext* nvgCreateGLES3(int flags)
 	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
 
 	gl->flags = flags;
+	gl->share = share;
 
 	ctx = nvgCreateInternal(&params);
 	if (ctx == NULL) goto error;
@@ -1596,6 +1657,19 @@ error:
 	return NULL;
 }
 
+#if defined NANOVG_GL2
+NVGcontext* nvgCreateGL2(int flags)
+#elif defined NANOVG_GL3
+NVGcontext* nvgCreateGL3(int flags)
+#elif defined NANOVG_GLES2
+NVGcontext* nvgCreateGLES2(int flags)
+#elif defined NANOVG_GLES3
+NVGcontext* nvgCreateGLES3(int flags)
+#endif
+{
+	return glnvg__create(flags, NULL);
+}
+
 #if defined NANOVG_GL2
 void nvgDeleteGL2(NVGcontext* ctx)
 #elif defined NANOVG_GL3
@@ -1609,6 +1683,22 @@ void nvgDeleteGLES3(NVGcontext* ctx)
 	nvgDeleteInternal(ctx);
 }
 
+#if defined NANOVG_GL2
+NVGcontext* nvgCreateSharedGL2(NVGcontext* share, int flags)
+#elif defined NANOVG_GL3
+NVGcontext* nvgCreateSharedGL3(NVGcontext* share, int flags)
+#elif defined NANOVG_GLES2
+NVGcontext* nvgCreateSharedGLES2(NVGcontext* share, int flags)
+#elif defined NANOVG_GLES3
+NVGcontext* nvgCreateSharedGLES3(NVGcontext* share, int flags)
+#endif
+{
+	NVGcontext* ctx = glnvg__create(flags, (GLNVGcontext*)nvgInternalParams(share)->userPtr);
+	if (ctx != NULL)
+		nvgShareFonts(ctx, share);
+	return ctx;
+}
+
 #if defined NANOVG_GL2
 int nvglCreateImageFromHandleGL2(NVGcontext* ctx, GLuint textureId, int w, int h, int imageFlags)
 #elif defined NANOVG_GL3
@@ -1648,4 +1738,21 @@ GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image)
 	return tex->tex;
 }
 
+#if defined NANOVG_GL2
+void nvglScissorRectGL2(NVGcontext* ctx, int x, int y, int w, int h)
+#elif defined NANOVG_GL3
+void nvglScissorRectGL3(NVGcontext* ctx, int x, int y, int w, int h)
+#elif defined NANOVG_GLES2
+void nvglScissorRectGLES2(NVGcontext* ctx, int x, int y, int w, int h)
+#elif defined NANOVG_GLES3
+void nvglScissorRectGLES3(NVGcontext* ctx, int x, int y, int w, int h)
+#endif
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	gl->scissorRect[0] = x;
+	gl->scissorRect[1] = y;
+	gl->scissorRect[2] = w;
+	gl->scissorRect[3] = h;
+}
+
 #endif /* NANOVG_GL_IMPLEMENTATION */
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <waylandgui/widget.h>
+#include <waylandgui/textlayout.h>
 
 NAMESPACE_BEGIN(waylandgui)
 /**
@@ -59,7 +60,12 @@ public:
     const std::string &caption() const { return m_caption; }
 
     /// Sets the caption of this Button.
-    void set_caption(const std::string &caption) { m_caption = caption; }
+    void set_caption(const std::string &caption) {
+        if (caption != m_caption) {
+            m_caption = caption;
+            invalidate_layout();
+        }
+    }
 
     /// Returns the background color of this Button.
     const Color &background_color() const { return m_background_color; }
@@ -74,7 +80,12 @@ public:
     /// Returns the icon of this Button.  See \ref waylandgui::Button::m_icon.
     int icon() const { return m_icon; }
     /// Sets the icon of this Button.  See \ref waylandgui::Button::m_icon.
-    void set_icon(int icon) { m_icon = icon; }
+    void set_icon(int icon) {
+        if (icon != m_icon) {
+            m_icon = icon;
+            invalidate_layout();
+        }
+    }
 
     /// The current flags of this Button (see \ref waylandgui::Button::Flags for options).
     int flags() const { return m_flags; }
@@ -114,6 +125,9 @@ public:
     /// Responsible for drawing the Button.
     virtual void draw(NVGcontext *ctx) override;
 protected:
+    /// Measure the caption and font icon unless they are unchanged since the last call
+    void update_text_layout(NVGcontext *ctx) const;
+
     /// The caption of this Button.
     std::string m_caption;
 
@@ -153,6 +167,9 @@ protected:
 
     /// The button group for radio buttons.
     std::vector<Button *> m_button_group;
+
+    /// The measured caption and font icon.
+    mutable TextLayout m_text_layout, m_icon_layout;
 };
 
 NAMESPACE_END(waylandgui)
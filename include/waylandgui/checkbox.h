@@ -52,7 +52,12 @@ public:
    const std::string &caption() const { return m_caption; }
 
     /// Sets the caption of this CheckBox.
-    void set_caption(const std::string &caption) { m_caption = caption; }
+    void set_caption(const std::string &caption) {
+        if (caption != m_caption) {
+            m_caption = caption;
+            invalidate_layout();
+        }
+    }
 
     /// Whether or not this CheckBox is currently checked.
     const bool &checked() const { return m_checked; }
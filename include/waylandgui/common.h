@@ -16,7 +16,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <cstddef>
 #include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -88,6 +92,8 @@
 extern "C" {
     /* Opaque handle types */
     typedef struct NVGcontext NVGcontext;
+    typedef struct NVGdisplayList NVGdisplayList;
+    typedef struct FONSglyphJob NVGglyphJob;
     typedef struct GLFWwindow GLFWwindow;
 }
 
@@ -118,6 +124,7 @@ enum class Cursor {
 /* Forward declarations */
 template <typename T> class ref;
 class AdvancedGridLayout;
+class BackgroundTask;
 class BoxLayout;
 class Button;
 class CheckBox;
@@ -132,6 +139,7 @@ class GroupLayout;
 class ImagePanel;
 class ImageView;
 class Label;
+class LayerCache;
 class Layout;
 class MessageDialog;
 class Object;
@@ -139,14 +147,17 @@ class Popup;
 class PopupButton;
 class ProgressBar;
 class RenderPass;
+class ResourceGroup;
 class Shader;
 class Screen;
 class Serializer;
 class Slider;
+class SpatialIndex;
 class TabWidgetBase;
 class TabWidget;
 class TextBox;
 class TextArea;
+class TextLayout;
 class Texture;
 class Theme;
 class ToolButton;
@@ -179,7 +190,9 @@ extern WAYLANDGUI_EXPORT void shutdown();
  *     NanoGUI issues a redraw call whenever an keyboard/mouse/.. event is
  *     received. In the absence of any external events, it enforces a redraw
  *     once every ``refresh`` milliseconds. To disable the refresh timer,
- *     specify a negative value here.
+ *     specify a negative value here. In that case, the main loop sleeps
+ *     until an event arrives or a timer registered via \ref add_timer()
+ *     expires.
  *
  * \param detach
  *     This parameter only exists in the Python bindings. When the active
@@ -216,14 +229,144 @@ extern WAYLANDGUI_EXPORT void leave();
 /// Return whether or not a main loop is currently active
 extern WAYLANDGUI_EXPORT bool active();
 
+/**
+ * \class Task common.h waylandgui/common.h
+ *
+ * \brief Move-only function object without arguments or return value.
+ *
+ * Unlike ``std::function``, a Task can wrap move-only callables (e.g. lambdas
+ * capturing a ``std::unique_ptr``). Callables of up to \ref InlineSize bytes
+ * are stored within the Task itself, larger ones are allocated on the heap.
+ */
+class Task {
+public:
+    /// Size of the small-buffer storage
+    static constexpr size_t InlineSize = 48;
+
+    /// Create an empty task
+    Task() = default;
+
+    /// Wrap an arbitrary callable
+    template <typename Func, typename F = std::decay_t<Func>,
+              std::enable_if_t<!std::is_same_v<F, Task>, int> = 0>
+    Task(Func &&func) {
+        if constexpr (sizeof(F) <= InlineSize &&
+                      alignof(F) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<F>) {
+            new (m_storage) F(std::forward<Func>(func));
+            m_ops = &inline_ops<F>;
+        } else {
+            *reinterpret_cast<F **>(m_storage) = new F(std::forward<Func>(func));
+            m_ops = &heap_ops<F>;
+        }
+    }
+
+    Task(Task &&task) noexcept : m_ops(task.m_ops) {
+        if (m_ops) {
+            m_ops->move(m_storage, task.m_storage);
+            task.m_ops = nullptr;
+        }
+    }
+
+    Task &operator=(Task &&task) noexcept {
+        if (this != &task) {
+            reset();
+            m_ops = task.m_ops;
+            if (m_ops) {
+                m_ops->move(m_storage, task.m_storage);
+                task.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() { reset(); }
+
+    /// Release the wrapped callable
+    void reset() {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    /// Does this task wrap a callable?
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    /// Invoke the wrapped callable
+    void operator()() { m_ops->invoke(m_storage); }
+
+private:
+    struct Ops {
+        void (*invoke)(void *);
+        void (*move)(void *, void *);
+        void (*destroy)(void *);
+    };
+
+    template <typename F> static constexpr Ops inline_ops = {
+        [](void *p) { (*static_cast<F *>(p))(); },
+        [](void *dst, void *src) {
+            new (dst) F(std::move(*static_cast<F *>(src)));
+            static_cast<F *>(src)->~F();
+        },
+        [](void *p) { static_cast<F *>(p)->~F(); }
+    };
+
+    template <typename F> static constexpr Ops heap_ops = {
+        [](void *p) { (**static_cast<F **>(p))(); },
+        [](void *dst, void *src) { *static_cast<F **>(dst) = *static_cast<F **>(src); },
+        [](void *p) { delete *static_cast<F **>(p); }
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[InlineSize];
+    const Ops *m_ops = nullptr;
+};
+
 /**
  * \brief Enqueue a function to be executed executed before
  * the application is redrawn the next time.
  *
  * NanoGUI is not thread-safe, and async() provides a mechanism
  * for queuing up UI-related state changes from other threads.
+ *
+ * The queue is lock-free, so producers never block on the main loop
+ * thread, and the main loop is only woken up when the queue goes from
+ * empty to non-empty. Tasks run in the order in which they were queued,
+ * and a task may itself call async() (the new task runs on the next
+ * iteration of the main loop).
  */
-extern WAYLANDGUI_EXPORT void async(const std::function<void()> &func);
+extern WAYLANDGUI_EXPORT void async(Task task);
+
+/**
+ * \brief Schedule a function to be executed by the main loop after
+ * ``delay`` milliseconds.
+ *
+ * Timers are serviced on the main loop thread, so the callback may safely
+ * modify the user interface. The main loop only wakes up for the earliest
+ * pending deadline and blocks indefinitely when no timer is registered.
+ * This function may be called from any thread.
+ *
+ * \param delay
+ *     Delay in milliseconds until the first invocation
+ *
+ * \param func
+ *     Function to be invoked
+ *
+ * \param periodic
+ *     Set to ``true`` to re-arm the timer every ``delay`` milliseconds
+ *     until it is removed via \ref remove_timer().
+ *
+ * \return
+ *     A nonzero timer identifier
+ */
+extern WAYLANDGUI_EXPORT uint32_t add_timer(float delay, const std::function<void()> &func,
+                                            bool periodic = false);
+
+/// Cancel a timer registered via \ref add_timer() (has no effect if it already fired)
+extern WAYLANDGUI_EXPORT void remove_timer(uint32_t id);
 
 /**
  * \brief Open a native file open/save dialog.
@@ -286,6 +429,21 @@ extern WAYLANDGUI_EXPORT std::string utf8(uint32_t c);
 extern WAYLANDGUI_EXPORT std::vector<std::pair<int, std::string>>
     load_image_directory(NVGcontext *ctx, const std::string &path);
 
+/**
+ * \brief Load a directory of PNG images without blocking the main loop
+ *
+ * The images are decoded by the background worker pool and uploaded on the
+ * main loop thread, after which \c callback receives the same data as
+ * \ref load_image_directory() would return. If \c owner is not
+ * \c nullptr, loading is cancelled when this widget is destroyed.
+ *
+ * \return A handle of type \ref BackgroundTask that can be used to cancel loading
+ */
+extern WAYLANDGUI_EXPORT ref<BackgroundTask>
+    load_image_directory_async(NVGcontext *ctx, const std::string &path,
+                               const std::function<void(std::vector<std::pair<int, std::string>>)> &callback,
+                               Widget *owner = nullptr);
+
 /// Convenience function for instanting a PNG icon from the application's data segment (via bin2c)
 #define nvgImageIcon(ctx, name) waylandgui::__waylandgui_get_image(ctx, #name, name##_png, name##_png_size)
 /// Helper function used by nvg_image_icon
@@ -0,0 +1,56 @@
+/*
+    waylandgui/damage.h -- Set of screen rectangles that need to be redrawn
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/vector.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class DamageRegion damage.h waylandgui/damage.h
+ *
+ * \brief Approximates the union of a number of damaged rectangles.
+ *
+ * Overlapping and adjacent rectangles are merged when the merged rectangle
+ * is not much larger than its parts. The region never holds more than
+ * \ref MaxRects rectangles; beyond that, it degrades to its bounding box.
+ * Rectangles are stored as ``(x, y, width, height)``.
+ */
+class WAYLANDGUI_EXPORT DamageRegion {
+public:
+    /// Maximum number of rectangles kept before collapsing to the bounding box
+    static constexpr size_t MaxRects = 8;
+
+    /// Add a rectangle to the region
+    void add(const Vector2i &pos, const Vector2i &size);
+
+    /// Add all rectangles of another region
+    void add(const DamageRegion &other);
+
+    /// Remove all rectangles
+    void clear() { m_rects.clear(); }
+
+    /// Is the region empty?
+    bool empty() const { return m_rects.empty(); }
+
+    /// Return the rectangles making up the region
+    const std::vector<Vector4i> &rects() const { return m_rects; }
+
+    /// Return the bounding box of the region
+    Vector4i bounds() const;
+
+protected:
+    std::vector<Vector4i> m_rects;
+};
+
+NAMESPACE_END(waylandgui)
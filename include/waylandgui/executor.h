@@ -0,0 +1,141 @@
+/*
+    waylandgui/executor.h -- Background worker pool with main-thread continuations
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/object.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/// Scheduling priority of a \ref BackgroundTask
+enum class TaskPriority : uint8_t {
+    Low = 0, ///< Prefetching and other speculative work
+    Normal,  ///< Default priority
+    High     ///< Work that the user is currently waiting for
+};
+
+/**
+ * \class BackgroundTask executor.h waylandgui/executor.h
+ *
+ * \brief Handle to a unit of work submitted via \ref run_in_background().
+ *
+ * Cancelling a task drops it from the queue if it has not started yet, and
+ * suppresses its continuation otherwise. Work that is already running is
+ * not interrupted, but may poll \ref cancelled() to finish early.
+ */
+class WAYLANDGUI_EXPORT BackgroundTask : public Object {
+public:
+    BackgroundTask(TaskPriority priority = TaskPriority::Normal)
+        : m_priority(priority) { }
+
+    /// Return the scheduling priority
+    TaskPriority priority() const { return m_priority; }
+
+    /// Request cancellation of the task (may be called from any thread)
+    void cancel() { m_cancelled = true; }
+
+    /// Has cancellation been requested?
+    bool cancelled() const { return m_cancelled; }
+
+    /// Did the task (including its continuation) run to completion or get dropped?
+    bool finished() const { return m_finished; }
+
+    /// Mark the task as finished (used by the worker pool)
+    void set_finished() { m_finished = true; }
+
+protected:
+    TaskPriority m_priority;
+    std::atomic<bool> m_cancelled { false };
+    std::atomic<bool> m_finished { false };
+};
+
+/**
+ * \brief Enqueue a function on the background worker pool.
+ *
+ * This is the low-level entry point used by \ref run_in_background(). The
+ * worker pool is started on first use; it holds a reference to \c task until
+ * \c work has run or was dropped due to cancellation. \c work (or the
+ * continuation it schedules) is responsible for calling
+ * \ref BackgroundTask::set_finished() unless the task was cancelled.
+ * Exceptions thrown by \c work are reported on ``stderr`` and cancel the task.
+ *
+ * \param owner
+ *     If not \c nullptr, the task is cancelled when this widget is
+ *     destroyed. The call must then be made from the main loop thread.
+ */
+extern WAYLANDGUI_EXPORT void submit_background(BackgroundTask *task, Task work,
+                                                Widget *owner = nullptr);
+
+/**
+ * \brief Run \c work on a background thread and pass its result to \c then
+ * on the main loop thread.
+ *
+ * \c then is invoked via \ref async() and is skipped if the task was
+ * cancelled in the meantime, so it may safely access the \c owner widget.
+ * The task is finished once \c then returns or throws. Exceptions thrown by
+ * \c then propagate on the main loop thread like those of any other
+ * \ref async() function, which reports them on ``stderr``.
+ *
+ * \rst
+ * .. code-block:: cpp
+ *
+ *    run_in_background(
+ *        [path]() { return decode_image(path); },
+ *        [this](Image image) { set_image(std::move(image)); },
+ *        TaskPriority::High, this);
+ * \endrst
+ */
+template <typename Work, typename Then>
+ref<BackgroundTask> run_in_background(Work &&work, Then &&then,
+                                      TaskPriority priority = TaskPriority::Normal,
+                                      Widget *owner = nullptr) {
+    using Result = std::invoke_result_t<std::decay_t<Work> &>;
+    ref<BackgroundTask> task = new BackgroundTask(priority);
+
+    submit_background(task, [task = task, work = std::forward<Work>(work),
+                             then = std::forward<Then>(then)]() mutable {
+        if constexpr (std::is_void_v<Result>) {
+            work();
+            if (task->cancelled())
+                return;
+            async([task = std::move(task), then = std::move(then)]() mutable {
+                try {
+                    if (!task->cancelled())
+                        then();
+                } catch (...) {
+                    task->set_finished();
+                    throw;
+                }
+                task->set_finished();
+            });
+        } else {
+            Result result = work();
+            if (task->cancelled())
+                return;
+            async([task = std::move(task), then = std::move(then),
+                   result = std::move(result)]() mutable {
+                try {
+                    if (!task->cancelled())
+                        then(std::move(result));
+                } catch (...) {
+                    task->set_finished();
+                    throw;
+                }
+                task->set_finished();
+            });
+        }
+    }, owner);
+
+    return task;
+}
+
+NAMESPACE_END(waylandgui)
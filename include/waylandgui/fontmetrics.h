@@ -0,0 +1,124 @@
+/*
+    waylandgui/fontmetrics.h -- Measures text with the fonts of a screen on
+    any thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class FontMetrics fontmetrics.h waylandgui/fontmetrics.h
+ *
+ * \brief Lends NanoVG contexts that measure text with the fonts of a screen
+ * to other threads (see \ref Screen::font_metrics()).
+ *
+ * This moves layout work off the thread that draws, e.g. \ref
+ * Widget::preferred_size() of windows that are not shown yet, or \ref
+ * TextArea::measure() of a large amount of text, on the background worker
+ * pool. The lent contexts take all NanoVG calls that measure text, while
+ * drawing calls do nothing (see <tt>nvgCreateMetrics()</tt>). Glyph metrics
+ * are looked up in and added to the glyph cache that the screen draws from,
+ * so text that was measured ahead of time is not measured again when drawn.
+ *
+ * Each text call of NanoVG holds the lock of the font stash, which
+ * serializes measuring with drawing text, but never for longer than the
+ * call. Contexts are kept for reuse once returned. Detaching, e.g. when the
+ * screen is destroyed, waits for the contexts that are lent out.
+ *
+ * \rst
+ * .. code-block:: cpp
+ *
+ *    FontMetrics &metrics = screen->font_metrics();
+ *    float pixel_ratio = screen->pixel_ratio(), size = area->font_size();
+ *    run_in_background(
+ *        [&metrics, pixel_ratio, size, log = std::move(log)]() {
+ *            FontMetrics::Context ctx = metrics.acquire(pixel_ratio);
+ *            return TextArea::measure(ctx, log, "sans", size);
+ *        },
+ *        [area](const TextArea::MeasuredText &text) { area->append(text); },
+ *        TaskPriority::Normal, area);
+ * \endrst
+ */
+class WAYLANDGUI_EXPORT FontMetrics {
+public:
+    /// Measuring context lent to one thread, which is returned when destroyed
+    class Context {
+    public:
+        Context(Context &&other) : m_metrics(other.m_metrics), m_ctx(other.m_ctx) {
+            other.m_ctx = nullptr;
+        }
+        Context(const Context &) = delete;
+        Context &operator=(const Context &) = delete;
+        ~Context();
+
+        /// Return the NanoVG context
+        NVGcontext *get() const { return m_ctx; }
+        operator NVGcontext *() const { return m_ctx; }
+
+    protected:
+        friend class FontMetrics;
+        Context(FontMetrics *metrics, NVGcontext *ctx) : m_metrics(metrics), m_ctx(ctx) { }
+
+    protected:
+        FontMetrics *m_metrics;
+        NVGcontext *m_ctx;
+    };
+
+    FontMetrics() = default;
+    FontMetrics(const FontMetrics &) = delete;
+    FontMetrics &operator=(const FontMetrics &) = delete;
+    ~FontMetrics();
+
+    /// Measure with the fonts of \c ctx, called on the thread that draws with it
+    void attach(NVGcontext *ctx);
+
+    /// Wait for the contexts lent out to be returned, then delete all contexts
+    void detach();
+
+    /// Are fonts attached?
+    bool attached() const;
+
+    /**
+     * \brief Lend a measuring context to the calling thread
+     *
+     * Its state is reset, as at the start of a frame.
+     *
+     * \param pixel_ratio
+     *     Pixel ratio of the screen that draws the text, so that it is
+     *     measured at the size at which it is drawn
+     *
+     * Throws \c std::runtime_error if no fonts are attached.
+     */
+    Context acquire(float pixel_ratio = 1.f);
+
+    /// Return the number of contexts, lent out or not
+    size_t contexts() const;
+
+protected:
+    /// Take back a context lent out by \ref acquire()
+    void release(NVGcontext *ctx);
+
+protected:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    /// Context that the lent ones are created from, which is never lent itself
+    NVGcontext *m_origin = nullptr;
+    std::vector<NVGcontext *> m_idle;
+    size_t m_lent = 0;
+};
+
+NAMESPACE_END(waylandgui)
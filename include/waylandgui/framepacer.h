@@ -0,0 +1,127 @@
+/*
+    waylandgui/framepacer.h -- Decides when a Screen may start its next frame
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class FramePacer framepacer.h waylandgui/framepacer.h
+ *
+ * \brief Paces the frames of a \ref Screen to the display refresh and an
+ * optional frame rate cap.
+ *
+ * Frames are only ever started when the screen needs to be redrawn. The
+ * pacer merely determines the earliest point in time at which this may
+ * happen, based on when the previous frame reached the display.
+ */
+class WAYLANDGUI_EXPORT FramePacer {
+public:
+    enum class Mode {
+        /// Swap interval 0: present frames immediately (may tear or be discarded)
+        Immediate,
+
+        /**
+         * Swap interval 0, but frames start at least one refresh period of
+         * the display apart, using a timer of the main loop. The buffer
+         * swap never blocks, so a hidden window or another screen cannot
+         * hold up the main loop. If the display does not report its refresh
+         * rate, e.g. a headless or nested output, frames are paced to \ref
+         * nominal_refresh_rate.
+         */
+        Timed,
+
+        /**
+         * Swap interval 1: the buffer swap waits for the next vertical
+         * blank. On Wayland, this is driven by the compositor's frame
+         * callbacks, so the swap blocks the main loop for as long as the
+         * window is hidden or occluded, and the swaps of several screens
+         * wait for each other.
+         */
+        VSync,
+
+        /**
+         * Swap interval 0, but frames are paced to a simulated vertical
+         * blank clock running at \ref refresh_rate(). A frame is considered
+         * presented at the first simulated vertical blank following its
+         * buffer swap, and at most one frame is started per vertical blank.
+         * Combined with \ref set_clock(), this allows checking the pacing
+         * logic without a display.
+         */
+        Simulated
+    };
+
+    /// Refresh rate that \ref Mode::Timed paces to when that of the display is unknown
+    static constexpr double nominal_refresh_rate = 60.0;
+
+    FramePacer(Mode mode = Mode::Timed) : m_mode(mode) { }
+
+    /// Return the pacing mode
+    Mode mode() const { return m_mode; }
+    /// Set the pacing mode (use \ref Screen::set_frame_pacing() for screens)
+    void set_mode(Mode mode) { m_mode = mode; }
+
+    /// Return the display refresh rate in Hz (0 if unknown)
+    double refresh_rate() const { return m_refresh_rate; }
+    /// Set the display refresh rate in Hz
+    void set_refresh_rate(double rate) { m_refresh_rate = rate; }
+
+    /// Return the frame rate cap in frames per second (0: no cap)
+    float max_fps() const { return m_max_fps; }
+    /**
+     * \brief Set the frame rate cap in frames per second (0: no cap)
+     *
+     * When pacing to a known refresh rate, the effective cap is rounded
+     * down to the refresh rate divided by an integer, so that frames are
+     * spaced evenly.
+     */
+    void set_max_fps(float fps) { m_max_fps = fps; }
+
+    /**
+     * \brief Replace the time source (in seconds)
+     *
+     * Defaults to ``glfwGetTime()``. Pass an empty function to restore
+     * the default.
+     */
+    void set_clock(const std::function<double()> &clock) { m_clock = clock; }
+
+    /// Return the current time according to the clock
+    double now() const;
+
+    /// Return the number of seconds until the next frame may start (or zero)
+    double frame_delay() const;
+
+    /// Record the start of a frame
+    void frame_started();
+
+    /// Record the completion of a frame (i.e. after the buffer swap)
+    void frame_presented();
+
+    /// Return the number of presented frames
+    uint64_t frame_count() const { return m_frame_count; }
+
+    /// Return the (possibly simulated) time at which the last frame was presented
+    double last_present() const { return m_last_present; }
+
+protected:
+    Mode m_mode;
+    double m_refresh_rate = 0;
+    float m_max_fps = 0;
+    std::function<double()> m_clock;
+    double m_last_start = 0;
+    double m_last_present = 0;
+    uint64_t m_frame_count = 0;
+};
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,97 @@
+/*
+    waylandgui/framestats.h -- Per-frame timing statistics of a Screen
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \struct FrameTiming framestats.h waylandgui/framestats.h
+ *
+ * \brief Time spent in the individual phases of \ref Screen::draw_all()
+ * for a single frame (all values in milliseconds).
+ */
+struct FrameTiming {
+    /// \ref Screen::draw_setup()
+    double setup = 0;
+    /// \ref Screen::draw_contents()
+    double contents = 0;
+    /// Widget traversal and NanoVG tessellation in \ref Screen::draw_widgets()
+    double widgets = 0;
+    /// ``nvgEndFrame()``, i.e. submission of the NanoVG draw calls to GL
+    double flush = 0;
+    /// \ref Screen::draw_teardown() (buffer swap)
+    double swap = 0;
+    /// Duration of the whole frame
+    double total = 0;
+    /**
+     * Time from the first input event since the previous frame that
+     * requested a redraw until this frame was presented, or a negative
+     * value if the frame was not triggered by input. Events that change
+     * nothing on screen are not counted.
+     */
+    double latency = -1;
+};
+
+/**
+ * \class FrameStats framestats.h waylandgui/framestats.h
+ *
+ * \brief Ring buffer holding the \ref FrameTiming of the most recent frames.
+ *
+ * See \ref Screen::set_frame_stats_enabled().
+ */
+class WAYLANDGUI_EXPORT FrameStats {
+public:
+    /// Selects one of the values of \ref FrameTiming
+    enum class Phase { Setup, Contents, Widgets, Flush, Swap, Total, Latency };
+
+    /// Create a ring buffer for \c capacity frames
+    FrameStats(size_t capacity = 256);
+
+    /// Record a new frame, overwriting the oldest one if the buffer is full
+    void push(const FrameTiming &timing);
+
+    /// Discard all recorded frames
+    void clear() { m_count = m_next = 0; }
+
+    /// Return the number of recorded frames
+    size_t size() const { return m_count; }
+
+    /// Return the maximum number of recorded frames
+    size_t capacity() const { return m_frames.size(); }
+
+    /// Return a recorded frame (index 0 is the oldest one)
+    const FrameTiming &operator[](size_t index) const {
+        return m_frames[(m_next + m_frames.size() - m_count + index) % m_frames.size()];
+    }
+
+    /**
+     * \brief Return the \c p-th percentile (``0 <= p <= 100``) of a phase
+     * over the recorded frames, using the nearest-rank method
+     *
+     * Frames without input events are ignored for \ref Phase::Latency.
+     * Returns zero if there is no data.
+     */
+    double percentile(Phase phase, float p) const;
+
+    /// Write all recorded frames to a CSV file
+    void write_csv(const std::string &filename) const;
+
+protected:
+    std::vector<FrameTiming> m_frames;
+    size_t m_next = 0;
+    size_t m_count = 0;
+};
+
+NAMESPACE_END(waylandgui)
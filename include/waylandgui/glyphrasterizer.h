@@ -0,0 +1,121 @@
+/*
+    waylandgui/glyphrasterizer.h -- Rasterizes glyphs missing from the font
+    atlas on the background worker pool
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class GlyphRasterizer glyphrasterizer.h waylandgui/glyphrasterizer.h
+ *
+ * \brief Moves the rasterization of glyphs that are missing from the font
+ * atlas off the drawing thread (see \ref Screen::set_background_glyphs()).
+ *
+ * Text drawn while one of its glyphs is being rasterized leaves the glyph
+ * out, as a placeholder. The glyphs missed by a frame are submitted to the
+ * worker pool in batches once it has been drawn. Before drawing the next
+ * frame, the rasterizer waits up to its budget for batches in flight, then
+ * packs the finished glyphs into the atlas, which is uploaded with one
+ * sub-region update per atlas page. A glyph that is still missing after
+ * \ref max_pending_frames() frames is rasterized by drawing itself, which
+ * counts as a stall.
+ */
+class WAYLANDGUI_EXPORT GlyphRasterizer {
+public:
+    GlyphRasterizer() = default;
+    GlyphRasterizer(const GlyphRasterizer &) = delete;
+    GlyphRasterizer &operator=(const GlyphRasterizer &) = delete;
+    ~GlyphRasterizer();
+
+    /**
+     * \brief Rasterize the glyphs that text drawn with \c ctx misses
+     *
+     * \return \c false if the font backend of NanoVG does not support it
+     */
+    bool attach(NVGcontext *ctx);
+
+    /// Wait for the batches in flight, drop their glyphs and rasterize when drawing again
+    void detach();
+
+    /// Is a NanoVG context attached?
+    bool attached() const { return m_ctx != nullptr; }
+
+    /// Return the attached NanoVG context (if any)
+    NVGcontext *context() const { return m_ctx; }
+
+    /// Return the number of frames that may draw text without a glyph (default: 3)
+    int max_pending_frames() const { return m_max_pending_frames; }
+
+    /// Set the number of frames that may draw text without a glyph
+    void set_max_pending_frames(int frames);
+
+    /// Return how long \ref finish() may wait for batches in flight in seconds (default: 4 ms)
+    double wait_budget() const { return m_wait_budget; }
+
+    /// Set how long \ref finish() may wait for batches in flight in seconds
+    void set_wait_budget(double seconds) { m_wait_budget = seconds; }
+
+    /// Submit the glyphs missed by the frame that was just drawn to the worker pool
+    void submit();
+
+    /**
+     * \brief Add the glyphs rasterized so far to the font atlas
+     *
+     * \param wait
+     *     Wait up to \ref wait_budget() for the batches in flight first
+     *
+     * \return \c true if glyphs were added, so that text drawn without
+     * them must be drawn again
+     */
+    bool finish(bool wait = false);
+
+    /// Return the number of glyphs that are being rasterized
+    size_t pending() const;
+
+    /// Return the number of glyphs that drawing had to rasterize itself so far
+    int stalls() const;
+
+    /**
+     * \brief Return the number of glyphs added to the font atlas so far
+     *
+     * Screens sharing the rasterizer (see \ref ResourceGroup) compare it
+     * with the value of their last frame to tell whether glyphs they left
+     * out have arrived in the meantime.
+     */
+    size_t glyphs_added() const { return m_glyphs_added; }
+
+protected:
+    /// Called by NanoVG for every glyph that is missing while drawing
+    static void enqueue(void *uptr, NVGglyphJob *job);
+
+protected:
+    NVGcontext *m_ctx = nullptr;
+    int m_max_pending_frames = 3;
+    double m_wait_budget = 0.004;
+    /// Glyphs missed by the current frame
+    std::vector<NVGglyphJob *> m_missed;
+    size_t m_glyphs_added = 0;
+
+    /// Guards the state below, which is shared with the worker pool
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<NVGglyphJob *> m_done;
+    size_t m_in_flight = 0;
+};
+
+NAMESPACE_END(waylandgui)
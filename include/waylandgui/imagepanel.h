@@ -28,9 +28,18 @@ public:
 public:
     ImagePanel(Widget *parent);
 
-    void set_images(const Images &data) { m_images = data; }
+    void set_images(const Images &data) {
+        m_images = data;
+        invalidate_layout();
+    }
     const Images& images() const { return m_images; }
 
+    /**
+     * \brief Load a directory of PNG images in the background and show them
+     * once they are ready (see \ref load_image_directory_async())
+     */
+    void load_images(const std::string &path);
+
     std::function<void(int)> callback() const { return m_callback; }
     void set_callback(const std::function<void(int)> &callback) { m_callback = callback; }
 
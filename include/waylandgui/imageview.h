@@ -13,6 +13,7 @@
 #pragma once
 
 #include <waylandgui/canvas.h>
+#include <waylandgui/shader.h>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -36,6 +37,12 @@ public:
     /// Set the currently active image
     void set_image(Texture *image);
 
+    /**
+     * \brief Load an image file in the background and make it the active
+     * image once it has been decoded (see \ref Texture::load_async())
+     */
+    void load_image(const std::string &filename);
+
     /// Center the image on the screen
     void center();
 
@@ -73,6 +80,7 @@ public:
 
 protected:
     waylandgui::ref<Shader> m_image_shader;
+    Shader::Handle m_matrix_image_handle, m_matrix_background_handle, m_background_color_handle;
     waylandgui::ref<Texture> m_image;
     float m_scale = 0;
     Vector2f m_offset = 0;
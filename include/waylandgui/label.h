@@ -13,6 +13,7 @@
 #pragma once
 
 #include <waylandgui/widget.h>
+#include <waylandgui/textlayout.h>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -32,10 +33,20 @@ public:
     /// Get the label's text caption
     const std::string &caption() const { return m_caption; }
     /// Set the label's text caption
-    void set_caption(const std::string &caption) { m_caption = caption; }
+    void set_caption(const std::string &caption) {
+        if (caption != m_caption) {
+            m_caption = caption;
+            invalidate_layout();
+        }
+    }
 
     /// Set the currently active font (2 are available by default: 'sans' and 'sans-bold')
-    void set_font(const std::string &font) { m_font = font; }
+    void set_font(const std::string &font) {
+        if (font != m_font) {
+            m_font = font;
+            invalidate_layout();
+        }
+    }
     /// Get the currently active font
     const std::string &font() const { return m_font; }
 
@@ -53,9 +64,13 @@ public:
     /// Draw the label
     virtual void draw(NVGcontext *ctx) override;
 protected:
+    /// Measure the caption unless it is unchanged since the last call
+    void update_text_layout(NVGcontext *ctx) const;
+
     std::string m_caption;
     std::string m_font;
     Color m_color;
+    mutable TextLayout m_text_layout;
 };
 
 NAMESPACE_END(waylandgui)
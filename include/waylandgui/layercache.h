@@ -0,0 +1,108 @@
+/*
+    waylandgui/layercache.h -- Offscreen textures holding the rendered
+    output of widgets drawn as layers
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/object.h>
+#include <waylandgui/vector.h>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class LayerCache layercache.h waylandgui/layercache.h
+ *
+ * \brief Renders widgets into offscreen textures and composites them as
+ * textured quads (see \ref Widget::set_cache_as_layer()).
+ *
+ * Every \ref Screen owns one cache. The textures of all layers together,
+ * plus a depth/stencil buffer shared by them, are kept below a memory
+ * budget. When a new layer does not fit, the least recently drawn layers
+ * are evicted; layers drawn in the current frame are never evicted, and
+ * widgets whose layer cannot be allocated are drawn directly.
+ */
+class WAYLANDGUI_EXPORT LayerCache {
+public:
+    LayerCache() = default;
+    LayerCache(const LayerCache &) = delete;
+    LayerCache &operator=(const LayerCache &) = delete;
+    ~LayerCache();
+
+    /// Return the GPU memory budget in bytes
+    size_t budget() const { return m_budget; }
+
+    /// Set the GPU memory budget in bytes, evicting layers if necessary
+    void set_budget(size_t bytes);
+
+    /// Return the GPU memory currently used by layers in bytes
+    size_t memory_usage() const { return m_memory_usage; }
+
+    /// Return the number of cached layers
+    size_t size() const { return m_layers.size(); }
+
+    /// Begin a new frame (layers drawn before this call become evictable)
+    void new_frame() { m_frame++; }
+
+    /**
+     * \brief Draw a widget from its layer
+     *
+     * The layer is (re-)rendered first if it is missing or invalid. Must be
+     * called within a NanoVG frame of \c screen, with the transform and
+     * scissor under which the widget would draw itself.
+     *
+     * \return \c false if the widget must be drawn directly instead
+     */
+    bool draw(NVGcontext *ctx, Widget *widget, Screen *screen);
+
+    /// Free the layer of a widget (if any)
+    void release(Widget *widget);
+
+    /// Free all layers and the shared depth/stencil buffer
+    void clear();
+
+protected:
+    struct Layer {
+        ref<Texture> color;
+        ref<RenderPass> render_pass;
+        NVGcontext *ctx = nullptr;
+        int image = 0;
+        Vector2i fbsize { 0 };
+        float pixel_ratio = 1.f;
+        size_t bytes = 0;
+        uint64_t last_used = 0;
+    };
+
+    /// Create a layer, evicting others if needed (returns \c nullptr if it does not fit)
+    Layer *allocate(NVGcontext *ctx, Widget *widget, const Vector2i &fbsize,
+                    float pixel_ratio);
+
+    /// Evict least recently drawn layers until \c bytes more fit into the budget
+    bool make_room(size_t bytes);
+
+    /// Free the GPU resources of a layer and forget it
+    void erase(std::unordered_map<Widget *, Layer>::iterator it);
+
+    /// Render the widget into its layer
+    void render(NVGcontext *ctx, Widget *widget, Layer &layer,
+                const Vector2i &origin, const Vector2i &size, Screen *screen);
+
+protected:
+    std::unordered_map<Widget *, Layer> m_layers;
+    ref<Texture> m_stencil;
+    size_t m_stencil_bytes = 0;
+    size_t m_budget = 64 * 1024 * 1024;
+    size_t m_memory_usage = 0;
+    uint64_t m_frame = 1;
+};
+
+NAMESPACE_END(waylandgui)
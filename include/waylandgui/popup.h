@@ -65,6 +65,8 @@ public:
 protected:
     /// Internal helper function to maintain nested window position values
     virtual void refresh_relative_placement() override;
+    /// The anchor arrow extends beyond the popup's bounds
+    virtual int layer_margin() const override;
 
 protected:
     Window *m_parent_window;
@@ -0,0 +1,93 @@
+/*
+    waylandgui/resourcegroup.h -- Fonts, glyph atlas and GL objects shared
+    by several screens
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/object.h>
+#include <waylandgui/glyphrasterizer.h>
+#include <waylandgui/fontmetrics.h>
+#include <vector>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class ResourceGroup resourcegroup.h waylandgui/resourcegroup.h
+ *
+ * \brief Resources shared by the screens created with it (see the
+ * \c resources parameter of \ref Screen::Screen()).
+ *
+ * The GL contexts of the screens share their objects, so that textures,
+ * shaders and buffers created for one screen may be used by the others,
+ * and NanoVG compiles its shader program only once. The screens also
+ * share one glyph cache and font atlas, including the parsed font data,
+ * a single \ref Theme, the \ref GlyphRasterizer of missing glyphs and the
+ * \ref FontMetrics that measure text on other threads.
+ * Each screen still uploads the atlas into textures of its own.
+ *
+ * The resources live as long as one of the screens. All screens of a
+ * group must be driven by the same thread, as is the case for \ref
+ * mainloop().
+ *
+ * \rst
+ * .. code-block:: cpp
+ *
+ *    ref<ResourceGroup> resources = new ResourceGroup();
+ *    for (int i = 0; i < 4; ++i)
+ *        new Screen(Vector2i(1024, 768), "Panel " + std::to_string(i), false,
+ *                   false, true, true, false, 3, 2, resources);
+ * \endrst
+ */
+class WAYLANDGUI_EXPORT ResourceGroup : public Object {
+public:
+    ResourceGroup() = default;
+
+    /// Return the screens currently sharing the resources
+    const std::vector<Screen *> &screens() const { return m_screens; }
+
+    /// Return the theme of the screens (\c nullptr before the first one was created)
+    Theme *theme() { return m_theme.get(); }
+
+    /// Return the rasterizer of glyphs missing from the shared font atlas
+    GlyphRasterizer &glyph_rasterizer() { return m_glyph_rasterizer; }
+
+    /// Return the rasterizer of glyphs missing from the shared font atlas
+    const GlyphRasterizer &glyph_rasterizer() const { return m_glyph_rasterizer; }
+
+    /// Return the service that measures text with the shared fonts on any thread
+    FontMetrics &font_metrics() { return m_font_metrics; }
+
+protected:
+    friend class Screen;
+
+    /// Window whose GL context a new screen shares objects with (if any)
+    GLFWwindow *share_window() const;
+
+    /// NanoVG context whose fonts a new screen shares (if any)
+    NVGcontext *share_context() const;
+
+    /// Register a screen once its NanoVG context exists, creating the theme for the first one
+    void add(Screen *screen);
+
+    /// Unregister a screen before its NanoVG context is deleted
+    void remove(Screen *screen);
+
+    ~ResourceGroup();
+
+protected:
+    std::vector<Screen *> m_screens;
+    ref<Theme> m_theme;
+    GlyphRasterizer m_glyph_rasterizer;
+    FontMetrics m_font_metrics;
+};
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,89 @@
+/*
+    waylandgui/resourcepack.h -- Resource files mapped into memory from a
+    pack that is built along with the library
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+#include <string>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class ResourcePack resourcepack.h waylandgui/resourcepack.h
+ *
+ * \brief Read-only view of a resource pack, which is mapped into memory
+ * rather than read, so that only the pages of the resources that are used
+ * are ever loaded.
+ *
+ * With \c WAYLANDGUI_RESOURCE_PACK (off by default), the build writes the
+ * fonts of the theme and the baked glyph atlas into \c waylandgui.pack
+ * rather than embedding them into the library (see \ref builtin()). The
+ * pack must then be installed along with the library, or be found next to
+ * it. Fonts listed in \c WAYLANDGUI_FONT_SUBSETS are reduced to the given
+ * codepoints first, whether packed or embedded.
+ *
+ * A pack starts with the 8 bytes \c WGUIPACK, followed by the format
+ * version (1) and the number of resources as little endian 32-bit values.
+ * Each resource has a 64 byte directory entry with its NUL terminated name
+ * (56 bytes), then its offset and size. The data of each resource starts
+ * on a page of its own.
+ */
+class WAYLANDGUI_EXPORT ResourcePack {
+public:
+    /// Contents of a resource, which stay valid as long as the pack
+    struct Resource {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    /// Map the pack at \c path into memory; throws \c std::runtime_error on failure
+    ResourcePack(const std::string &path);
+    ResourcePack(const ResourcePack &) = delete;
+    ResourcePack &operator=(const ResourcePack &) = delete;
+    ~ResourcePack();
+
+    /// Return the resource of the given name (with a \c nullptr data pointer if there is none)
+    Resource get(const std::string &name) const;
+
+    /**
+     * \brief Drop the pages of a resource from the resident memory of the
+     * process, e.g. once its contents were copied
+     *
+     * They are read again (from the page cache, if still there) when the
+     * resource is used next.
+     */
+    void evict(const std::string &name) const;
+
+    /// Return the path of the pack
+    const std::string &path() const { return m_path; }
+
+    /**
+     * \brief Return the pack that was built along with the library
+     *
+     * It is mapped on first use and stays mapped until the process exits.
+     * The pack is looked for at the path in the \c WAYLANDGUI_RESOURCE_PACK
+     * environment variable, then next to the library and finally in the
+     * directory it was installed to. Throws \c std::runtime_error if none
+     * of them has one.
+     */
+    static const ResourcePack &builtin();
+
+protected:
+    std::string m_path;
+    void *m_data = nullptr;
+    size_t m_size = 0;
+    std::unordered_map<std::string, Resource> m_resources;
+};
+
+NAMESPACE_END(waylandgui)
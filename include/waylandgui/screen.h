@@ -16,6 +16,14 @@
 
 #include <waylandgui/widget.h>
 #include <waylandgui/texture.h>
+#include <waylandgui/framestats.h>
+#include <waylandgui/framepacer.h>
+#include <waylandgui/damage.h>
+#include <waylandgui/layercache.h>
+#include <waylandgui/glyphrasterizer.h>
+#include <waylandgui/fontmetrics.h>
+#include <waylandgui/resourcegroup.h>
+#include <memory>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -30,6 +38,7 @@ class Texture;
 class WAYLANDGUI_EXPORT Screen : public Widget {
     friend class Widget;
     friend class Window;
+    friend class LayerCache;
 public:
     /**
      * Create a new Screen instance
@@ -73,6 +82,11 @@ public:
      *     Requesting an invalid profile will result in no context (and
      *     therefore no GUI) being created. This attribute is ignored when
      *     targeting OpenGL ES 2.
+     *
+     * \param resources
+     *     Share fonts, the font atlas, the theme and GL objects with the
+     *     other screens created with the same group (see \ref ResourceGroup).
+     *     By default, each screen has resources of its own.
      */
     Screen(
         const Vector2i &size,
@@ -83,7 +97,8 @@ public:
         bool stencil_buffer = true,
         bool float_buffer = false,
         unsigned int gl_major = 3,
-        unsigned int gl_minor = 2
+        unsigned int gl_minor = 2,
+        ResourceGroup *resources = nullptr
     );
 
     /// Release all resources
@@ -113,6 +128,91 @@ public:
     /// Send an event that will cause the screen to be redrawn at the next event loop iteration
     void redraw();
 
+    /**
+     * \brief Request that a rectangle (in screen coordinates) be redrawn
+     *
+     * Unlike \ref redraw(), this only repaints the damaged part of the
+     * screen when partial redraws are possible. Must be called from the main
+     * loop thread; widgets normally use \ref Widget::mark_dirty() instead.
+     */
+    void add_damage(const Vector2i &pos, const Vector2i &size);
+
+    /**
+     * \brief Enable or disable partial redraws (enabled by default)
+     *
+     * Partial redraws require the ``EGL_EXT_buffer_age`` or
+     * ``EGL_KHR_partial_update`` extension, which reveal how much of the
+     * back buffer is still valid. Without them, damaged frames are repainted
+     * in full. Damage is forwarded to the compositor via
+     * ``EGL_KHR_swap_buffers_with_damage`` where available.
+     */
+    void set_partial_redraw(bool value) { m_partial_redraw = value; }
+
+    /// Are partial redraws enabled?
+    bool partial_redraw() const { return m_partial_redraw; }
+
+    /**
+     * \brief Set the GPU memory budget of widget layers in bytes (default: 64 MiB)
+     *
+     * See \ref Widget::set_cache_as_layer(). When the budget is exceeded,
+     * the least recently drawn layers are evicted.
+     */
+    void set_layer_budget(size_t bytes) { m_layer_cache.set_budget(bytes); }
+
+    /// Return the GPU memory budget of widget layers in bytes
+    size_t layer_budget() const { return m_layer_cache.budget(); }
+
+    /// Return the cache holding the layers of this screen's widgets
+    const LayerCache &layer_cache() const { return m_layer_cache; }
+
+    /**
+     * \brief Rasterize glyphs missing from the font atlas on the background
+     * worker pool (disabled by default)
+     *
+     * Text is then drawn without such glyphs for a few frames rather than
+     * stalling the frame that first shows them. See \ref GlyphRasterizer,
+     * which \ref glyph_rasterizer() returns for fine tuning.
+     *
+     * \return \c false if the font backend does not support it
+     */
+    bool set_background_glyphs(bool enabled);
+
+    /// Are glyphs rasterized on the background worker pool?
+    bool background_glyphs() const { return glyph_rasterizer().attached(); }
+
+    /// Return the rasterizer of glyphs missing from the font atlas (shared within a \ref ResourceGroup)
+    GlyphRasterizer &glyph_rasterizer() {
+        return m_resources ? m_resources->glyph_rasterizer() : m_glyph_rasterizer;
+    }
+
+    /// Return the rasterizer of glyphs missing from the font atlas (shared within a \ref ResourceGroup)
+    const GlyphRasterizer &glyph_rasterizer() const {
+        return m_resources ? m_resources->glyph_rasterizer() : m_glyph_rasterizer;
+    }
+
+    /**
+     * \brief Return the service that measures text with the fonts of this
+     * screen on any thread (shared within a \ref ResourceGroup)
+     */
+    FontMetrics &font_metrics() {
+        return m_resources ? m_resources->font_metrics() : m_font_metrics;
+    }
+
+    /// Return the group whose resources this screen shares (if any)
+    ResourceGroup *resources() { return m_resources; }
+
+    /// Return the group whose resources this screen shares (if any)
+    const ResourceGroup *resources() const { return m_resources.get(); }
+
+    /**
+     * \brief Return the number of glyphs that drawing had to rasterize
+     * itself so far, each of which stalled its frame
+     *
+     * With background glyphs, these are the glyphs whose rasterization took
+     * longer than \ref GlyphRasterizer::max_pending_frames() frames.
+     */
+    int glyph_miss_stalls() const;
+
     /**
      * \brief Redraw the screen if the redraw flag is set
      *
@@ -183,6 +283,30 @@ public:
     /// Return the last observed mouse position value
     Vector2i mouse_pos() const { return m_mouse_pos; }
 
+    /**
+     * \brief Merge consecutive pointer motion and scroll events?
+     *
+     * When enabled (the default), runs of motion or scroll events that GLFW
+     * delivers between two frames are combined into a single dispatch, which
+     * happens right before the next non-motion event or frame. The relative
+     * order of all other events is unaffected.
+     */
+    void set_coalesce_input(bool value) { m_coalesce_input = value; }
+
+    /// Are consecutive pointer motion and scroll events merged?
+    bool coalesce_input() const { return m_coalesce_input; }
+
+    /**
+     * \brief Return the pointer positions merged into the motion event that
+     * is currently being dispatched (oldest first)
+     *
+     * Widgets that need every sample (e.g. for freehand drawing) can query
+     * this from \ref mouse_motion_event() or \ref mouse_drag_event(). The
+     * last entry matches the position of the event; the list is empty
+     * outside of motion handlers.
+     */
+    const std::vector<Vector2i> &motion_history() const { return m_motion_history; }
+
     /// Return a pointer to the underlying GLFW window data structure
     GLFWwindow *glfw_window() const { return m_glfw_window; }
 
@@ -211,12 +335,55 @@ public:
     /// Is a tooltip currently fading in?
     bool tooltip_fade_in_progress() const;
 
+    /**
+     * \brief Enable or disable the collection of per-frame timings
+     *
+     * When enabled, \ref draw_all() records the time spent in each of its
+     * phases as well as the latency between input events and the frame that
+     * presents their effects in a ring buffer of \c capacity frames. This
+     * is disabled by default, in which case the overhead is a pointer check
+     * per phase.
+     */
+    void set_frame_stats_enabled(bool enabled, size_t capacity = 256);
+
+    /**
+     * \brief Select how frames are paced to the display
+     *
+     * Defaults to \ref FramePacer::Mode::Timed, so that at most one frame is
+     * drawn per display refresh, and only if a redraw was requested, without
+     * ever blocking in the buffer swap.
+     */
+    void set_frame_pacing(FramePacer::Mode mode);
+
+    /// Return how frames are paced to the display
+    FramePacer::Mode frame_pacing() const { return m_frame_pacer.mode(); }
+
+    /// Limit the frame rate of this screen (0: no limit)
+    void set_max_fps(float fps) { m_frame_pacer.set_max_fps(fps); }
+
+    /// Return the frame rate limit of this screen (0: no limit)
+    float max_fps() const { return m_frame_pacer.max_fps(); }
+
+    /// Return the frame pacer (e.g. to install a simulated clock)
+    FramePacer &frame_pacer() { return m_frame_pacer; }
+
+    /// Are per-frame timings being collected?
+    bool frame_stats_enabled() const { return (bool) m_frame_stats; }
+
+    /// Return the recorded frame timings (\c nullptr when disabled)
+    const FrameStats *frame_stats() const { return m_frame_stats.get(); }
+
     using Widget::perform_layout;
 
-    /// Compute the layout of all widgets
-    void perform_layout() {
-        this->perform_layout(m_nvg_context);
-    }
+    /**
+     * \brief Compute the layout of all widgets from scratch
+     *
+     * This measures all widgets again and fits the windows to their
+     * contents. Changes that only affect a few widgets (e.g. a new caption)
+     * don't need it: they are laid out incrementally before the next frame,
+     * see \ref Widget::invalidate_layout().
+     */
+    void perform_layout();
 
 public:
     /********* API for applications which manage GLFW themselves *********/
@@ -247,6 +414,9 @@ public:
     void scroll_callback_event(double x, double y);
     void resize_callback_event(int width, int height);
 
+    /// Dispatch coalesced motion or scroll events (called by \ref draw_all())
+    void flush_input_events();
+
     /* Internal helper functions */
     void update_focus(Widget *widget);
     void dispose_window(Window *window);
@@ -254,6 +424,60 @@ public:
     void move_window_to_front(Window *window);
     void draw_widgets();
 
+protected:
+    /// (Re-)arm the timer that redraws the screen when a tooltip should fade in
+    void update_tooltip_timer();
+
+    /// Widget under the cursor, looked up again only after events that may have changed it
+    const Widget *hover_widget();
+
+    /// Measure and break the tooltip of \c widget into rows unless already done
+    void prepare_tooltip(const Widget *widget);
+
+    /// Tooltip text broken into rows, laid out once per tooltip
+    struct TooltipLayout {
+        /* Key: the layout is redone when any of these change */
+        const Widget *widget = nullptr;
+        std::string text;
+        Vector2i anchor;
+        float pixel_ratio = 0.f;
+
+        /// Text bounds and half width, as used to place the background
+        float bounds[4];
+        int h = 0, shift = 0;
+
+        /// Byte range and pen position of each row of text
+        struct Row { size_t begin, end; float x, y; };
+        std::vector<Row> rows;
+    };
+
+    /// Note the arrival of an input event for the event-to-frame latency
+    void mark_input_event();
+
+    /// Request a redraw if the event just noted changed anything, which makes it count for the latency
+    void input_handled(bool redraw);
+
+    /// Discard recorded NanoVG output of widgets that may have handled an event
+    void invalidate_input_targets();
+
+    /// Deliver a (possibly merged) pointer motion event
+    void dispatch_motion(const Vector2i &p);
+
+    /// Deliver a (possibly merged) scroll event
+    void dispatch_scroll(const Vector2f &rel);
+
+    /// Decide which part of the back buffer must be repainted in this frame
+    void begin_damage_frame(bool full);
+
+    /// Lay out the windows marked by \ref Widget::invalidate_layout(); returns whether any were
+    bool update_pending_layout();
+
+    /// Add rasterized glyphs to the font atlas; returns whether text drawn without them must be drawn again
+    bool glyphs_arrived(bool wait);
+
+    /// Kind of the input event that is waiting to be dispatched
+    enum class PendingInput : uint8_t { None, Motion, Scroll };
+
 protected:
     GLFWwindow *m_glfw_window = nullptr;
     NVGcontext *m_nvg_context = nullptr;
@@ -267,6 +491,15 @@ protected:
     bool m_drag_active;
     Widget *m_drag_widget = nullptr;
     double m_last_interaction;
+    uint32_t m_tooltip_timer = 0;
+    /// Widget under the cursor, as of the last pointer motion
+    Widget *m_hover_widget = nullptr;
+    /// Set by events and widget removals after which \ref m_hover_widget
+    /// must be looked up again
+    bool m_hover_stale = true;
+    TooltipLayout m_tooltip;
+    uint32_t m_frame_timer = 0;
+    FramePacer m_frame_pacer;
     bool m_process_events = true;
     Color m_background;
     std::string m_caption;
@@ -276,6 +509,29 @@ protected:
     bool m_stencil_buffer;
     bool m_redraw;
     std::function<void(Vector2i)> m_resize_callback;
+    std::unique_ptr<FrameStats> m_frame_stats;
+    FrameTiming m_frame_timing;
+    /// Time of the first event that requested the next frame, and of the last event noted
+    double m_first_event_time = -1, m_event_time = -1;
+    bool m_coalesce_input = true;
+    PendingInput m_pending_input = PendingInput::None;
+    std::vector<Vector2i> m_motion_history;
+    Vector2f m_pending_scroll { 0.f };
+    bool m_partial_redraw = true;
+    DamageRegion m_damage;
+    /// Damage of the current frame, reported to the compositor on swap
+    DamageRegion m_frame_damage;
+    /// Damage of previous frames (newest last), used with the buffer age
+    std::vector<DamageRegion> m_damage_history;
+    /// Framebuffer rectangle that is repainted (or width < 0 for the full screen)
+    Vector4i m_repaint_rect { 0, 0, -1, -1 };
+    LayerCache m_layer_cache;
+    GlyphRasterizer m_glyph_rasterizer;
+    FontMetrics m_font_metrics;
+    ref<ResourceGroup> m_resources;
+    /// Glyphs added to the atlas and placeholders drawn as of the last check
+    size_t m_glyphs_added = 0;
+    int m_glyph_placeholders = 0;
 };
 
 NAMESPACE_END(waylandgui)
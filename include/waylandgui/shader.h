@@ -19,6 +19,7 @@
 #include <waylandgui/object.h>
 #include <waylandgui/traits.h>
 #include <unordered_map>
+#include <vector>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -39,6 +40,28 @@ public:
         AlphaBlend // alpha * new_color + (1 - alpha) * old_color
     };
 
+    /**
+     * \brief Index of a named shader parameter, see \ref handle()
+     *
+     * Updating a parameter through its handle skips the lookup of its name,
+     * e.g. for uniforms that are set every frame. A handle is only valid
+     * with the shader that returned it.
+     */
+    class Handle {
+    public:
+        Handle() = default;
+
+        /// Was the handle returned by \ref Shader::handle()?
+        bool valid() const { return m_index != (uint32_t) -1; }
+
+    protected:
+        friend class Shader;
+        explicit Handle(uint32_t index) : m_index(index) { }
+
+    protected:
+        uint32_t m_index = (uint32_t) -1;
+    };
+
     /**
      * \brief Initialize the shader using the specified source strings.
      *
@@ -70,6 +93,14 @@ public:
     /// Return the blending mode of this shader
     BlendMode blend_mode() const { return m_blend_mode; }
 
+    /**
+     * \brief Look up the named shader parameter once, so that it can be
+     * updated by handle rather than by name
+     *
+     * Throws \c std::runtime_error if the shader has no such parameter.
+     */
+    Handle handle(const std::string &name) const;
+
     /**
      * \brief Upload a buffer (e.g. vertex positions) that will be associated
      * with a named shader parameter.
@@ -78,8 +109,18 @@ public:
      * data---the implementation takes care of routing the data to the right
      * endpoint. Matrices should be specified in column-major order.
      *
-     * The buffer will be replaced if it is already present.
+     * The buffer will be replaced if it is already present. A uniform that
+     * is set to the value it already has is not uploaded again by \ref
+     * begin().
      */
+    void set_buffer(Handle handle, VariableType type, size_t ndim,
+                    const size_t *shape, const void *data);
+
+    void set_buffer(Handle handle, VariableType type,
+                    std::initializer_list<size_t> shape, const void *data) {
+        set_buffer(handle, type, shape.end() - shape.begin(), shape.begin(), data);
+    }
+
     void set_buffer(const std::string &name, VariableType type, size_t ndim,
                     const size_t *shape, const void *data);
 
@@ -92,8 +133,7 @@ public:
      * \brief Upload a uniform variable (e.g. a vector or matrix) that will be
      * associated with a named shader parameter.
      */
-    template <typename Array> void set_uniform(const std::string &name,
-                                               const Array &value) {
+    template <typename Array> void set_uniform(Handle handle, const Array &value) {
         size_t shape[3] = { 1, 1, 1 };
         size_t ndim = (size_t) -1;
         const void *data;
@@ -135,7 +175,12 @@ public:
         if (ndim == (size_t) -1)
             throw std::runtime_error("Shader::set_uniform(): invalid input array dimension!");
 
-        set_buffer(name, vtype, ndim, shape, data);
+        set_buffer(handle, vtype, ndim, shape, data);
+    }
+
+    template <typename Array> void set_uniform(const std::string &name,
+                                               const Array &value) {
+        set_uniform(handle(name), value);
     }
 
     /**
@@ -143,13 +188,16 @@ public:
      *
      * The association will be replaced if it is already present.
      */
+    void set_texture(Handle handle, Texture *texture);
+
     void set_texture(const std::string &name, Texture *texture);
 
     /**
      * \brief Begin drawing using this shader
      *
      * Note that any updates to 'uniform' and 'varying' shader parameters
-     * *must* occur prior to this method call.
+     * *must* occur prior to this method call. Only the uniforms that changed
+     * since the last call are uploaded.
      *
      * The Python bindings also include extra \c __enter__ and \c __exit__
      * aliases so that the shader can be activated via Pythons 'with'
@@ -201,6 +249,7 @@ protected:
     };
 
     struct Buffer {
+        std::string name;
         void *buffer = nullptr;
         BufferType type = Unknown;
         VariableType dtype = VariableType::Invalid;
@@ -213,13 +262,18 @@ protected:
         std::string to_string() const;
     };
 
+    /// Return the parameter of a handle; throws \c std::runtime_error if it is invalid
+    Buffer &buffer(Handle handle, const char *method);
+
     /// Release all resources
     virtual ~Shader();
 
 protected:
     RenderPass* m_render_pass;
     std::string m_name;
-    std::unordered_map<std::string, Buffer> m_buffers;
+    /// Parameters, indexed by \ref Handle
+    std::vector<Buffer> m_buffers;
+    std::unordered_map<std::string, uint32_t> m_handles;
     BlendMode m_blend_mode;
 
     uint32_t m_shader_handle = 0;
@@ -0,0 +1,64 @@
+/*
+    waylandgui/spatialindex.h -- Uniform grid over the children of a widget
+    that speeds up hit-testing
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/vector.h>
+#include <vector>
+#include <utility>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class SpatialIndex spatialindex.h waylandgui/spatialindex.h
+ *
+ * \brief Buckets the visible children of a widget into a uniform grid.
+ *
+ * The grid covers the bounding box of the children and has about one cell
+ * per child. Each cell lists the children that overlap it by their index in
+ * the parent, in ascending order, so scanning a cell backwards visits the
+ * candidates in the same order as a reverse scan of all children would. A
+ * point query therefore costs a division and a scan of a single cell,
+ * independently of the number of children. See \ref Widget::set_spatial_index().
+ */
+class WAYLANDGUI_EXPORT SpatialIndex {
+public:
+    /// Range of child indices returned by \ref query()
+    using Range = std::pair<const uint32_t *, const uint32_t *>;
+
+    /// Rebuild the grid from the visible children of a widget
+    void build(const std::vector<Widget *> &children);
+
+    /**
+     * \brief Return the indices of the children that may contain \c p, in
+     * ascending order
+     *
+     * \c p is given in the coordinate system of the children's positions.
+     * The caller must still test each candidate against its bounds.
+     */
+    Range query(const Vector2i &p) const;
+
+    /// Return the number of cells along each axis
+    const Vector2i &cells() const { return m_cells; }
+
+    /// Return the total number of entries in all cells
+    size_t entries() const { return m_items.size(); }
+
+protected:
+    Vector2i m_origin { 0 }, m_cell_size { 1 }, m_cells { 0 };
+    /// Start of each cell's entries in \ref m_items, plus the end
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_items;
+};
+
+NAMESPACE_END(waylandgui)
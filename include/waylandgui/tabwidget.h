@@ -14,6 +14,7 @@
 #pragma once
 
 #include <waylandgui/widget.h>
+#include <waylandgui/textlayout.h>
 #include <functional>
 #include <unordered_map>
 
@@ -62,11 +63,17 @@ public:
     /// Return the caption of the tab with the given ID
     const std::string& tab_caption(int id) const { return m_tab_captions[tab_index(id)]; };
     /// Change the caption of the tab with the given ID
-    void set_tab_caption(int id, const std::string &caption) { m_tab_captions[tab_index(id)] = caption; };
+    void set_tab_caption(int id, const std::string &caption) {
+        m_tab_captions[tab_index(id)] = caption;
+        invalidate_layout();
+    }
 
     /// Return whether tabs provide a close button
     bool tabs_closeable() const { return m_tabs_closeable; }
-    void set_tabs_closeable(bool value) { m_tabs_closeable = value; }
+    void set_tabs_closeable(bool value) {
+        m_tabs_closeable = value;
+        invalidate_layout();
+    }
 
     /// Return whether tabs can be dragged to different positions
     bool tabs_draggable() const { return m_tabs_draggable; }
@@ -74,7 +81,10 @@ public:
 
     /// Return the padding between the tab widget boundary and child widgets
     int padding() const { return m_padding; }
-    void set_padding(int value) { m_padding = value; }
+    void set_padding(int value) {
+        m_padding = value;
+        invalidate_layout();
+    }
 
     /// Set the widget's background color (a global property)
     void set_background_color(const Color &background_color) {
@@ -116,9 +126,14 @@ protected:
                                          bool test_vertical = true) const;
     virtual void update_visibility();
 
+    /// Return the measured caption of the tab at the given index
+    const TextLayout &tab_layout(NVGcontext *ctx, size_t index) const;
+
 protected:
     std::string m_font;
     std::vector<std::string> m_tab_captions;
+    mutable std::vector<TextLayout> m_tab_layouts;
+    mutable TextLayout m_close_layout;
     std::vector<int> m_tab_ids;
     std::vector<int> m_tab_offsets;
     int m_close_width = 0;
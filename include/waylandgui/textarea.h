@@ -29,6 +29,17 @@ NAMESPACE_BEGIN(waylandgui)
  */
 class WAYLANDGUI_EXPORT TextArea : public Widget {
 public:
+    /// Text split into runs between line breaks and measured by \ref measure()
+    struct MeasuredText {
+        struct Run {
+            std::string text;
+            int width;
+            /// Is the run followed by a line break?
+            bool newline;
+        };
+        std::vector<Run> runs;
+    };
+
     TextArea(Widget *parent);
 
     /// Set the used font
@@ -68,7 +79,10 @@ public:
     }
 
     /// Set the amount of padding to add around the text
-    void set_padding(int padding) { m_padding = padding; }
+    void set_padding(int padding) {
+        m_padding = padding;
+        invalidate_layout();
+    }
 
     /// Return the amount of padding that is added around the text
     int padding() const { return m_padding; }
@@ -82,6 +96,18 @@ public:
     /// Append text at the end of the widget
     void append(const std::string &text);
 
+    /// Append text that was measured with the font of the widget ahead of time
+    void append(const MeasuredText &text);
+
+    /**
+     * \brief Measure text for \ref append()
+     *
+     * Any thread may measure text with a context of \ref FontMetrics, so
+     * that appending a large amount of text does not stall drawing.
+     */
+    static MeasuredText measure(NVGcontext *ctx, const std::string &text,
+                                const std::string &font, float font_size);
+
     /// Append a line of text at the bottom
     void append_line(const std::string &text) {
         append(text + "\n");
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <waylandgui/widget.h>
+#include <waylandgui/textlayout.h>
 #include <cstdio>
 #include <sstream>
 
@@ -46,10 +47,20 @@ public:
     void set_editable(bool editable);
 
     bool spinnable() const { return m_spinnable; }
-    void set_spinnable(bool spinnable) { m_spinnable = spinnable; }
+    void set_spinnable(bool spinnable) {
+        if (spinnable != m_spinnable) {
+            m_spinnable = spinnable;
+            invalidate_layout();
+        }
+    }
 
     const std::string &value() const { return m_value; }
-    void set_value(const std::string &value) { m_value = value; }
+    void set_value(const std::string &value) {
+        if (value != m_value) {
+            m_value = value;
+            invalidate_layout();
+        }
+    }
 
     const std::string &default_value() const { return m_default_value; }
     void set_default_value(const std::string &default_value) { m_default_value = default_value; }
@@ -58,10 +69,20 @@ public:
     void set_alignment(Alignment align) { m_alignment = align; }
 
     const std::string &units() const { return m_units; }
-    void set_units(const std::string &units) { m_units = units; }
+    void set_units(const std::string &units) {
+        if (units != m_units) {
+            m_units = units;
+            invalidate_layout();
+        }
+    }
 
     int units_image() const { return m_units_image; }
-    void set_units_image(int image) { m_units_image = image; }
+    void set_units_image(int image) {
+        if (image != m_units_image) {
+            m_units_image = image;
+            invalidate_layout();
+        }
+    }
 
     /// Return the underlying regular expression specifying valid formats
     const std::string &format() const { return m_format; }
@@ -98,12 +119,13 @@ protected:
     void paste_from_clipboard();
     bool delete_selection();
 
-    void update_cursor(NVGcontext *ctx, float lastx,
-                       const NVGglyphPosition *glyphs, int size);
+    /* Glyph positions and \c lastx are relative to the start of the text at \c origin */
+    void update_cursor(float origin, float lastx,
+                       const TextLayout::Glyph *glyphs, int size);
     float cursor_index_to_position(int index, float lastx,
-                                   const NVGglyphPosition *glyphs, int size);
+                                   const TextLayout::Glyph *glyphs, int size);
     int position_to_cursor_index(float posx, float lastx,
-                                 const NVGglyphPosition *glyphs, int size);
+                                 const TextLayout::Glyph *glyphs, int size);
 
     /// The location (if any) for the spin area.
     enum class SpinArea { None, Top, Bottom };
@@ -131,6 +153,8 @@ protected:
     int m_mouse_down_modifier;
     float m_text_offset;
     double m_last_click;
+    /// The measured value (or placeholder) and units
+    mutable TextLayout m_text_layout, m_units_layout;
 };
 
 /**
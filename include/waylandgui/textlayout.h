@@ -0,0 +1,120 @@
+/*
+    waylandgui/textlayout.h -- Measured text that widgets keep between frames
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <waylandgui/common.h>
+#include <string>
+#include <vector>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \class TextLayout textlayout.h waylandgui/textlayout.h
+ *
+ * \brief Width, line breaks and glyph positions of a string.
+ *
+ * \ref update() measures the text for a font face, font size and optional
+ * wrap width, and does nothing as long as none of these change. \ref draw()
+ * then emits the text row by row with left alignment at precomputed
+ * offsets, so that neither centered or right-aligned text nor wrapped text
+ * is measured again when it is drawn. Glyph positions are only computed
+ * when requested via \ref glyphs().
+ *
+ * Measurements are relative to the origin of the text with
+ * <tt>NVG_ALIGN_LEFT | NVG_ALIGN_TOP</tt> alignment and a line height of 1.
+ * All methods that take a NanoVG context leave it set to the font face and
+ * size of the layout. Any context with the same fonts and pixel ratio may be
+ * passed, e.g. one of \ref FontMetrics on another thread to \ref update()
+ * ahead of time and the one of the screen to \ref draw().
+ */
+class WAYLANDGUI_EXPORT TextLayout {
+public:
+    /// Byte range of a row of text and its logical width
+    struct Row {
+        uint32_t begin, end;
+        float width;
+    };
+
+    /// Byte offset of a glyph, its logical position and the bounds of its shape
+    struct Glyph {
+        uint32_t offset;
+        float x, minx, maxx;
+    };
+
+    /**
+     * \brief Measure the text unless it was already measured with the same
+     * inputs
+     *
+     * When \c wrap_width is positive, the text is broken into rows of at
+     * most that width, as by <tt>nvgTextBox()</tt>. Glyph metrics depend on
+     * the pixel ratio and the scale of the transform, so text is measured
+     * again when they change, e.g. on a monitor with another pixel ratio.
+     * Returns \c true if the text was measured.
+     */
+    bool update(NVGcontext *ctx, const std::string &text, const std::string &font,
+                float font_size, float wrap_width = 0.f);
+
+    /// Force the next \ref update() to measure the text
+    void invalidate() { m_fonts = nullptr; }
+
+    /// Return the measured text
+    const std::string &text() const { return m_text; }
+
+    /// Return the advance of the text on a single line (see <tt>nvgTextBounds()</tt>)
+    float advance() const { return m_advance; }
+
+    /// Return the bounds of the text (see <tt>nvgTextBounds()</tt> and <tt>nvgTextBoxBounds()</tt>)
+    const float *bounds() const { return m_bounds; }
+
+    /// Return the height of a row of text
+    float line_height() const { return m_line_height; }
+
+    /// Return the rows of the text (a single one unless it is wrapped)
+    const std::vector<Row> &rows() const { return m_rows; }
+
+    /// Return the glyph positions of the text on a single line, ignoring the wrap width
+    const std::vector<Glyph> &glyphs(NVGcontext *ctx) const;
+
+    /**
+     * \brief Draw the text with the current fill color
+     *
+     * \c align combines <tt>NVGalign</tt> flags. Wrapped rows are aligned
+     * within the wrap width, as by <tt>nvgTextBox()</tt>.
+     */
+    void draw(NVGcontext *ctx, float x, float y, int align) const;
+
+protected:
+    /// Select the font face and size and the alignment used for measuring
+    void apply_font(NVGcontext *ctx) const;
+
+protected:
+    /* Key: the text is measured again when any of these change */
+    /// Font stash of the context that measured the text (see <tt>nvgFontStash()</tt>)
+    const void *m_fonts = nullptr;
+    /// Scale text was rasterized at, e.g. a different pixel ratio (see <tt>nvgTextScale()</tt>)
+    float m_scale = 0.f;
+    std::string m_text;
+    std::string m_font;
+    float m_font_size = 0.f;
+    float m_wrap_width = 0.f;
+
+    int m_font_id = -1;
+    float m_advance = 0.f;
+    float m_bounds[4] = { 0.f, 0.f, 0.f, 0.f };
+    float m_line_height = 0.f;
+    std::vector<Row> m_rows;
+    mutable std::vector<Glyph> m_glyphs;
+    mutable bool m_glyphs_valid = false;
+};
+
+NAMESPACE_END(waylandgui)
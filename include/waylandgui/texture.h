@@ -19,6 +19,7 @@
 #include <waylandgui/object.h>
 #include <waylandgui/vector.h>
 #include <waylandgui/traits.h>
+#include <waylandgui/executor.h>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -126,6 +127,25 @@ public:
             InterpolationMode mag_interpolation_mode = InterpolationMode::Bilinear,
             WrapMode wrap_mode                       = WrapMode::ClampToEdge);
 
+    /**
+     * \brief Load an image from the given file without blocking the main loop
+     *
+     * The file is decoded by the background worker pool (see \ref
+     * run_in_background()). The texture is then created and uploaded on the
+     * main loop thread and passed to \c callback. Decoding errors are
+     * reported on ``stderr``, in which case \c callback is not invoked.
+     *
+     * \param owner
+     *     If not \c nullptr, loading is cancelled when this widget is destroyed
+     */
+    static ref<BackgroundTask> load_async(
+        const std::string &filename,
+        const std::function<void(Texture *)> &callback,
+        Widget *owner = nullptr,
+        InterpolationMode min_interpolation_mode = InterpolationMode::Bilinear,
+        InterpolationMode mag_interpolation_mode = InterpolationMode::Bilinear,
+        WrapMode wrap_mode                       = WrapMode::ClampToEdge);
+
     /// Return the pixel format
     PixelFormat pixel_format() const { return m_pixel_format; }
 
@@ -12,6 +12,17 @@
 #pragma once
 
 #include <waylandgui/common.h>
+#include <waylandgui/executor.h>
+#include <waylandgui/damage.h>
+#include <waylandgui/framepacer.h>
+#include <waylandgui/framestats.h>
+#include <waylandgui/layercache.h>
+#include <waylandgui/glyphrasterizer.h>
+#include <waylandgui/fontmetrics.h>
+#include <waylandgui/resourcegroup.h>
+#include <waylandgui/resourcepack.h>
+#include <waylandgui/spatialindex.h>
+#include <waylandgui/textlayout.h>
 #include <waylandgui/widget.h>
 #include <waylandgui/screen.h>
 #include <waylandgui/theme.h>
@@ -14,6 +14,7 @@
 
 #include <waylandgui/object.h>
 #include <waylandgui/theme.h>
+#include <waylandgui/executor.h>
 #include <vector>
 #include <algorithm>
 
@@ -31,6 +32,9 @@ enum class Cursor; // do not put a docstring, this is already documented
  * widgets using a layout generator (see \ref Layout).
  */
 class WAYLANDGUI_EXPORT Widget : public Object {
+    friend class LayerCache;
+    friend class Screen;
+    friend class Window;
 public:
     /// Construct a new widget with the given parent widget
     Widget(Widget *parent);
@@ -47,7 +51,10 @@ public:
     /// Return the used \ref Layout generator
     const Layout *layout() const { return m_layout.get(); }
     /// Set the used \ref Layout generator
-    void set_layout(Layout *layout) { m_layout = layout; }
+    void set_layout(Layout *layout) {
+        m_layout = layout;
+        invalidate_layout();
+    }
 
     /// Return the \ref Theme used to draw this widget
     Theme *theme() { return m_theme; }
@@ -59,7 +66,18 @@ public:
     /// Return the position relative to the parent widget
     const Vector2i &position() const { return m_pos; }
     /// Set the position relative to the parent widget
-    void set_position(const Vector2i &pos) { m_pos = pos; }
+    void set_position(const Vector2i &pos) {
+        if (pos != m_pos) {
+            m_pos = pos;
+            /* Recordings are position independent, but the parent's isn't */
+            if (m_parent) {
+                m_parent->invalidate_display_list();
+                m_parent->m_spatial_index_valid = false;
+            }
+            /* Layouts may depend on the absolute position (e.g. popups) */
+            m_layout_dirty = true;
+        }
+    }
 
     /// Return the absolute position on screen
     Vector2i absolute_position() const {
@@ -70,17 +88,27 @@ public:
     /// Return the size of the widget
     const Vector2i &size() const { return m_size; }
     /// set the size of the widget
-    void set_size(const Vector2i &size) { m_size = size; }
+    void set_size(const Vector2i &size) {
+        if (size != m_size) {
+            m_size = size;
+            invalidate_display_list();
+            if (m_parent)
+                m_parent->m_spatial_index_valid = false;
+            /* Some preferred sizes depend on the width (e.g. wrapped text) */
+            m_preferred_size_valid = false;
+            m_layout_dirty = true;
+        }
+    }
 
     /// Return the width of the widget
     int width() const { return m_size.x(); }
     /// Set the width of the widget
-    void set_width(int width) { m_size.x() = width; }
+    void set_width(int width) { set_size(Vector2i(width, m_size.y())); }
 
     /// Return the height of the widget
     int height() const { return m_size.y(); }
     /// Set the height of the widget
-    void set_height(int height) { m_size.y() = height; }
+    void set_height(int height) { set_size(Vector2i(m_size.x(), height)); }
 
     /**
      * \brief Set the fixed size of this widget
@@ -91,7 +119,12 @@ public:
      * size; this is done with a call to \ref set_size or a call to \ref perform_layout()
      * in the parent widget.
      */
-    void set_fixed_size(const Vector2i &fixed_size) { m_fixed_size = fixed_size; }
+    void set_fixed_size(const Vector2i &fixed_size) {
+        if (fixed_size != m_fixed_size) {
+            m_fixed_size = fixed_size;
+            invalidate_layout();
+        }
+    }
 
     /// Return the fixed size (see \ref set_fixed_size())
     const Vector2i &fixed_size() const { return m_fixed_size; }
@@ -101,14 +134,23 @@ public:
     // Return the fixed height (see \ref set_fixed_size())
     int fixed_height() const { return m_fixed_size.y(); }
     /// Set the fixed width (see \ref set_fixed_size())
-    void set_fixed_width(int width) { m_fixed_size.x() = width; }
+    void set_fixed_width(int width) { set_fixed_size(Vector2i(width, m_fixed_size.y())); }
     /// Set the fixed height (see \ref set_fixed_size())
-    void set_fixed_height(int height) { m_fixed_size.y() = height; }
+    void set_fixed_height(int height) { set_fixed_size(Vector2i(m_fixed_size.x(), height)); }
 
     /// Return whether or not the widget is currently visible (assuming all parents are visible)
     bool visible() const { return m_visible; }
     /// Set whether or not the widget is currently visible (assuming all parents are visible)
-    void set_visible(bool visible) { m_visible = visible; }
+    void set_visible(bool visible) {
+        if (visible != m_visible) {
+            m_visible = visible;
+            invalidate_display_list();
+            if (m_parent) {
+                m_parent->m_spatial_index_valid = false;
+                m_parent->invalidate_layout();
+            }
+        }
+    }
 
     /// Check if this widget is currently visible, taking parent widgets into account
     bool visible_recursive() const {
@@ -174,7 +216,12 @@ public:
     /// Return whether or not this widget is currently enabled
     bool enabled() const { return m_enabled; }
     /// Set whether or not this widget is currently enabled
-    void set_enabled(bool enabled) { m_enabled = enabled; }
+    void set_enabled(bool enabled) {
+        if (enabled != m_enabled) {
+            m_enabled = enabled;
+            invalidate_display_list();
+        }
+    }
 
     /// Return whether or not this widget is currently focused
     bool focused() const { return m_focused; }
@@ -183,13 +230,90 @@ public:
     /// Request the focus to be moved to this widget
     void request_focus();
 
+    /**
+     * \brief Request that the area covered by this widget be redrawn
+     *
+     * This is cheaper than \ref Screen::redraw() for widgets whose
+     * appearance changes without affecting the layout, since the screen can
+     * then repaint only the damaged area.
+     */
+    void mark_dirty() { mark_dirty(Vector2i(0), m_size); }
+
+    /// Request that a rectangle (relative to this widget) be redrawn
+    void mark_dirty(const Vector2i &pos, const Vector2i &size);
+
+    /**
+     * \brief Record the NanoVG output of this widget and its children, and
+     * replay it in subsequent frames while the widget is unchanged
+     *
+     * Replaying skips path flattening, tessellation and text shaping; moving
+     * the widget only translates the recorded geometry. The recording is
+     * discarded when \ref invalidate_display_list() is called on the widget
+     * or one of its descendants. This happens automatically on hover, focus,
+     * size, visibility and enabled state changes, on layout, on \ref
+     * mark_dirty(), and for the targets of input events that requested a
+     * redraw. Widgets whose appearance changes in other ways (e.g.
+     * animations, or state modified by the application) must call it
+     * themselves, so retained mode is off by default.
+     */
+    void set_retained(bool value);
+
+    /// Is the NanoVG output of this widget recorded and replayed?
+    bool retained() const { return m_retained; }
+
+    /// Discard the recorded NanoVG output and cached layers of this widget and its ancestors
+    void invalidate_display_list();
+
+    /**
+     * \brief Render this widget and its children into an offscreen texture,
+     * and composite it as a single textured quad while it is unchanged
+     *
+     * This suits widgets that rarely change, such as settings panels and
+     * dashboards: moving or dragging them only costs a quad. The layer is
+     * re-rendered when \ref invalidate_display_list() is called on the
+     * widget or one of its descendants (see \ref set_retained() for when
+     * this happens automatically). Layers count against the budget set via
+     * \ref Screen::set_layer_budget(); widgets whose layer does not fit are
+     * drawn directly.
+     */
+    void set_cache_as_layer(bool value);
+
+    /// Is this widget drawn from an offscreen layer?
+    bool cache_as_layer() const { return m_cache_as_layer; }
+
+    /**
+     * \brief Find the children under the cursor with a grid instead of
+     * scanning all of them
+     *
+     * Pointer events and \ref find_widget() normally test every child of
+     * each widget along the way. For containers with hundreds or thousands
+     * of children (e.g. panels of small indicators), this bins the children
+     * into a \ref SpatialIndex, so that only the few children near the
+     * cursor are tested. The grid is rebuilt lazily on the next query after
+     * children were added, removed, moved, resized or hidden, e.g. by \ref
+     * perform_layout(). Code that writes to \ref m_pos or \ref m_size of a
+     * child directly must call \ref invalidate_spatial_index() on the parent.
+     */
+    void set_spatial_index(bool value);
+
+    /// Are the children of this widget hit-tested through a spatial index?
+    bool spatial_index() const { return m_spatial_index != nullptr; }
+
+    /// Rebuild the spatial index of the children before its next use
+    void invalidate_spatial_index() { m_spatial_index_valid = false; }
+
     const std::string &tooltip() const { return m_tooltip; }
     void set_tooltip(const std::string &tooltip) { m_tooltip = tooltip; }
 
     /// Return current font size. If not set the default of the current theme will be returned
     int font_size() const;
     /// Set the font size of this widget
-    void set_font_size(int font_size) { m_font_size = font_size; }
+    void set_font_size(int font_size) {
+        if (font_size != m_font_size) {
+            m_font_size = font_size;
+            invalidate_layout();
+        }
+    }
     /// Return whether the font size is explicitly specified for this widget
     bool has_font_size() const { return m_font_size > 0; }
 
@@ -248,16 +372,77 @@ public:
     /// Compute the preferred size of the widget
     virtual Vector2i preferred_size(NVGcontext *ctx) const;
 
+    /**
+     * \brief Return the preferred size, computed once and then cached until
+     * \ref invalidate_layout() is called
+     *
+     * The cached value is also recomputed when the theme, the font size or
+     * the NanoVG context change. Layouts measure their children this way,
+     * so that each widget is measured once rather than once per enclosing
+     * layout.
+     */
+    Vector2i cached_preferred_size(NVGcontext *ctx) const;
+
+    /**
+     * \brief Note that the preferred size of this widget may have changed
+     *
+     * Discards the cached preferred size of the widget and its ancestors and
+     * marks them for layout. The \ref Screen lays out the marked windows at
+     * the beginning of the next frame, without resizing them, and only
+     * descends into children that were marked, moved or resized. Setters
+     * that affect the preferred size (captions, fixed size, font size,
+     * visibility of a child, ...) call this automatically. Call it after
+     * changing other state that \ref preferred_size() depends on, such as
+     * the parameters of the layout generator.
+     */
+    void invalidate_layout();
+
+    /// Is a layout of the children pending?
+    bool layout_dirty() const { return m_layout_dirty; }
+
     /// Invoke the associated layout generator to properly place child widgets, if any
     virtual void perform_layout(NVGcontext *ctx);
 
+    /// Call \ref perform_layout() if this widget was marked, moved or resized since its last layout
+    void update_layout(NVGcontext *ctx) {
+        if (m_layout_dirty) {
+            m_layout_dirty = false;
+            perform_layout(ctx);
+        }
+    }
+
     /// Draw the widget (and all child widgets)
     virtual void draw(NVGcontext *ctx);
 
+    /**
+     * \brief Tie a background task to the lifetime of this widget
+     *
+     * The task is cancelled when the widget is destroyed, which guarantees
+     * that its continuation never observes a dangling widget. This is done
+     * automatically for tasks submitted via \ref run_in_background() with
+     * this widget as \c owner.
+     */
+    void attach_background_task(BackgroundTask *task);
+
 protected:
     /// Free all resources used by the widget and any children
     virtual ~Widget();
 
+    /// Replay the recorded NanoVG output, or draw and record it
+    void draw_retained(NVGcontext *ctx);
+
+    /// Draw the widget from its layer, or directly if there is none
+    void draw_layer(NVGcontext *ctx);
+
+    /// Size of the output drawn outside of the widget's bounds (e.g. drop shadows)
+    virtual int layer_margin() const { return 0; }
+
+    /// Return the up-to-date spatial index of the children, if enabled
+    const SpatialIndex *children_index() const;
+
+    /// Discard the cached preferred sizes of this widget and its descendants, and mark them all for layout
+    void reset_layout();
+
     /**
      * Convenience definition for subclasses to get the full icon scale for this
      * class of Widget.  It simple returns the value
@@ -329,6 +514,25 @@ protected:
      */
     float m_icon_extra_scale;
     Cursor m_cursor;
+    std::vector<ref<BackgroundTask>> m_background_tasks;
+    bool m_retained = false;
+    bool m_display_list_valid = false;
+    NVGdisplayList *m_display_list = nullptr;
+    Vector2i m_display_list_pos;
+    bool m_cache_as_layer = false;
+    bool m_layer_valid = false;
+    LayerCache *m_layer_cache = nullptr;
+    SpatialIndex *m_spatial_index = nullptr;
+    mutable bool m_spatial_index_valid = false;
+    /* Cached preferred size, with the state it was computed for */
+    mutable Vector2i m_preferred_size_cache;
+    mutable const Theme *m_preferred_size_theme = nullptr;
+    mutable NVGcontext *m_preferred_size_ctx = nullptr;
+    mutable int m_preferred_size_font = 0;
+    mutable bool m_preferred_size_valid = false;
+    bool m_layout_dirty = true;
+    /// Has \ref perform_layout() been called at least once?
+    bool m_laid_out = false;
 };
 
 NAMESPACE_END(waylandgui)
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <waylandgui/widget.h>
+#include <waylandgui/textlayout.h>
 
 NAMESPACE_BEGIN(waylandgui)
 
@@ -29,7 +30,12 @@ public:
     /// Return the window title
     const std::string &title() const { return m_title; }
     /// Set the window title
-    void set_title(const std::string &title) { m_title = title; }
+    void set_title(const std::string &title) {
+        if (title != m_title) {
+            m_title = title;
+            invalidate_layout();
+        }
+    }
 
     /// Is this a model dialog?
     bool modal() const { return m_modal; }
@@ -62,11 +68,14 @@ public:
 protected:
     /// Internal helper function to maintain nested window position values; overridden in \ref Popup
     virtual void refresh_relative_placement();
+    /// The drop shadow extends beyond the window's bounds
+    virtual int layer_margin() const override;
 protected:
     std::string m_title;
     Widget *m_button_panel;
     bool m_modal;
     bool m_drag;
+    mutable TextLayout m_title_layout;
 };
 
 NAMESPACE_END(waylandgui)
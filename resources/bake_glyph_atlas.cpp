@@ -0,0 +1,172 @@
+/*
+    resources/bake_glyph_atlas.cpp -- Pre-rasterize glyphs of the bundled
+    fonts at build time
+
+    Usage: bake_glyph_atlas OUTPUT NAME=FONT.ttf... NAME:SIZES:BLUR:CODEPOINTS...
+
+    Loads each font under the name that the library registers it with, then
+    rasterizes the given codepoints at each of the comma separated sizes
+    (in pixels) and the given blur radius, e.g. "sans:16,20:0:20-7e,b0".
+    Codepoints are hexadecimal values or ranges. The glyphs are rasterized
+    by the same fontstash code as at runtime, and written along with their
+    metrics in the format that fonsAddBakedGlyphs() reads.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define FONTSTASH_IMPLEMENTATION
+#include <fontstash.h>
+
+/* Size of the pages of the NanoVG font atlas (NVG_FONT_PAGE_SIZE). The
+   baked glyphs are copied into a single page at runtime, so the baked
+   atlas must not be wider or taller */
+static const int page_size = 1024;
+
+/* Narrower than a page, and taller so that an oversized glyph set is
+   reported with its height rather than as a full atlas */
+static const int atlas_width = 512, atlas_height = 4096;
+
+static std::vector<std::string> split(const std::string &str, char sep) {
+    std::vector<std::string> result;
+    size_t begin = 0, end;
+    while ((end = str.find(sep, begin)) != std::string::npos) {
+        result.push_back(str.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    result.push_back(str.substr(begin));
+    return result;
+}
+
+static void bake(FONScontext *stash, const std::string &spec) {
+    std::vector<std::string> fields = split(spec, ':');
+    if (fields.size() != 4)
+        throw std::runtime_error("Invalid glyph set \"" + spec + "\"");
+
+    int font = fonsGetFontByName(stash, fields[0].c_str());
+    if (font == FONS_INVALID)
+        throw std::runtime_error("Unknown font \"" + fields[0] + "\"");
+    short iblur = (short) std::stoi(fields[2]);
+
+    for (const std::string &size : split(fields[1], ',')) {
+        /* Rounded as by fonsTextIterInit() */
+        short isize = (short) (std::stof(size) * 10.f);
+        for (const std::string &range : split(fields[3], ',')) {
+            std::vector<std::string> bounds = split(range, '-');
+            unsigned long first = std::stoul(bounds.front(), nullptr, 16),
+                          last  = std::stoul(bounds.back(), nullptr, 16);
+            for (unsigned long c = first; c <= last; ++c) {
+                if (!fons__getGlyph(stash, stash->fonts[font], (unsigned int) c, isize,
+                                    iblur, FONS_GLYPH_BITMAP_REQUIRED))
+                    throw std::runtime_error("Glyph atlas is full");
+            }
+        }
+    }
+}
+
+static void put_u32(std::vector<unsigned char> &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+        out.push_back((unsigned char) (value >> (8 * i)));
+}
+
+static void put_s16(std::vector<unsigned char> &out, short value) {
+    out.push_back((unsigned char) (value & 0xff));
+    out.push_back((unsigned char) ((unsigned short) value >> 8));
+}
+
+static std::vector<unsigned char> serialize(FONScontext *stash) {
+    int height = 0;
+    for (int i = 0; i < stash->nfonts; ++i)
+        for (int j = 0; j < stash->fonts[i]->nglyphs; ++j)
+            height = fons__maxi(height, stash->fonts[i]->glyphs[j].y1);
+    if (height > page_size)
+        throw std::runtime_error("Baked glyphs are " + std::to_string(height) +
+                                 " pixels tall, more than a font atlas page (" +
+                                 std::to_string(page_size) + "), bake fewer glyph sets");
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), "FONSBAKE", "FONSBAKE" + 8);
+    put_u32(out, atlas_width);
+    put_u32(out, height);
+    put_u32(out, stash->nfonts);
+
+    for (int i = 0; i < stash->nfonts; ++i) {
+        const FONSfont *font = stash->fonts[i];
+        out.insert(out.end(), font->name, font->name + sizeof(font->name));
+        put_u32(out, font->dataSize);
+        put_u32(out, font->nglyphs);
+        for (int j = 0; j < font->nglyphs; ++j) {
+            const FONSglyph &g = font->glyphs[j];
+            put_u32(out, g.codepoint);
+            put_u32(out, g.index);
+            for (short value : { g.size, g.blur, g.x0, g.y0, g.x1, g.y1,
+                                 g.xadv, g.xoff, g.yoff, (short) 0 })
+                put_s16(out, value);
+        }
+    }
+
+    const unsigned char *pixels = stash->pages[0].texData;
+    out.insert(out.end(), pixels, pixels + atlas_width * height);
+    return out;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s OUTPUT NAME=FONT.ttf... NAME:SIZES:BLUR:CODEPOINTS...\n", argv[0]);
+        return 1;
+    }
+
+    FONSparams params;
+    memset(&params, 0, sizeof(params));
+    params.width = atlas_width;
+    params.height = atlas_height;
+    params.flags = FONS_ZERO_TOPLEFT;
+    /* A single page, so that all glyphs end up in one block */
+    params.maxPages = 1;
+    FONScontext *stash = fonsCreateInternal(&params);
+    if (!stash) {
+        fprintf(stderr, "Could not create font stash!\n");
+        return 1;
+    }
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos)
+                continue;
+            std::string name = arg.substr(0, eq), path = arg.substr(eq + 1);
+            if (fonsAddFont(stash, name.c_str(), path.c_str()) == FONS_INVALID)
+                throw std::runtime_error("Could not load font \"" + path + "\"");
+        }
+        for (int i = 2; i < argc; ++i) {
+            if (!strchr(argv[i], '='))
+                bake(stash, argv[i]);
+        }
+
+        std::vector<unsigned char> data = serialize(stash);
+        FILE *f = fopen(argv[1], "wb");
+        if (!f || fwrite(data.data(), 1, data.size(), f) != data.size())
+            throw std::runtime_error("Could not write \"" + std::string(argv[1]) + "\"");
+        fclose(f);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "bake_glyph_atlas: %s\n", e.what());
+        fonsDeleteInternal(stash);
+        return 1;
+    }
+
+    fonsDeleteInternal(stash);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+    resources/pack_resources.cpp -- Bundle resource files into a pack that
+    the library maps into memory at runtime
+
+    Usage: pack_resources OUTPUT FILE...
+
+    Each file is stored under its file name. See waylandgui/resourcepack.h
+    for the format.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Keep in sync with src/resourcepack.cpp */
+static const size_t header_size = 16, entry_size = 64, name_size = 56, alignment = 4096;
+
+static void put_u32(std::vector<unsigned char> &out, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+        out[offset + i] = (unsigned char) (value >> (8 * i));
+}
+
+static std::vector<unsigned char> read_file(const std::string &path) {
+    std::vector<unsigned char> data;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        throw std::runtime_error("Could not open \"" + path + "\"");
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s OUTPUT FILE...\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        size_t count = (size_t) argc - 2;
+        std::vector<unsigned char> out(header_size + count * entry_size, 0);
+        std::copy_n("WGUIPACK", 8, out.begin());
+        put_u32(out, 8, 1);
+        put_u32(out, 12, (uint32_t) count);
+
+        for (size_t i = 0; i < count; ++i) {
+            std::string path = argv[i + 2];
+            std::string name = path.substr(path.find_last_of('/') + 1);
+            if (name.size() >= name_size)
+                throw std::runtime_error("Name of \"" + path + "\" is too long");
+            std::vector<unsigned char> data = read_file(path);
+
+            /* Resources start on pages of their own, so that mapping one
+               never reads any of another */
+            out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+            size_t entry = header_size + i * entry_size;
+            std::copy(name.begin(), name.end(), out.begin() + entry);
+            put_u32(out, entry + name_size, (uint32_t) out.size());
+            put_u32(out, entry + name_size + 4, (uint32_t) data.size());
+            out.insert(out.end(), data.begin(), data.end());
+        }
+
+        FILE *f = fopen(argv[1], "wb");
+        if (!f || fwrite(out.data(), 1, out.size(), f) != out.size())
+            throw std::runtime_error("Could not write \"" + std::string(argv[1]) + "\"");
+        fclose(f);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "pack_resources: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+    resources/subset_font.cpp -- Reduce a TrueType font to the glyphs of a
+    set of codepoints at build time
+
+    Usage: subset_font INPUT.ttf OUTPUT.ttf CODEPOINTS
+
+    Codepoints are comma separated hexadecimal values or ranges, e.g.
+    "20-7e,a0-17f,20ac", or "*" to copy the font as it is. The outlines of
+    all other glyphs are dropped, except for glyph 0 and the components of
+    composite glyphs that are kept. Glyph indices stay the same, so that
+    the metrics, kerning pairs and hinting programs remain valid, and glyph
+    atlases baked from the subset match it. The character map is replaced
+    by one that only holds the given codepoints, and the glyph names along
+    with the OpenType layout tables, which fontstash does not use, are
+    dropped.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+typedef std::vector<unsigned char> Bytes;
+
+/* Tables that fontstash has no use for */
+static const char *dropped_tables[] = {
+    "GSUB", "GPOS", "GDEF", "JSTF", "BASE", "DSIG", "hdmx", "LTSH", "VDMX", "PCLT"
+};
+
+static uint16_t get_u16(const Bytes &data, size_t offset) {
+    if (offset + 2 > data.size())
+        throw std::runtime_error("Truncated font");
+    return (uint16_t) (data[offset] << 8 | data[offset + 1]);
+}
+
+static uint32_t get_u32(const Bytes &data, size_t offset) {
+    return (uint32_t) get_u16(data, offset) << 16 | get_u16(data, offset + 2);
+}
+
+static void put_u16(Bytes &out, uint16_t value) {
+    out.push_back((unsigned char) (value >> 8));
+    out.push_back((unsigned char) value);
+}
+
+static void put_u32(Bytes &out, uint32_t value) {
+    put_u16(out, (uint16_t) (value >> 16));
+    put_u16(out, (uint16_t) value);
+}
+
+static void set_u16(Bytes &out, size_t offset, uint16_t value) {
+    out[offset] = (unsigned char) (value >> 8);
+    out[offset + 1] = (unsigned char) value;
+}
+
+static void set_u32(Bytes &out, size_t offset, uint32_t value) {
+    set_u16(out, offset, (uint16_t) (value >> 16));
+    set_u16(out, offset + 2, (uint16_t) value);
+}
+
+static uint32_t checksum(const Bytes &data) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < data.size(); i += 4) {
+        uint32_t word = 0;
+        for (size_t j = 0; j < 4; ++j)
+            word = word << 8 | (i + j < data.size() ? data[i + j] : 0);
+        sum += word;
+    }
+    return sum;
+}
+
+static std::vector<std::string> split(const std::string &str, char sep) {
+    std::vector<std::string> result;
+    size_t begin = 0, end;
+    while ((end = str.find(sep, begin)) != std::string::npos) {
+        result.push_back(str.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    result.push_back(str.substr(begin));
+    return result;
+}
+
+static Bytes read_file(const char *path) {
+    Bytes data;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        throw std::runtime_error("Could not open \"" + std::string(path) + "\"");
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return data;
+}
+
+static void write_file(const char *path, const Bytes &data) {
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(data.data(), 1, data.size(), f) != data.size())
+        throw std::runtime_error("Could not write \"" + std::string(path) + "\"");
+    fclose(f);
+}
+
+struct Font {
+    Bytes data;
+    /* Offset and length of each table by tag */
+    std::map<std::string, std::pair<uint32_t, uint32_t>> tables;
+
+    Bytes table(const std::string &tag) const {
+        auto it = tables.find(tag);
+        if (it == tables.end())
+            throw std::runtime_error("Font has no '" + tag + "' table");
+        if ((size_t) it->second.first + it->second.second > data.size())
+            throw std::runtime_error("Truncated '" + tag + "' table");
+        return Bytes(data.begin() + it->second.first,
+                     data.begin() + it->second.first + it->second.second);
+    }
+};
+
+static Font parse(Bytes data) {
+    Font font;
+    font.data = std::move(data);
+    uint32_t version = get_u32(font.data, 0);
+    if (version != 0x00010000 && version != 0x74727565 /* 'true' */)
+        throw std::runtime_error("Not a TrueType font with glyph outlines");
+    uint16_t ntables = get_u16(font.data, 4);
+    for (uint16_t i = 0; i < ntables; ++i) {
+        size_t record = 12 + 16 * (size_t) i;
+        std::pair<uint32_t, uint32_t> range = { get_u32(font.data, record + 8),
+                                                get_u32(font.data, record + 12) };
+        font.tables[std::string(font.data.begin() + record, font.data.begin() + record + 4)] = range;
+    }
+    return font;
+}
+
+/// Offset and length of the outline of each glyph in the 'glyf' table
+static std::vector<std::pair<uint32_t, uint32_t>> glyph_ranges(const Font &font, int nglyphs) {
+    Bytes head = font.table("head"), loca = font.table("loca");
+    bool long_offsets = get_u16(head, 50) != 0;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (int i = 0; i < nglyphs; ++i) {
+        uint32_t begin, end;
+        if (long_offsets) {
+            begin = get_u32(loca, 4 * (size_t) i);
+            end = get_u32(loca, 4 * (size_t) i + 4);
+        } else {
+            begin = 2u * get_u16(loca, 2 * (size_t) i);
+            end = 2u * get_u16(loca, 2 * (size_t) i + 2);
+        }
+        ranges.push_back({ begin, end > begin ? end - begin : 0 });
+    }
+    return ranges;
+}
+
+/// Add the components of a composite glyph to the glyphs to keep
+static void add_components(const Bytes &glyph, std::set<int> &keep, std::vector<int> &todo) {
+    if (glyph.size() < 10 || (int16_t) get_u16(glyph, 0) >= 0)
+        return;
+    size_t offset = 10;
+    uint16_t flags;
+    do {
+        flags = get_u16(glyph, offset);
+        int component = get_u16(glyph, offset + 2);
+        if (keep.insert(component).second)
+            todo.push_back(component);
+        offset += 4 + ((flags & 0x0001) ? 4 : 2);
+        if (flags & 0x0008)
+            offset += 2;
+        else if (flags & 0x0040)
+            offset += 4;
+        else if (flags & 0x0080)
+            offset += 8;
+    } while (flags & 0x0020);
+}
+
+/// Character map with a single format 12 subtable for Unicode on Windows
+static Bytes build_cmap(const std::map<uint32_t, int> &mapping) {
+    /* Runs of consecutive codepoints mapped to consecutive glyphs */
+    struct Group { uint32_t first, last, glyph; };
+    std::vector<Group> groups;
+    for (const auto &entry : mapping) {
+        if (!groups.empty() && groups.back().last + 1 == entry.first &&
+            groups.back().glyph + (entry.first - groups.back().first) == (uint32_t) entry.second)
+            groups.back().last = entry.first;
+        else
+            groups.push_back({ entry.first, entry.first, (uint32_t) entry.second });
+    }
+
+    Bytes cmap;
+    put_u16(cmap, 0);          // version
+    put_u16(cmap, 1);          // number of subtables
+    put_u16(cmap, 3);          // platform: Windows
+    put_u16(cmap, 10);         // encoding: Unicode full repertoire
+    put_u32(cmap, 12);         // offset of the subtable
+    put_u16(cmap, 12);         // format
+    put_u16(cmap, 0);
+    put_u32(cmap, (uint32_t) (16 + 12 * groups.size()));
+    put_u32(cmap, 0);          // language
+    put_u32(cmap, (uint32_t) groups.size());
+    for (const Group &group : groups) {
+        put_u32(cmap, group.first);
+        put_u32(cmap, group.last);
+        put_u32(cmap, group.glyph);
+    }
+    return cmap;
+}
+
+static Bytes subset(const Font &font, const std::string &codepoints) {
+    stbtt_fontinfo info;
+    if (!stbtt_InitFont(&info, font.data.data(), 0))
+        throw std::runtime_error("Could not parse font");
+
+    int nglyphs = get_u16(font.table("maxp"), 4);
+    std::map<uint32_t, int> mapping;
+    std::set<int> keep = { 0 };
+    std::vector<int> todo;
+    for (const std::string &range : split(codepoints, ',')) {
+        std::vector<std::string> bounds = split(range, '-');
+        unsigned long first = std::stoul(bounds.front(), nullptr, 16),
+                      last  = std::stoul(bounds.back(), nullptr, 16);
+        for (unsigned long c = first; c <= last; ++c) {
+            int glyph = stbtt_FindGlyphIndex(&info, (int) c);
+            if (glyph == 0)
+                continue;
+            mapping[(uint32_t) c] = glyph;
+            if (keep.insert(glyph).second)
+                todo.push_back(glyph);
+        }
+    }
+
+    Bytes glyf_in = font.table("glyf");
+    std::vector<std::pair<uint32_t, uint32_t>> ranges = glyph_ranges(font, nglyphs);
+    while (!todo.empty()) {
+        int glyph = todo.back();
+        todo.pop_back();
+        if (glyph >= nglyphs)
+            throw std::runtime_error("Invalid glyph index");
+        const auto &range = ranges[glyph];
+        if ((size_t) range.first + range.second > glyf_in.size())
+            throw std::runtime_error("Truncated 'glyf' table");
+        add_components(Bytes(glyf_in.begin() + range.first,
+                             glyf_in.begin() + range.first + range.second), keep, todo);
+    }
+
+    /* Outlines of the glyphs to keep, with long offsets */
+    Bytes glyf, loca;
+    for (int i = 0; i < nglyphs; ++i) {
+        put_u32(loca, (uint32_t) glyf.size());
+        if (keep.count(i)) {
+            glyf.insert(glyf.end(), glyf_in.begin() + ranges[i].first,
+                        glyf_in.begin() + ranges[i].first + ranges[i].second);
+            while (glyf.size() % 4)
+                glyf.push_back(0);
+        }
+    }
+    put_u32(loca, (uint32_t) glyf.size());
+
+    std::map<std::string, Bytes> tables;
+    for (const auto &entry : font.tables) {
+        const std::string &tag = entry.first;
+        if (std::find(std::begin(dropped_tables), std::end(dropped_tables), tag) !=
+            std::end(dropped_tables))
+            continue;
+        tables[tag] = font.table(tag);
+    }
+    tables["glyf"] = glyf;
+    tables["loca"] = loca;
+    tables["cmap"] = build_cmap(mapping);
+    set_u16(tables["head"], 50, 1);      // indexToLocFormat: long offsets
+    set_u32(tables["head"], 8, 0);       // checkSumAdjustment, set below
+    if (tables.count("post") && tables["post"].size() >= 32) {
+        /* Version 3 has no glyph names */
+        tables["post"].resize(32);
+        set_u32(tables["post"], 0, 0x00030000);
+    }
+
+    /* Table directory, sorted by tag, followed by the 4-byte aligned tables */
+    uint16_t ntables = (uint16_t) tables.size(), entry_selector = 0;
+    while ((2u << entry_selector) <= ntables)
+        ++entry_selector;
+    uint16_t search_range = (uint16_t) (16u << entry_selector);
+
+    Bytes out;
+    put_u32(out, 0x00010000);
+    put_u16(out, ntables);
+    put_u16(out, search_range);
+    put_u16(out, entry_selector);
+    put_u16(out, (uint16_t) (ntables * 16 - search_range));
+
+    uint32_t offset = 12 + 16u * ntables;
+    for (const auto &entry : tables) {
+        out.insert(out.end(), entry.first.begin(), entry.first.end());
+        put_u32(out, checksum(entry.second));
+        put_u32(out, offset);
+        put_u32(out, (uint32_t) entry.second.size());
+        offset += (uint32_t) (entry.second.size() + 3) / 4 * 4;
+    }
+
+    size_t head_offset = 0;
+    for (const auto &entry : tables) {
+        if (entry.first == "head")
+            head_offset = out.size();
+        out.insert(out.end(), entry.second.begin(), entry.second.end());
+        while (out.size() % 4)
+            out.push_back(0);
+    }
+    set_u32(out, head_offset + 8, 0xB1B0AFBAu - checksum(out));
+    return out;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s INPUT.ttf OUTPUT.ttf CODEPOINTS\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        Bytes data = read_file(argv[1]);
+        if (strcmp(argv[3], "*") != 0)
+            data = subset(parse(std::move(data)), argv[3]);
+        write_file(argv[2], data);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "subset_font: %s: %s\n", argv[1], e.what());
+        return 1;
+    }
+    return 0;
+}
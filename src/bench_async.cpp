@@ -0,0 +1,111 @@
+/*
+    src/bench_async.cpp -- Contention benchmark for the async() task queue
+
+    Compares the lock-free TaskQueue used by waylandgui::async() against the
+    previous std::mutex + std::vector<std::function> implementation. A
+    single consumer thread drains the queue while 1, 4 and 8 producer
+    threads post small tasks as fast as they can.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include "task_queue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+using namespace waylandgui;
+
+static const size_t tasks_per_producer = 1'000'000;
+
+/// The original async() queue
+struct MutexQueue {
+    std::mutex mutex;
+    std::vector<std::function<void()>> functions;
+
+    void push(const std::function<void()> &func) {
+        std::lock_guard<std::mutex> guard(mutex);
+        functions.push_back(func);
+    }
+
+    void run_all() {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto &f : functions)
+            f();
+        functions.clear();
+    }
+};
+
+/// The lock-free queue used by async()
+struct LockFreeQueue {
+    TaskQueue queue;
+
+    void push(Task &&task) { queue.push(std::move(task)); }
+
+    void run_all() {
+        queue.consume([](Task &task) { task(); });
+    }
+};
+
+struct Result {
+    double total;     /* Time until all tasks have run [s] */
+    double max_push;  /* Worst-case duration of a single push() [s] */
+};
+
+template <typename Queue> Result run(size_t producers) {
+    Queue queue;
+    size_t total = producers * tasks_per_producer, executed = 0;
+    std::vector<std::thread> threads;
+    std::vector<double> max_push(producers, 0.0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < producers; ++i) {
+        threads.emplace_back([&queue, &executed, &max_push, i]() {
+            double worst = 0.0;
+            for (size_t j = 0; j < tasks_per_producer; ++j) {
+                auto t0 = std::chrono::steady_clock::now();
+                queue.push([&executed]() {
+                    /* Simulate a small UI update */
+                    for (volatile int k = 0; k < 50; ++k)
+                        ;
+                    executed++;
+                });
+                auto t1 = std::chrono::steady_clock::now();
+                worst = std::max(worst, std::chrono::duration<double>(t1 - t0).count());
+            }
+            max_push[i] = worst;
+        });
+    }
+
+    while (executed < total)
+        queue.run_all();
+
+    auto end = std::chrono::steady_clock::now();
+    for (auto &t : threads)
+        t.join();
+
+    return Result { std::chrono::duration<double>(end - start).count(),
+                    *std::max_element(max_push.begin(), max_push.end()) };
+}
+
+int main(int /* argc */, char ** /* argv */) {
+    printf("%zu tasks per producer, %u hardware threads\n\n", tasks_per_producer,
+           std::thread::hardware_concurrency());
+    printf("%-10s %-14s %12s %16s\n", "producers", "queue", "total [ms]", "max push [us]");
+    for (size_t producers : { 1, 4, 8 }) {
+        Result r_mutex    = run<MutexQueue>(producers),
+               r_lockfree = run<LockFreeQueue>(producers);
+        printf("%-10zu %-14s %12.1f %16.1f\n", producers, "mutex+vector",
+               r_mutex.total * 1e3, r_mutex.max_push * 1e6);
+        printf("%-10zu %-14s %12.1f %16.1f\n", producers, "lock-free",
+               r_lockfree.total * 1e3, r_lockfree.max_push * 1e6);
+    }
+    return 0;
+}
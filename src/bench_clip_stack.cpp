@@ -0,0 +1,206 @@
+/*
+    src/bench_clip_stack.cpp -- Per-child cost of clipping in Widget::draw
+
+    Widget::draw clips every child to its bounds. This compares the previous
+    nvgSave() + nvgIntersectScissor() + nvgRestore() sequence against
+    nvgPushClip() / nvgPopClip(), for children that draw nothing and for
+    children that also set a fill color (which makes nvgPushClip() copy the
+    full state after all). Then, it times Widget::draw() on a panel of
+    10,000 empty children. Finally, it draws nested children that change
+    more or less of the state, under translations, rotations and scales,
+    both ways, and compares the hashes of every paint, scissor and vertex
+    submitted. Exits with a non-zero status if they differ, since both ways
+    must give identical pixels. Uses the null backend from
+    bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/widget.h>
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int children = 10000;
+static const int frames = 200;
+
+/// Average time per child in nanoseconds
+template <typename Func> static double time_per_child(NVGcontext *ctx, Func func) {
+    auto frame = [&]() {
+        nvgBeginFrame(ctx, 1024, 768, 1.f);
+        nvgScissor(ctx, 0, 0, 1024, 768);
+        nvgTranslate(ctx, 10, 10);
+        for (int i = 0; i < children; ++i)
+            func((float) (i % 100) * 10, (float) (i / 100) * 7);
+        nvgEndFrame(ctx);
+    };
+
+    frame();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        frame();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           ((double) frames * children);
+}
+
+/// Clip a child to its bounds, like Widget::draw() does now (lean) or did before
+static void begin_clip(NVGcontext *ctx, bool lean, float x, float y, float w, float h) {
+    if (lean) {
+        nvgPushClip(ctx, x, y, w, h);
+    } else {
+        nvgSave(ctx);
+        nvgIntersectScissor(ctx, x, y, w, h);
+    }
+}
+
+static void end_clip(NVGcontext *ctx, bool lean) {
+    if (lean)
+        nvgPopClip(ctx);
+    else
+        nvgRestore(ctx);
+}
+
+/// Draw three levels of children, each changing a different part of the state
+static void draw_children(NVGcontext *ctx, const Theme *theme, bool lean, int depth) {
+    for (int i = 0; i < 6; ++i) {
+        float x = 7.f * i + .25f * depth, y = 5.f * i + .5f,
+              w = 60.f - 12.f * depth + i, h = 40.f - 8.f * depth;
+        begin_clip(ctx, lean, x, y, w, h);
+        nvgTranslate(ctx, x, y);
+
+        switch ((i + depth) % 6) {
+            case 0: /* Only the transform and scissor */ break;
+            case 1:
+                nvgFillColor(ctx, nvgRGBA(255, 40 * i, 0, 255));
+                nvgFontFaceId(ctx, theme->m_font_sans_regular);
+                nvgFontSize(ctx, 14.f + depth);
+                nvgText(ctx, 2.f, 12.f, "Clipped", nullptr);
+                break;
+            case 2: nvgRotate(ctx, .1f * (i + 1)); break;
+            case 3: nvgScale(ctx, 1.5f, .75f); break;
+            case 4:
+                nvgSave(ctx);
+                nvgStrokeWidth(ctx, 2.5f);
+                nvgStrokeColor(ctx, nvgRGBA(0, 0, 255, 128));
+                nvgBeginPath(ctx);
+                nvgRect(ctx, 2.f, 2.f, w - 4.f, h - 4.f);
+                nvgStroke(ctx);
+                nvgRestore(ctx);
+                break;
+            case 5:
+                nvgGlobalAlpha(ctx, .5f);
+                nvgFillPaint(ctx, nvgLinearGradient(ctx, 0.f, 0.f, w, h, nvgRGBA(0, 255, 0, 255),
+                                                    nvgRGBA(0, 0, 0, 0)));
+                break;
+        }
+
+        nvgBeginPath(ctx);
+        nvgRect(ctx, 1.f, 1.f, w - 2.f, h - 2.f);
+        nvgFill(ctx);
+        if (depth < 2)
+            draw_children(ctx, theme, lean, depth + 1);
+        end_clip(ctx, lean);
+
+        /* Drawn with the state of the parent, which must be back */
+        nvgBeginPath(ctx);
+        nvgRect(ctx, x, y, 3.f, 3.f);
+        nvgFill(ctx);
+    }
+}
+
+/// Return the hash of everything submitted while drawing the children at two pixel ratios
+static uint64_t clip_hash(NVGcontext *ctx, const Theme *theme, bool lean) {
+    submission_hash = 14695981039346656037ull;
+    hash_submissions = true;
+    for (float ratio : { 1.f, 1.5f }) {
+        nvgBeginFrame(ctx, 640, 480, ratio);
+        nvgScissor(ctx, 0, 0, 640, 480);
+        nvgTranslate(ctx, 10.5f, 20.f);
+        nvgFillColor(ctx, nvgRGBA(200, 200, 200, 255));
+        draw_children(ctx, theme, lean, 0);
+        nvgEndFrame(ctx);
+    }
+    hash_submissions = false;
+    return submission_hash;
+}
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    NVGcolor color = nvgRGBA(255, 255, 255, 32);
+
+    double save = time_per_child(ctx, [&](float x, float y) {
+        nvgSave(ctx);
+        nvgIntersectScissor(ctx, x, y, 10, 7);
+        nvgRestore(ctx);
+    });
+    double push = time_per_child(ctx, [&](float x, float y) {
+        nvgPushClip(ctx, x, y, 10, 7);
+        nvgPopClip(ctx);
+    });
+    double save_fill = time_per_child(ctx, [&](float x, float y) {
+        nvgSave(ctx);
+        nvgIntersectScissor(ctx, x, y, 10, 7);
+        nvgFillColor(ctx, color);
+        nvgRestore(ctx);
+    });
+    double push_fill = time_per_child(ctx, [&](float x, float y) {
+        nvgPushClip(ctx, x, y, 10, 7);
+        nvgFillColor(ctx, color);
+        nvgPopClip(ctx);
+    });
+
+    printf("Clipping overhead per child (%i children, %i frames):\n", children, frames);
+    printf("                      %14s %14s\n", "save/restore", "push/pop clip");
+    printf("  child draws nothing %11.1f ns %11.1f ns\n", save, push);
+    printf("  child sets a color  %11.1f ns %11.1f ns\n", save_fill, push_fill);
+
+    /* Scope the widgets so that they are released before the context */ {
+        ref<Widget> root = new Widget(nullptr);
+        root->set_theme(new Theme(ctx));
+        root->set_size(Vector2i(1024, 768));
+        for (int i = 0; i < children; ++i) {
+            Widget *child = new Widget(root);
+            child->set_position(Vector2i((i % 100) * 10, (i / 100) * 7));
+            child->set_size(Vector2i(10, 7));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            nvgBeginFrame(ctx, 1024, 768, 1.f);
+            root->draw(ctx);
+            nvgEndFrame(ctx);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        printf("  Widget::draw()      %11.1f ns per child\n",
+               std::chrono::duration<double, std::nano>(end - start).count() /
+                   ((double) frames * children));
+    }
+
+    bool identical;
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        uint64_t save = clip_hash(ctx, theme.get(), false), push = clip_hash(ctx, theme.get(), true);
+        identical = save == push;
+        printf("Submitted paints, scissors and vertices: save/restore %016llx, push/pop clip %016llx%s\n",
+               (unsigned long long) save, (unsigned long long) push, identical ? "" : "  <- differ");
+    }
+
+    nvgDeleteInternal(ctx);
+    return identical ? 0 : 1;
+}
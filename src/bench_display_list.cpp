@@ -0,0 +1,155 @@
+/*
+    src/bench_display_list.cpp -- CPU cost of drawing retained vs. immediate widgets
+
+    Builds the "Button demo" and "Basic widgets" windows of example1 (minus
+    the widgets that need a Screen) and measures the time NanoVG spends on
+    the CPU to draw them, with and without Widget::set_retained(), using the
+    null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/window.h>
+#include <waylandgui/layout.h>
+#include <waylandgui/label.h>
+#include <waylandgui/button.h>
+#include <waylandgui/toolbutton.h>
+#include <waylandgui/checkbox.h>
+#include <waylandgui/progressbar.h>
+#include <waylandgui/slider.h>
+#include <waylandgui/textbox.h>
+#include <waylandgui/theme.h>
+#include <waylandgui/icons.h>
+#include <chrono>
+#include <cstdio>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 2000;
+
+static std::vector<Window *> build_widgets(Widget *root) {
+    Window *window = new Window(root, "Button demo");
+    window->set_position(Vector2i(15, 15));
+    window->set_layout(new GroupLayout());
+
+    new Label(window, "Push buttons", "sans-bold");
+    new Button(window, "Plain button");
+    Button *b = new Button(window, "Styled", FA_ROCKET);
+    b->set_background_color(Color(0, 0, 255, 25));
+
+    new Label(window, "Toggle buttons", "sans-bold");
+    b = new Button(window, "Toggle me");
+    b->set_flags(Button::ToggleButton);
+
+    new Label(window, "Radio buttons", "sans-bold");
+    b = new Button(window, "Radio button 1");
+    b->set_flags(Button::RadioButton);
+    b = new Button(window, "Radio button 2");
+    b->set_flags(Button::RadioButton);
+
+    new Label(window, "A tool palette", "sans-bold");
+    Widget *tools = new Widget(window);
+    tools->set_layout(new BoxLayout(Orientation::Horizontal,
+                                    Alignment::Middle, 0, 6));
+    new ToolButton(tools, FA_CLOUD);
+    new ToolButton(tools, FA_FAST_FORWARD);
+    new ToolButton(tools, FA_COMPASS);
+    new ToolButton(tools, FA_UTENSILS);
+
+    Window *window2 = new Window(root, "Basic widgets");
+    window2->set_position(Vector2i(200, 15));
+    window2->set_layout(new GroupLayout());
+
+    new Label(window2, "Message dialog", "sans-bold");
+    tools = new Widget(window2);
+    tools->set_layout(new BoxLayout(Orientation::Horizontal,
+                                    Alignment::Middle, 0, 6));
+    new Button(tools, "Info");
+    new Button(tools, "Warn");
+    new Button(tools, "Ask");
+
+    new Label(window2, "Check box", "sans-bold");
+    CheckBox *cb = new CheckBox(window2, "Flag 1");
+    cb->set_checked(true);
+    new CheckBox(window2, "Flag 2");
+
+    new Label(window2, "Progress bar", "sans-bold");
+    ProgressBar *progress = new ProgressBar(window2);
+    progress->set_value(0.35f);
+
+    new Label(window2, "Slider and text box", "sans-bold");
+    Widget *panel = new Widget(window2);
+    panel->set_layout(new BoxLayout(Orientation::Horizontal,
+                                    Alignment::Middle, 0, 20));
+    Slider *slider = new Slider(panel);
+    slider->set_value(0.5f);
+    slider->set_fixed_width(80);
+    TextBox *text_box = new TextBox(panel);
+    text_box->set_fixed_size(Vector2i(60, 25));
+    text_box->set_value("50");
+    text_box->set_units("%");
+    text_box->set_font_size(20);
+    text_box->set_alignment(TextBox::Alignment::Right);
+
+    return { window, window2 };
+}
+
+/// Average CPU time per frame in microseconds
+static double run(NVGcontext *ctx, Widget *root, const std::vector<Window *> &windows,
+                  bool retained, bool move) {
+    for (Window *w : windows)
+        w->set_retained(retained);
+
+    auto frame = [&](int i) {
+        if (move)
+            windows[0]->set_position(Vector2i(15 + i % 100, 15));
+        nvgBeginFrame(ctx, 1024, 768, 1.f);
+        root->draw(ctx);
+        nvgEndFrame(ctx);
+    };
+
+    /* Warm up glyph caches and recordings */
+    for (int i = 0; i < 10; ++i)
+        frame(i);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        frame(i);
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the widgets so that they are released before the context */ {
+        ref<Widget> root = new Widget(nullptr);
+        root->set_theme(new Theme(ctx));
+        root->set_size(Vector2i(1024, 768));
+        std::vector<Window *> windows = build_widgets(root);
+        root->perform_layout(ctx);
+
+        double immediate = run(ctx, root, windows, false, false),
+               retained = run(ctx, root, windows, true, false),
+               moved = run(ctx, root, windows, true, true);
+
+        printf("example1 widget set, %i frames (CPU time per frame):\n", frames);
+        printf("  immediate:               %8.1f us\n", immediate);
+        printf("  retained:                %8.1f us (%.1fx)\n", retained, immediate / retained);
+        printf("  retained, window moving: %8.1f us (%.1fx)\n", moved, immediate / moved);
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+    src/bench_first_frame.cpp -- Cost of the first frame of a new screen
+
+    Creates a screen with a window of labels, buttons, text boxes, check
+    boxes and a tab header in the default theme, and measures the time to
+    create the theme, to lay out the window and to draw the first frame,
+    then the time of a later frame. The first frame used to rasterize every
+    glyph it showed; with WAYLANDGUI_BAKE_GLYPHS, the theme seeds the glyph
+    cache with glyphs rasterized at build time instead. Uses the null
+    backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/screen.h>
+#include <waylandgui/window.h>
+#include <waylandgui/layout.h>
+#include <waylandgui/label.h>
+#include <waylandgui/button.h>
+#include <waylandgui/checkbox.h>
+#include <waylandgui/textbox.h>
+#include <waylandgui/tabwidget.h>
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int runs = 50;
+
+/// Screen without a window, which lays out widgets with the given context
+class BenchScreen : public Screen {
+public:
+    BenchScreen(NVGcontext *ctx) {
+        m_nvg_context = ctx;
+        m_size = Vector2i(1280, 800);
+    }
+
+    ~BenchScreen() {
+        /* Owned by main() */
+        m_nvg_context = nullptr;
+    }
+};
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    double theme = 0, layout = 0, first = 0, later = 0;
+
+    for (int run = 0; run < runs; ++run) {
+        NVGcontext *ctx = create_null_context();
+        if (!ctx) {
+            fprintf(stderr, "Could not create NanoVG context!\n");
+            return 1;
+        }
+
+        /* Scope the widgets so that they are released before the context */ {
+            auto t0 = clock::now();
+            ref<BenchScreen> screen = new BenchScreen(ctx);
+            screen->set_theme(new Theme(ctx));
+
+            auto t1 = clock::now();
+            Window *window = new Window(screen, "Settings");
+            window->set_layout(new GridLayout(Orientation::Horizontal, 4, Alignment::Middle, 5, 2));
+            for (int i = 0; i < 8; ++i) {
+                std::string n = std::to_string(i);
+                new Label(window, "Parameter " + n + ": scale, offset & gain");
+                new Button(window, "Apply #" + n);
+                TextBox *text_box = new TextBox(window, "0." + n + "5");
+                text_box->set_units("mm/s");
+                text_box->set_spinnable(true);
+                new CheckBox(window, "Enabled (" + n + ")");
+            }
+            TabWidgetBase *tabs = new TabWidgetBase(window);
+            for (const char *caption : { "General", "Advanced", "Output" })
+                tabs->append_tab(caption);
+            tabs->set_tabs_closeable(true);
+            screen->perform_layout();
+
+            auto frame = [&]() {
+                nvgBeginFrame(ctx, 1280, 800, 1.f);
+                window->draw(ctx);
+                nvgEndFrame(ctx);
+            };
+
+            auto t2 = clock::now();
+            frame();
+            auto t3 = clock::now();
+            frame();
+            auto t4 = clock::now();
+
+            theme  += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            layout += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            first  += std::chrono::duration<double, std::micro>(t3 - t2).count();
+            later  += std::chrono::duration<double, std::micro>(t4 - t3).count();
+        }
+
+        nvgDeleteInternal(ctx);
+    }
+
+    printf("New screen with 33 widgets, average of %i runs:\n", runs);
+    printf("  theme creation  %10.1f us\n", theme / runs);
+    printf("  layout          %10.1f us\n", layout / runs);
+    printf("  first frame     %10.1f us\n", first / runs);
+    printf("  second frame    %10.1f us\n", later / runs);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+    src/bench_font_fallback.cpp -- Cost of measuring text from fallback fonts
+
+    Chains the mono and icon fonts as fallbacks of the sans font, then
+    measures 40 Latin characters, which the sans font has, or 40 icons,
+    which only the last fallback has, with nvgTextBounds() at 400 sizes.
+    Every size creates new glyphs, each of which must be found in the font
+    chain. The icons are measured once as they are, and once after they
+    were resolved ahead with nvgResolveText(). Each run uses a fresh
+    context. Uses the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int sizes = 400;
+
+static void run(const char *name, const std::string &text, bool resolve) {
+    using clock = std::chrono::steady_clock;
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return;
+    }
+
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        nvgAddFallbackFontId(ctx, theme->m_font_sans_regular, theme->m_font_mono_regular);
+        nvgAddFallbackFontId(ctx, theme->m_font_sans_regular, theme->m_font_icons);
+        nvgFontFaceId(ctx, theme->m_font_sans_regular);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+
+        double ahead = 0;
+        if (resolve) {
+            auto start = clock::now();
+            nvgResolveText(ctx, text.c_str(), nullptr);
+            ahead = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+        }
+
+        auto start = clock::now();
+        for (int i = 0; i < sizes; ++i) {
+            nvgFontSize(ctx, 10.f + i * .1f);
+            nvgTextBounds(ctx, 0, 0, text.c_str(), nullptr, nullptr);
+        }
+        auto end = clock::now();
+
+        printf("  %-28s %8.2f us per size", name,
+               std::chrono::duration<double, std::micro>(end - start).count() / sizes);
+        if (resolve)
+            printf(" (%.1f us to resolve)", ahead);
+        printf("\n");
+    }
+
+    nvgDeleteInternal(ctx);
+}
+
+int main() {
+    std::string latin, icons;
+    for (uint32_t i = 0; i < 40; ++i) {
+        latin += utf8(0x41 + i % 26);
+        icons += utf8(0xf002 + i % 20);
+    }
+
+    printf("40 characters measured at %i sizes, each of which creates new glyphs:\n", sizes);
+    run("primary font", latin, false);
+    run("last fallback font", icons, false);
+    run("last fallback, resolved", icons, true);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+    src/bench_font_metrics.cpp -- Frame times while a large amount of text
+    is measured
+
+    Draws frames of 60 lines of text at 60 frames per second while 20000
+    log lines are measured for TextArea::append(). First, the log is
+    measured on the drawing thread, as append() does; then, on 1, 2 and 4
+    worker threads with contexts of FontMetrics, each thread measuring its
+    share of the log. Prints the time until the log was measured, and the
+    median and slowest frame while it was. Uses the null backend from
+    bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <waylandgui/fontmetrics.h>
+#include <waylandgui/textarea.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+using clock_type = std::chrono::steady_clock;
+
+static const int log_lines = 20000, page_lines = 60;
+
+static double elapsed_ms(clock_type::time_point start, clock_type::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// Draw a frame at the start of the next 60 Hz interval and return how long it took
+static double draw_frame(NVGcontext *ctx, const Theme *theme, const std::vector<std::string> &page,
+                         clock_type::time_point &vsync) {
+    vsync += std::chrono::microseconds(16667);
+    std::this_thread::sleep_until(vsync);
+    auto start = clock_type::now();
+    nvgBeginFrame(ctx, 1920, 1080, 1.f);
+    nvgFontFaceId(ctx, theme->m_font_sans_regular);
+    nvgFontSize(ctx, 15.f);
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    for (size_t i = 0; i < page.size(); ++i)
+        nvgText(ctx, 0.f, i * 15.f, page[i].c_str(), nullptr);
+    nvgEndFrame(ctx);
+    return elapsed_ms(start, clock_type::now());
+}
+
+static void report(const char *name, double measured, std::vector<double> frames) {
+    std::sort(frames.begin(), frames.end());
+    printf("  %-22s measured in %7.2f ms, %5i frames: median %6.3f ms, slowest %6.2f ms\n",
+           name, measured, (int) frames.size(), frames[frames.size() / 2], frames.back());
+}
+
+static void run(const std::vector<std::string> &chunks, int threads) {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return;
+    }
+
+    /* Scope the theme and metrics so that they are released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        FontMetrics metrics;
+        metrics.attach(ctx);
+
+        std::vector<std::string> page;
+        for (int i = 0; i < page_lines; ++i)
+            page.push_back("Frame text on line " + std::to_string(i) + " of the page that is shown");
+        auto vsync = clock_type::now();
+        draw_frame(ctx, theme.get(), page, vsync);
+
+        std::vector<double> frames;
+        auto start = clock_type::now();
+        double measured = 0;
+
+        if (threads == 0) {
+            /* The frame that appends the log measures it */
+            frames.push_back(draw_frame(ctx, theme.get(), page, vsync));
+            auto frame_start = clock_type::now();
+            for (const std::string &chunk : chunks)
+                TextArea::measure(ctx, chunk, "sans", 15.f);
+            measured = elapsed_ms(frame_start, clock_type::now());
+            frames.back() += measured;
+            for (int i = 0; i < 30; ++i)
+                frames.push_back(draw_frame(ctx, theme.get(), page, vsync));
+        } else {
+            std::atomic<int> remaining { threads };
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    FontMetrics::Context mctx = metrics.acquire(1.f);
+                    for (size_t i = t; i < chunks.size(); i += threads)
+                        TextArea::measure(mctx, chunks[i], "sans", 15.f);
+                    if (--remaining == 0)
+                        measured = elapsed_ms(start, clock_type::now());
+                });
+            }
+            while (remaining > 0 || frames.size() < 30)
+                frames.push_back(draw_frame(ctx, theme.get(), page, vsync));
+            for (std::thread &worker : workers)
+                worker.join();
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), threads == 0 ? "on the drawing thread" : "on %i worker thread%s",
+                 threads, threads > 1 ? "s" : "");
+        report(name, measured, frames);
+    }
+
+    nvgDeleteInternal(ctx);
+}
+
+int main() {
+    /* The log arrives in chunks of 100 lines */
+    std::vector<std::string> chunks;
+    std::string chunk;
+    for (int i = 0; i < log_lines; ++i) {
+        chunk += "[12:" + std::to_string(10 + i / 6000) + ":" + std::to_string(10 + i / 100 % 50) +
+                 "] worker " + std::to_string(i % 7) + ": processed request " + std::to_string(48211 + i) +
+                 " in " + std::to_string(i % 97) + " ms\n";
+        if (i % 100 == 99) {
+            chunks.push_back(chunk);
+            chunk.clear();
+        }
+    }
+
+    printf("%i lines of log measured while drawing %i lines of text per frame:\n", log_lines, page_lines);
+    run(chunks, 0);
+    run(chunks, 1);
+    run(chunks, 2);
+    run(chunks, 4);
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+    src/bench_frame_pacer.cpp -- Frame rates of FramePacer on a simulated
+    clock
+
+    Runs a main loop that always has a redraw pending against a clock that
+    only advances when the loop sleeps on its frame timer or draws a frame
+    (3 ms). Counts the frames started in one simulated second for every
+    pacing mode that does not block in the buffer swap, at refresh rates of
+    60 and 144 Hz and with several frame rate caps, and compares them with
+    the expected rate: at most one frame per refresh, with caps rounded
+    down to the refresh rate divided by an integer. Timed is also run with
+    an unknown refresh rate (0), which it paces to the nominal 60 Hz. Exits
+    with a non-zero status if any rate is off. Needs no display.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/framepacer.h>
+#include <cstdio>
+
+using namespace waylandgui;
+
+static const double draw_time = 0.003;
+
+/// Return the number of frames started in one simulated second
+static int frames_per_second(FramePacer::Mode mode, double refresh_rate, float max_fps) {
+    double clock = 0;
+    FramePacer pacer(mode);
+    pacer.set_clock([&clock]() { return clock; });
+    pacer.set_refresh_rate(refresh_rate);
+    pacer.set_max_fps(max_fps);
+
+    /* Settle for a second first, then count */
+    int frames = 0;
+    while (clock < 2.0) {
+        double delay = pacer.frame_delay();
+        if (delay > 0) {
+            clock += delay;
+            continue;
+        }
+        if (clock >= 1.0)
+            frames++;
+        pacer.frame_started();
+        clock += draw_time;
+        pacer.frame_presented();
+    }
+    return frames;
+}
+
+int main() {
+    struct Case {
+        FramePacer::Mode mode;
+        const char *name;
+        double refresh_rate;
+        float max_fps;
+        int expected;
+    } cases[] = {
+        { FramePacer::Mode::Simulated, "simulated", 60, 0, 60 },
+        { FramePacer::Mode::Simulated, "simulated", 60, 45, 30 },
+        { FramePacer::Mode::Simulated, "simulated", 60, 30, 30 },
+        { FramePacer::Mode::Simulated, "simulated", 60, 20, 20 },
+        { FramePacer::Mode::Simulated, "simulated", 144, 0, 144 },
+        { FramePacer::Mode::Simulated, "simulated", 144, 60, 48 },
+        { FramePacer::Mode::Timed, "timed", 60, 0, 60 },
+        { FramePacer::Mode::Timed, "timed", 60, 45, 30 },
+        { FramePacer::Mode::Timed, "timed", 60, 30, 30 },
+        { FramePacer::Mode::Timed, "timed", 60, 20, 20 },
+        { FramePacer::Mode::Timed, "timed", 144, 0, 144 },
+        { FramePacer::Mode::Timed, "timed", 144, 60, 48 },
+        /* Refresh rate not reported by the display */
+        { FramePacer::Mode::Timed, "timed", 0, 0, 60 },
+        { FramePacer::Mode::Timed, "timed", 0, 45, 30 },
+    };
+
+    int failed = 0;
+    printf("  mode        refresh    cap    fps  expected\n");
+    for (const Case &c : cases) {
+        int fps = frames_per_second(c.mode, c.refresh_rate, c.max_fps);
+        /* A frame may fall on either side of the counted second */
+        bool ok = fps >= c.expected - 1 && fps <= c.expected + 1;
+        failed += ok ? 0 : 1;
+        printf("  %-10s %5.0f Hz  %5.0f  %5i  %5i%s\n", c.name, c.refresh_rate,
+               c.max_fps, fps, c.expected, ok ? "" : "  <- off");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+/*
+    src/bench_glyph_atlas.cpp -- Cost of drawing text at ever changing sizes
+
+    Every frame draws the printable ASCII characters at the sizes of the
+    user interface, which stay the same, and at 4 sizes of a sweep from 10
+    to 80 pixels, e.g. as when zooming. Over the sweep, far more glyphs
+    are drawn than fit into the font atlas, so that older ones must make
+    room. Measures the time per frame with a warm and a churning glyph
+    cache. Uses the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 1000;
+static const float ui_sizes[] = { 14.f, 16.f, 20.f };
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        std::string ascii;
+        for (char c = 0x20; c < 0x7f; ++c)
+            ascii += c;
+
+        auto frame = [&](int i, bool sweep) {
+            nvgBeginFrame(ctx, 1920, 1080, 1.f);
+            nvgFontFaceId(ctx, theme->m_font_sans_regular);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            float y = 0.f;
+            for (float size : ui_sizes) {
+                nvgFontSize(ctx, size);
+                nvgText(ctx, 0.f, y, ascii.c_str(), nullptr);
+                y += size;
+            }
+            for (int j = 0; sweep && j < 4; ++j) {
+                float size = 10.f + (float) ((i * 4 + j) % 141) * .5f;
+                nvgFontSize(ctx, size);
+                nvgText(ctx, 0.f, y, ascii.c_str(), nullptr);
+                y += size;
+            }
+            nvgEndFrame(ctx);
+        };
+
+        auto time_per_frame = [&](bool sweep) {
+            for (int i = 0; i < 10; ++i)
+                frame(i, sweep);
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i)
+                frame(i, sweep);
+            auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+        };
+
+        double warm = time_per_frame(false);
+        double sweep = time_per_frame(true);
+
+        printf("%i frames of text at %i fixed sizes:\n", frames, (int) (sizeof(ui_sizes) / sizeof(float)));
+        printf("  fixed sizes only          %10.1f us per frame\n", warm);
+        printf("  with 4 sizes of a sweep   %10.1f us per frame\n", sweep);
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+    src/bench_glyph_misses.cpp -- Frame times while new glyphs are rasterized
+
+    Draws a page of Greek and Cyrillic text at 3 sizes, none of which the
+    font atlas holds yet, at 60 frames per second. First, every glyph is
+    rasterized by the frame that draws it; then, the glyphs are rasterized
+    on the background worker pool by a GlyphRasterizer, while the frames
+    leave them out. Prints the time of the slowest frame, the number of
+    frames until all glyphs were shown, and the glyphs that stalled a
+    frame. Uses the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <waylandgui/glyphrasterizer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 30;
+static const float sizes[] = { 17.f, 23.f, 31.f };
+
+static void run(bool background) {
+    using clock = std::chrono::steady_clock;
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return;
+    }
+
+    /* Scope the theme and rasterizer so that they are released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        GlyphRasterizer rasterizer;
+        if (background && !rasterizer.attach(ctx)) {
+            fprintf(stderr, "Background glyphs are not supported!\n");
+            return;
+        }
+
+        std::vector<std::string> lines;
+        for (uint32_t c = 0x391; c < 0x4ff; c += 48) {
+            std::string line;
+            for (uint32_t d = c; d < std::min(c + 48, 0x4ffu); ++d)
+                line += utf8(d);
+            lines.push_back(line);
+        }
+
+        double worst = 0;
+        int complete = -1, placeholders = 0;
+        for (int i = 0; i < frames; ++i) {
+            auto start = clock::now();
+            rasterizer.finish(true);
+            nvgBeginFrame(ctx, 1920, 1080, 1.f);
+            nvgFontFaceId(ctx, theme->m_font_sans_regular);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            float y = 0.f;
+            for (float size : sizes) {
+                nvgFontSize(ctx, size);
+                for (const std::string &line : lines) {
+                    nvgText(ctx, 0.f, y, line.c_str(), nullptr);
+                    y += size;
+                }
+            }
+            nvgEndFrame(ctx);
+            rasterizer.submit();
+            auto end = clock::now();
+
+            worst = std::max(worst, std::chrono::duration<double, std::milli>(end - start).count());
+            if (complete < 0 && nvgGlyphPlaceholders(ctx) == placeholders)
+                complete = i;
+            placeholders = nvgGlyphPlaceholders(ctx);
+            std::this_thread::sleep_until(start + std::chrono::microseconds(16667));
+        }
+
+        printf("  %-22s slowest frame %7.2f ms, complete in frame %i, %5i stalls\n",
+               background ? "background glyphs" : "rasterized when drawn",
+               worst, complete, nvgGlyphStalls(ctx));
+    }
+
+    nvgDeleteInternal(ctx);
+}
+
+int main() {
+    printf("%i frames of Greek and Cyrillic text at %i sizes that are not cached:\n",
+           frames, (int) (sizeof(sizes) / sizeof(float)));
+    run(false);
+    run(true);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+    src/bench_hit_test.cpp -- Hit-testing cost for panels with many children
+
+    Fills a panel with 100 to 100,000 small indicator widgets arranged in a
+    grid and measures the time per Widget::find_widget() and per
+    Widget::mouse_motion_event() at random positions, with and without a
+    spatial index on the panel (see Widget::set_spatial_index()), as well as
+    the time to rebuild the index after a layout change.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/widget.h>
+#include <waylandgui/spatialindex.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace waylandgui;
+
+static const int cell = 14, indicator = 12;
+
+/// Random positions within the panel (deterministic)
+static std::vector<Vector2i> positions(const Vector2i &size, int count) {
+    std::vector<Vector2i> result(count);
+    uint32_t state = 12345;
+    auto next = [&]() { state = state * 1664525u + 1013904223u; return state >> 8; };
+    for (Vector2i &p : result)
+        p = Vector2i((int) (next() % (uint32_t) size.x()),
+                     (int) (next() % (uint32_t) size.y()));
+    return result;
+}
+
+/// Average time per call in nanoseconds
+template <typename Func>
+static double time_per_call(const std::vector<Vector2i> &points, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    for (const Vector2i &p : points)
+        func(p);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / points.size();
+}
+
+int main() {
+    printf("Hit-testing a panel of small indicators (time per call):\n");
+    printf("  %8s | %12s %12s | %12s %12s | %12s\n", "children", "find linear",
+           "find index", "motion linear", "motion index", "index build");
+
+    volatile size_t sink = 0;
+    for (int children : { 100, 1000, 10000, 100000 }) {
+        int columns = (int) std::ceil(std::sqrt((double) children));
+        ref<Widget> panel = new Widget(nullptr);
+        panel->set_size(Vector2i(columns * cell, (children + columns - 1) / columns * cell));
+        for (int i = 0; i < children; ++i) {
+            Widget *w = new Widget(panel);
+            w->set_position(Vector2i(i % columns, i / columns) * cell);
+            w->set_size(Vector2i(indicator));
+        }
+
+        /* Fewer samples for the slow cases */
+        int samples = std::max(2000, std::min(200000, 200000000 / children));
+        std::vector<Vector2i> points = positions(panel->size(), samples);
+
+        auto find = [&](const Vector2i &p) { sink += (size_t) panel->find_widget(p); };
+        Vector2i prev(0);
+        auto motion = [&](const Vector2i &p) {
+            /* Short moves, as during a real pointer motion */
+            Vector2i q = prev + (p - prev) / 64;
+            sink += panel->mouse_motion_event(q, q - prev, 0, 0);
+            prev = q;
+        };
+
+        double find_linear = time_per_call(points, find);
+        double motion_linear = time_per_call(points, motion);
+
+        panel->set_spatial_index(true);
+        find(Vector2i(0)); // build the index outside of the timed loop
+        double find_index = time_per_call(points, find);
+        double motion_index = time_per_call(points, motion);
+
+        int rebuilds = std::max(5, 2000000 / children);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rebuilds; ++i) {
+            panel->invalidate_spatial_index();
+            find(Vector2i(0));
+        }
+        auto end = std::chrono::steady_clock::now();
+        double build = std::chrono::duration<double, std::micro>(end - start).count() / rebuilds;
+
+        printf("  %8i | %9.1f ns %9.1f ns | %10.1f ns %9.1f ns | %9.1f us\n", children,
+               find_linear, find_index, motion_linear, motion_index, build);
+    }
+
+    return 0;
+}
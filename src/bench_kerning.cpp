@@ -0,0 +1,110 @@
+/*
+    src/bench_kerning.cpp -- Cost of measuring a long paragraph of text
+
+    Usage: bench_kerning [font.ttf]
+
+    Measures a paragraph of about 2000 characters with nvgTextBounds(),
+    breaks it into rows with nvgTextBreakLines() and computes its glyph
+    positions, all of which look up the kerning of every pair of glyphs.
+    The bundled fonts only kern via GPOS, which fontstash ignores, so pass
+    a font with a 'kern' table to measure the kerning lookups themselves.
+    Prints the measured advance along with the timings, so that runs of
+    different builds can be checked to agree. Uses the null backend from
+    bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int iterations = 500;
+
+static const char *sentences[] = {
+    "AVATAR Tyrone Yoyo, WAVE To Vera: \"Your LT. VALVE AWAY TAY'S Pyre.\" ",
+    "The quick brown fox jumps over the lazy dog, then takes a well-earned nap. ",
+    "Kerning adjusts the space between pairs like AV, To, Ty, Wa, Ye and LT. ",
+    "Typography for user interfaces favors legibility over ornament, always. "
+};
+
+/// Average time per call in microseconds
+template <typename Func> static double time_per_call(int count, Func func) {
+    func();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / count;
+}
+
+int main(int argc, char **argv) {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        int font = argc > 1 ? nvgCreateFont(ctx, "bench", argv[1]) : theme->m_font_sans_regular;
+        if (font == -1) {
+            fprintf(stderr, "Could not load font \"%s\"!\n", argv[1]);
+            return 1;
+        }
+
+        std::string paragraph;
+        for (int i = 0; paragraph.size() < 2000; ++i)
+            paragraph += sentences[i % 4];
+        const char *begin = paragraph.c_str(), *end = begin + paragraph.size();
+
+        nvgFontFaceId(ctx, font);
+        nvgFontSize(ctx, 16.f);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+
+        float bounds[4], advance = 0.f;
+        double measure = time_per_call(iterations, [&]() {
+            advance = nvgTextBounds(ctx, 0, 0, begin, end, bounds);
+        });
+
+        int nrows = 0;
+        double breaks = time_per_call(iterations, [&]() {
+            NVGtextRow rows[16];
+            const char *start = begin;
+            int n;
+            nrows = 0;
+            while ((n = nvgTextBreakLines(ctx, start, end, 300.f, rows, 16)) > 0) {
+                nrows += n;
+                start = rows[n - 1].next;
+            }
+        });
+
+        std::vector<NVGglyphPosition> positions(paragraph.size());
+        int count = 0;
+        double glyphs = time_per_call(iterations, [&]() {
+            count = nvgTextGlyphPositions(ctx, 0, 0, begin, end, positions.data(),
+                                          (int) positions.size());
+        });
+
+        printf("Paragraph of %i characters in %s, advance %.1f, %i rows at 300 px:\n",
+               (int) paragraph.size(), argc > 1 ? argv[1] : "the bundled sans font",
+               advance, nrows);
+        printf("  nvgTextBounds()           %10.1f us\n", measure);
+        printf("  nvgTextBreakLines()       %10.1f us\n", breaks);
+        printf("  nvgTextGlyphPositions()   %10.1f us (last glyph at %.1f)\n", glyphs,
+               count > 0 ? positions[count - 1].x : 0.f);
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
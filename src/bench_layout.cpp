@@ -0,0 +1,147 @@
+/*
+    src/bench_layout.cpp -- Cost of laying out a large FormHelper window
+    after a single caption change
+
+    Builds a FormHelper window with 6 groups of 18 variables each, plus a
+    chain of 12 nested panels with a BoxLayout per level, and measures the
+    time to lay it out again after changing the caption of one Label: once
+    from scratch via Screen::perform_layout(), as applications had to before,
+    and once incrementally, as the screen does before the next frame when
+    the Label invalidates its layout. Uses the null backend from
+    bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/formhelper.h>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int groups = 6, variables = 18, depth = 12;
+
+/// Screen without a window, which lays out widgets with the given context
+class BenchScreen : public Screen {
+public:
+    BenchScreen(NVGcontext *ctx) {
+        m_nvg_context = ctx;
+        m_size = Vector2i(1920, 1080);
+        set_theme(new Theme(ctx));
+    }
+
+    ~BenchScreen() {
+        /* Owned by main() */
+        m_nvg_context = nullptr;
+    }
+
+    using Screen::update_pending_layout;
+};
+
+/// Average time per call in microseconds
+template <typename Func> static double time_per_call(int count, Func func) {
+    func();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / count;
+}
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the widgets so that they are released before the context */ {
+        ref<BenchScreen> screen = new BenchScreen(ctx);
+        std::deque<std::string> strings;
+        std::deque<int> ints;
+        std::deque<double> doubles;
+        std::deque<char> bools;
+
+        FormHelper *gui = new FormHelper(screen);
+        gui->add_window(Vector2i(10, 10), "Settings");
+        for (int g = 0; g < groups; ++g) {
+            gui->add_group("Group " + std::to_string(g));
+            for (int v = 0; v < variables; ++v) {
+                std::string name = "Variable " + std::to_string(g) + "." + std::to_string(v);
+                switch (v % 4) {
+                    case 0: {
+                        std::string &value = (strings.push_back("text"), strings.back());
+                        gui->add_variable(name, value);
+                    } break;
+                    case 1: {
+                        int &value = (ints.push_back(v), ints.back());
+                        gui->add_variable(name, value);
+                    } break;
+                    case 2: {
+                        double &value = (doubles.push_back(v * .5), doubles.back());
+                        gui->add_variable(name, value);
+                    } break;
+                    default: {
+                        char &value = (bools.push_back(0), bools.back());
+                        gui->add_variable<bool>(name,
+                            [&value](const bool &b) { value = b; },
+                            [&value]() -> bool { return value; });
+                    } break;
+                }
+            }
+        }
+        /* The label of the last variable added */
+        Label *form_label = dynamic_cast<Label *>(gui->window()->child_at(
+            gui->window()->child_count() - 2));
+
+        Widget *panel = new Widget(gui->window());
+        Label *nested_label = nullptr;
+        Widget *level = panel;
+        for (int i = 0; i < depth; ++i) {
+            level->set_layout(new BoxLayout(Orientation::Vertical, Alignment::Fill, 2, 2));
+            nested_label = new Label(level, "Level caption");
+            new CheckBox(level, "Option");
+            level = new Widget(level);
+        }
+        gui->add_widget("Nested", panel);
+
+        screen->perform_layout();
+
+        bool toggle = false;
+        auto change = [&](Label *label) {
+            toggle = !toggle;
+            label->set_caption(toggle ? "A considerably longer caption" : "Short");
+        };
+
+        double full = time_per_call(50, [&]() {
+            change(form_label);
+            screen->perform_layout();
+        });
+        double form = time_per_call(1000, [&]() {
+            change(form_label);
+            screen->update_pending_layout();
+        });
+        double nested = time_per_call(1000, [&]() {
+            change(nested_label);
+            screen->update_pending_layout();
+        });
+
+        printf("FormHelper window with %i widgets, relayout after one Label change:\n",
+               (int) (strings.size() + ints.size() + doubles.size() + bools.size()) * 2 +
+                   groups + 3 * depth);
+        printf("  Screen::perform_layout() (from scratch)  %10.1f us\n", full);
+        printf("  incremental, label in the form           %10.1f us\n", form);
+        printf("  incremental, label %2i levels deep        %10.1f us\n", depth, nested);
+        delete gui;
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+    src/bench_null_context.h -- NanoVG context without a GPU for benchmarks
+
+    The GL backend is replaced by one that only copies the submitted
+    vertices, which is what the real backend does on the CPU side before
+    issuing draw calls. Benchmarks using it therefore measure the CPU cost
+    of drawing and run without a display. With hash_submissions set, it
+    also hashes every paint, scissor and vertex it is given, so that two
+    ways of drawing can be checked to give identical pixels.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanovg.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static std::vector<NVGvertex> vertex_sink;
+
+/// Hash everything submitted into submission_hash? (off: benchmarks only pay for the copy)
+static bool hash_submissions = false;
+static uint64_t submission_hash = 14695981039346656037ull;
+
+/// FNV-1a, over the exact bytes, since identical pixels need identical floats
+static void hash_bytes(const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *) data;
+    for (size_t i = 0; i < size; ++i)
+        submission_hash = (submission_hash ^ p[i]) * 1099511628211ull;
+}
+
+static void hash_state(const NVGpaint *paint, NVGcompositeOperationState op, const NVGscissor *scissor) {
+    hash_bytes(paint, sizeof(NVGpaint));
+    hash_bytes(&op, sizeof(op));
+    hash_bytes(scissor, sizeof(NVGscissor));
+}
+
+static int null_create(void *) { return 1; }
+static int null_create_texture(void *, int, int, int, int, const unsigned char *) {
+    static int counter = 0;
+    return ++counter;
+}
+static int null_delete_texture(void *, int) { return 1; }
+static int null_update_texture(void *, int, int, int, int, int, const unsigned char *) { return 1; }
+static int null_texture_size(void *, int, int *w, int *h) { *w = *h = 512; return 1; }
+static void null_viewport(void *, float, float, float) { }
+static void null_cancel(void *) { }
+static void null_flush(void *) { vertex_sink.clear(); }
+static void null_delete(void *) { }
+
+static void copy_paths(const NVGpath *paths, int npaths) {
+    for (int i = 0; i < npaths; ++i) {
+        vertex_sink.insert(vertex_sink.end(), paths[i].fill, paths[i].fill + paths[i].nfill);
+        vertex_sink.insert(vertex_sink.end(), paths[i].stroke, paths[i].stroke + paths[i].nstroke);
+        if (hash_submissions) {
+            hash_bytes(paths[i].fill, sizeof(NVGvertex) * paths[i].nfill);
+            hash_bytes(paths[i].stroke, sizeof(NVGvertex) * paths[i].nstroke);
+        }
+    }
+}
+
+static void null_fill(void *, NVGpaint *paint, NVGcompositeOperationState op, NVGscissor *scissor,
+                      float fringe, const float *bounds, const NVGpath *paths, int npaths) {
+    if (hash_submissions) {
+        hash_state(paint, op, scissor);
+        hash_bytes(&fringe, sizeof(float));
+        hash_bytes(bounds, 4 * sizeof(float));
+    }
+    copy_paths(paths, npaths);
+}
+
+static void null_stroke(void *, NVGpaint *paint, NVGcompositeOperationState op, NVGscissor *scissor,
+                        float fringe, float stroke_width, const NVGpath *paths, int npaths) {
+    if (hash_submissions) {
+        hash_state(paint, op, scissor);
+        hash_bytes(&fringe, sizeof(float));
+        hash_bytes(&stroke_width, sizeof(float));
+    }
+    copy_paths(paths, npaths);
+}
+
+static void null_triangles(void *, NVGpaint *paint, NVGcompositeOperationState op, NVGscissor *scissor,
+                           const NVGvertex *verts, int nverts) {
+    if (hash_submissions) {
+        hash_state(paint, op, scissor);
+        hash_bytes(verts, sizeof(NVGvertex) * nverts);
+    }
+    vertex_sink.insert(vertex_sink.end(), verts, verts + nverts);
+}
+
+/// Create a NanoVG context whose backend draws nothing (release with nvgDeleteInternal())
+static NVGcontext *create_null_context() {
+    NVGparams params;
+    memset(&params, 0, sizeof(params));
+    params.renderCreate = null_create;
+    params.renderCreateTexture = null_create_texture;
+    params.renderDeleteTexture = null_delete_texture;
+    params.renderUpdateTexture = null_update_texture;
+    params.renderGetTextureSize = null_texture_size;
+    params.renderViewport = null_viewport;
+    params.renderCancel = null_cancel;
+    params.renderFlush = null_flush;
+    params.renderFill = null_fill;
+    params.renderStroke = null_stroke;
+    params.renderTriangles = null_triangles;
+    params.renderDelete = null_delete;
+    params.edgeAntiAlias = 1;
+    return nvgCreateInternal(&params);
+}
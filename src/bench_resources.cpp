@@ -0,0 +1,93 @@
+/*
+    src/bench_resources.cpp -- Startup time and resident memory of the
+    bundled fonts
+
+    Creates a NanoVG context and the default theme, which loads the fonts
+    and the baked glyph atlas, either from the library or from the mapped
+    waylandgui.pack (WAYLANDGUI_RESOURCE_PACK), then draws a first frame of
+    text at the sizes of the theme, along with a few icons. Prints the time
+    of both steps and the resident memory afterwards, in total and backed
+    by files, which holds the pages of the library and of the pack that
+    were touched. Run it once to warm the page cache before comparing.
+    Uses the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <waylandgui/icons.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+/// Value of a field of /proc/self/status in kB
+static long status_kb(const char *field) {
+    long value = -1;
+    char line[256];
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f)
+        return value;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, field, strlen(field)) == 0 && line[strlen(field)] == ':') {
+            value = atol(line + strlen(field) + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        auto t1 = clock::now();
+
+        std::string text, icons;
+        for (char c = 0x20; c < 0x7f; ++c)
+            text += c;
+        for (int icon : { FA_CHECK, FA_TIMES, FA_CHEVRON_LEFT, FA_CHEVRON_RIGHT, FA_SEARCH, FA_COG })
+            icons += utf8(icon);
+
+        nvgBeginFrame(ctx, 1280, 800, 1.f);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+        float y = 0.f;
+        for (int font : { theme->m_font_sans_regular, theme->m_font_sans_bold, theme->m_font_mono_regular }) {
+            nvgFontFaceId(ctx, font);
+            for (float size : { 15.f, 16.f, 20.f }) {
+                nvgFontSize(ctx, size);
+                nvgText(ctx, 0.f, y, text.c_str(), nullptr);
+                y += size;
+            }
+        }
+        nvgFontFaceId(ctx, theme->m_font_icons);
+        nvgText(ctx, 0.f, y, icons.c_str(), nullptr);
+        nvgEndFrame(ctx);
+        auto t2 = clock::now();
+
+        printf("Default theme and a first frame of text:\n");
+        printf("  theme creation  %10.1f us\n", std::chrono::duration<double, std::micro>(t1 - t0).count());
+        printf("  first frame     %10.1f us\n", std::chrono::duration<double, std::micro>(t2 - t1).count());
+        printf("  resident        %10ld kB (%ld kB backed by files)\n",
+               status_kb("VmRSS"), status_kb("RssFile"));
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
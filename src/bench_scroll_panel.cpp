@@ -0,0 +1,119 @@
+/*
+    src/bench_scroll_panel.cpp -- Draw cost of a long list in a VScrollPanel
+
+    Fills a VScrollPanel with 1,000 or 10,000 rows, scrolls it halfway and
+    measures the CPU time per frame for viewports showing 10, 40 and 160
+    rows, using the null backend from bench_null_context.h. Rows outside of
+    the viewport are culled by Widget::draw(), so the cost should grow with
+    the number of visible rows rather than with the length of the list.
+
+    VScrollPanel queries the preferred size of its content in every frame,
+    which accounts for most of the remaining cost that grows with the list
+    length. The rows have a constant preferred size, so that this query does
+    not measure text on top of that.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/vscrollpanel.h>
+#include <waylandgui/layout.h>
+#include <waylandgui/theme.h>
+#include <waylandgui/opengl.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 500;
+static const int row_height = 24;
+
+/// List entry with a background and a caption
+class Row : public Widget {
+public:
+    Row(Widget *parent, int index)
+        : Widget(parent), m_index(index),
+          m_caption("Row " + std::to_string(index)) { }
+
+    Vector2i preferred_size(NVGcontext *) const override {
+        return Vector2i(280, row_height);
+    }
+
+    void draw(NVGcontext *ctx) override {
+        nvgBeginPath(ctx);
+        nvgRect(ctx, m_pos.x(), m_pos.y(), m_size.x(), m_size.y());
+        nvgFillColor(ctx, m_index % 2 ? Color(255, 16) : Color(0, 16));
+        nvgFill(ctx);
+
+        nvgFontFace(ctx, "sans");
+        nvgFontSize(ctx, font_size());
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
+        nvgFillColor(ctx, m_theme->m_text_color);
+        nvgText(ctx, m_pos.x() + 5, m_pos.y() + m_size.y() * 0.5f,
+                m_caption.c_str(), nullptr);
+    }
+
+private:
+    int m_index;
+    std::string m_caption;
+};
+
+/// Average CPU time per frame in microseconds
+static double run(NVGcontext *ctx, int rows, int visible_rows) {
+    ref<Widget> root = new Widget(nullptr);
+    root->set_theme(new Theme(ctx));
+    root->set_size(Vector2i(1024, 4096));
+
+    VScrollPanel *panel = new VScrollPanel(root);
+    panel->set_fixed_size(Vector2i(300, visible_rows * row_height));
+    Widget *list = new Widget(panel);
+    list->set_layout(new BoxLayout(Orientation::Vertical, Alignment::Fill));
+    for (int i = 0; i < rows; ++i)
+        new Row(list, i);
+
+    root->perform_layout(ctx);
+    panel->set_scroll(.5f);
+
+    auto frame = [&]() {
+        nvgBeginFrame(ctx, 1024, 4096, 1.f);
+        root->draw(ctx);
+        nvgEndFrame(ctx);
+    };
+
+    /* Warm up the glyph cache */
+    for (int i = 0; i < 10; ++i)
+        frame();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        frame();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    printf("VScrollPanel, %i frames (CPU time per frame):\n", frames);
+    printf("  %8s %8s %12s %16s\n", "rows", "visible", "time", "per visible row");
+    for (int rows : { 1000, 10000 }) {
+        for (int visible : { 10, 40, 160 }) {
+            double t = run(ctx, rows, visible);
+            printf("  %8i %8i %9.1f us %13.2f us\n", rows, visible, t, t / visible);
+        }
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
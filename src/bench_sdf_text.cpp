@@ -0,0 +1,106 @@
+/*
+    src/bench_sdf_text.cpp -- Font atlas usage of text with animated sizes
+
+    Draws an alarm message whose font size pulses between 12 and 96 pixels,
+    along with the printable ASCII characters at the 3 fixed sizes of the
+    user interface, first with glyphs rasterized at each size and then with
+    the alarm drawn from signed distance fields (nvgFontSDF()). Counts the
+    font atlas pages created, the pixels uploaded to them, which grow with
+    the glyphs rasterized, and the time per frame. Uses the null backend
+    from bench_null_context.h, whose texture callbacks are wrapped to count.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 600;
+static const float ui_sizes[] = { 14.f, 16.f, 20.f };
+
+static int textures = 0, peak_textures = 0;
+static long long uploaded = 0;
+
+static int count_create_texture(void *uptr, int type, int w, int h, int flags,
+                                const unsigned char *data) {
+    peak_textures = std::max(peak_textures, ++textures);
+    return null_create_texture(uptr, type, w, h, flags, data);
+}
+
+static int count_delete_texture(void *uptr, int image) {
+    --textures;
+    return null_delete_texture(uptr, image);
+}
+
+static int count_update_texture(void *uptr, int image, int x, int y, int w, int h,
+                                const unsigned char *data) {
+    uploaded += (long long) w * h;
+    return null_update_texture(uptr, image, x, y, w, h, data);
+}
+
+static void run(bool sdf) {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return;
+    }
+    NVGparams *params = nvgInternalParams(ctx);
+    params->renderCreateTexture = count_create_texture;
+    params->renderDeleteTexture = count_delete_texture;
+    params->renderUpdateTexture = count_update_texture;
+    textures = peak_textures = 1;
+    uploaded = 0;
+
+    /* Scope the theme so that it is released before the context */ {
+        ref<Theme> theme = new Theme(ctx);
+        std::string ascii;
+        for (char c = 0x20; c < 0x7f; ++c)
+            ascii += c;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            nvgBeginFrame(ctx, 1920, 1080, 1.f);
+            nvgFontFaceId(ctx, theme->m_font_sans_regular);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            float y = 0.f;
+            for (float size : ui_sizes) {
+                nvgFontSize(ctx, size);
+                nvgText(ctx, 0.f, y, ascii.c_str(), nullptr);
+                y += size;
+            }
+
+            nvgFontFaceId(ctx, theme->m_font_sans_bold);
+            nvgFontSize(ctx, 54.f - 42.f * std::cos(i * 0.05f));
+            nvgFontSDF(ctx, sdf);
+            nvgText(ctx, 0.f, y, "ALARM: Tank 3 pressure 12.5 bar (limit 10.0)", nullptr);
+            nvgFontSDF(ctx, 0);
+            nvgEndFrame(ctx);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        printf("  %-20s %4i pages (%i at most), %7.2f Mpx uploaded, %7.1f us per frame\n",
+               sdf ? "distance fields" : "rasterized glyphs", textures, peak_textures,
+               uploaded / 1e6, std::chrono::duration<double, std::micro>(end - start).count() / frames);
+    }
+
+    nvgDeleteInternal(ctx);
+}
+
+int main() {
+    printf("%i frames of UI text and an alarm pulsing between 12 and 96 px:\n", frames);
+    run(false);
+    run(true);
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+    src/bench_shader_uniforms.cpp -- Cost of updating shader uniforms by
+    name and by handle, and the uniforms that Shader::begin() uploads
+
+    Replaces the OpenGL ES functions that Shader calls with stubs, which
+    reflect a program with a vec2 attribute, a mat4 and a vec4 uniform and
+    count the glUniform* calls. Times set_uniform() of the matrix by name
+    and through a Shader::Handle, then draws 100 frames in which the
+    uniforms keep their values and 100 in which the matrix changes. Exits
+    with a non-zero status unless the first frame uploads both uniforms,
+    frames with unchanged values upload none, and the others upload only
+    the matrix. Needs no display.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/shader.h>
+#include <waylandgui/opengl.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+using namespace waylandgui;
+using clock_type = std::chrono::steady_clock;
+
+static int uniform_uploads = 0;
+
+/* Stubs taking the place of the functions of the OpenGL ES library */
+extern "C" {
+GLenum glGetError() { return GL_NO_ERROR; }
+void glActiveTexture(GLenum) { }
+void glAttachShader(GLuint, GLuint) { }
+void glBindBuffer(GLenum, GLuint) { }
+void glBindTexture(GLenum, GLuint) { }
+void glBlendFunc(GLenum, GLenum) { }
+void glBufferData(GLenum, GLsizeiptr, const void *, GLenum) { }
+void glCompileShader(GLuint) { }
+GLuint glCreateProgram() { return 1; }
+GLuint glCreateShader(GLenum) { return 1; }
+void glDeleteProgram(GLuint) { }
+void glDeleteShader(GLuint) { }
+void glDisable(GLenum) { }
+void glDisableVertexAttribArray(GLuint) { }
+void glDrawArrays(GLenum, GLint, GLsizei) { }
+void glDrawElements(GLenum, GLsizei, GLenum, const void *) { }
+void glEnable(GLenum) { }
+void glEnableVertexAttribArray(GLuint) { }
+void glGenBuffers(GLsizei, GLuint *buffers) { buffers[0] = 1; }
+void glGetActiveAttrib(GLuint, GLuint, GLsizei, GLsizei *, GLint *size, GLenum *type, GLchar *name) {
+    *size = 1;
+    *type = GL_FLOAT_VEC2;
+    strcpy(name, "position");
+}
+void glGetActiveUniform(GLuint, GLuint index, GLsizei, GLsizei *, GLint *size, GLenum *type, GLchar *name) {
+    *size = 1;
+    *type = index == 0 ? GL_FLOAT_MAT4 : GL_FLOAT_VEC4;
+    strcpy(name, index == 0 ? "mvp" : "color");
+}
+GLint glGetAttribLocation(GLuint, const GLchar *) { return 0; }
+void glGetProgramInfoLog(GLuint, GLsizei, GLsizei *, GLchar *log) { log[0] = '\0'; }
+void glGetProgramiv(GLuint, GLenum name, GLint *value) {
+    *value = name == GL_ACTIVE_ATTRIBUTES ? 1 : name == GL_ACTIVE_UNIFORMS ? 2 : GL_TRUE;
+}
+void glGetShaderInfoLog(GLuint, GLsizei, GLsizei *, GLchar *log) { log[0] = '\0'; }
+void glGetShaderiv(GLuint, GLenum, GLint *value) { *value = GL_TRUE; }
+GLint glGetUniformLocation(GLuint, const GLchar *name) { return strcmp(name, "mvp") == 0 ? 0 : 1; }
+void glLinkProgram(GLuint) { }
+void glShaderSource(GLuint, GLsizei, const GLchar *const *, const GLint *) { }
+void glUniform1f(GLint, GLfloat) { uniform_uploads++; }
+void glUniform1i(GLint, GLint) { uniform_uploads++; }
+void glUniform2f(GLint, GLfloat, GLfloat) { uniform_uploads++; }
+void glUniform2i(GLint, GLint, GLint) { uniform_uploads++; }
+void glUniform3f(GLint, GLfloat, GLfloat, GLfloat) { uniform_uploads++; }
+void glUniform3i(GLint, GLint, GLint, GLint) { uniform_uploads++; }
+void glUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { uniform_uploads++; }
+void glUniform4i(GLint, GLint, GLint, GLint, GLint) { uniform_uploads++; }
+void glUniformMatrix2fv(GLint, GLsizei, GLboolean, const GLfloat *) { uniform_uploads++; }
+void glUniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat *) { uniform_uploads++; }
+void glUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat *) { uniform_uploads++; }
+void glUseProgram(GLuint) { }
+void glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void *) { }
+}
+
+/// Draw a frame and return the number of uniforms it uploaded
+static int draw_frame(Shader *shader) {
+    int before = uniform_uploads;
+    shader->begin();
+    shader->draw_array(Shader::PrimitiveType::Triangle, 0, 3, false);
+    shader->end();
+    return uniform_uploads - before;
+}
+
+static bool check(const char *name, int uploads, int expected) {
+    printf("  %-36s %4i glUniform* calls (expected %i)\n", name, uploads, expected);
+    return uploads == expected;
+}
+
+int main() {
+    const int updates = 1000000, frames = 100;
+    ref<Shader> shader = new Shader(nullptr, "bench", "vertex", "fragment");
+
+    const float positions[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f };
+    shader->set_buffer("position", VariableType::Float32, { 3, 2 }, positions);
+    Shader::Handle mvp = shader->handle("mvp"), color = shader->handle("color");
+    Matrix4f matrix = Matrix4f::scale(Vector3f(2.f));
+
+    auto start = clock_type::now();
+    for (int i = 0; i < updates; ++i)
+        shader->set_uniform("mvp", matrix);
+    auto by_name = clock_type::now();
+    for (int i = 0; i < updates; ++i)
+        shader->set_uniform(mvp, matrix);
+    auto by_handle = clock_type::now();
+
+    printf("set_uniform() of a mat4 that keeps its value:\n");
+    printf("  by name   %6.1f ns\n", std::chrono::duration<double, std::nano>(by_name - start).count() / updates);
+    printf("  by handle %6.1f ns\n", std::chrono::duration<double, std::nano>(by_handle - by_name).count() / updates);
+
+    printf("Uniforms uploaded by Shader::begin():\n");
+    bool ok = true;
+    shader->set_uniform(color, Color(1.f, 0.f, 0.f, 1.f));
+    ok &= check("first frame", draw_frame(shader.get()), 2);
+
+    int uploads = 0;
+    for (int i = 0; i < frames; ++i) {
+        shader->set_uniform(mvp, matrix);
+        shader->set_uniform(color, Color(1.f, 0.f, 0.f, 1.f));
+        uploads += draw_frame(shader.get());
+    }
+    ok &= check("100 frames, values unchanged", uploads, 0);
+
+    uploads = 0;
+    for (int i = 0; i < frames; ++i) {
+        matrix.m[3][0] = (float) (i + 1);
+        shader->set_uniform(mvp, matrix);
+        shader->set_uniform(color, Color(1.f, 0.f, 0.f, 1.f));
+        uploads += draw_frame(shader.get());
+    }
+    ok &= check("100 frames, matrix changes", uploads, frames);
+
+    return ok ? 0 : 1;
+}
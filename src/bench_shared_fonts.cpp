@@ -0,0 +1,120 @@
+/*
+    src/bench_shared_fonts.cpp -- Resident memory of screens with and
+    without shared fonts
+
+    Creates 1 and 4 NanoVG contexts, as for as many screens, each of which
+    draws the printable ASCII and Greek characters at the 3 sizes of the
+    user interface. Either every context has a theme and font atlas of its
+    own, or they share those of the first one (nvgShareFonts(), as with a
+    ResourceGroup). Each configuration runs in a child process of its own,
+    which prints the growth of its resident memory. The atlas textures,
+    which every context still uploads on its own, are not included. Uses
+    the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/theme.h>
+#include <cstdio>
+#include <malloc.h>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int frames = 60;
+static const float ui_sizes[] = { 14.f, 16.f, 20.f };
+
+/// Resident memory of this process in bytes
+static long long resident() {
+    long long size = 0, pages = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%lld %lld", &size, &pages) != 2)
+            pages = 0;
+        fclose(f);
+    }
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+static void run(int count, bool shared) {
+    long long before = resident();
+    std::vector<NVGcontext *> contexts;
+    std::vector<ref<Theme>> themes;
+
+    for (int i = 0; i < count; ++i) {
+        NVGcontext *ctx = create_null_context();
+        if (!ctx) {
+            fprintf(stderr, "Could not create NanoVG context!\n");
+            exit(1);
+        }
+        if (shared && i > 0)
+            nvgShareFonts(ctx, contexts.front());
+        else
+            themes.push_back(new Theme(ctx));
+        contexts.push_back(ctx);
+    }
+
+    std::string text;
+    for (uint32_t c = 0x20; c < 0x7f; ++c)
+        text += utf8(c);
+    for (uint32_t c = 0x391; c < 0x3ca; ++c)
+        text += utf8(c);
+
+    for (int i = 0; i < frames; ++i) {
+        for (int j = 0; j < count; ++j) {
+            NVGcontext *ctx = contexts[j];
+            nvgBeginFrame(ctx, 1920, 1080, 1.f);
+            nvgFontFaceId(ctx, themes[shared ? 0 : j]->m_font_sans_regular);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            float y = 0.f;
+            for (float size : ui_sizes) {
+                nvgFontSize(ctx, size);
+                nvgText(ctx, 0.f, y, text.c_str(), nullptr);
+                y += size;
+            }
+            nvgEndFrame(ctx);
+        }
+    }
+
+    printf("  %i %-7s %-12s %7.2f MB resident\n",
+           count, count == 1 ? "screen" : "screens", shared ? "shared fonts" : "own fonts",
+           (resident() - before) / (1024.0 * 1024.0));
+
+    themes.clear();
+    for (NVGcontext *ctx : contexts)
+        nvgDeleteInternal(ctx);
+}
+
+int main() {
+    /* Freeing the atlas that nvgShareFonts() drops would otherwise raise the
+       threshold of glibc, so that later atlas pages come from the heap and
+       are resident right away */
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+
+    printf("Growth of resident memory after %i frames of text:\n", frames);
+    const struct { int count; bool shared; } configs[] = {
+        { 1, false }, { 4, false }, { 4, true }
+    };
+    for (const auto &config : configs) {
+        /* A fresh process, so that no configuration reuses the heap of another */
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            run(config.count, config.shared);
+            fflush(stdout);
+            _exit(0);
+        }
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+    }
+    return 0;
+}
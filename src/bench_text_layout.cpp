@@ -0,0 +1,100 @@
+/*
+    src/bench_text_layout.cpp -- Per-frame cost of drawing static text
+
+    Draws a window with 40 rows of widgets: a label, a label that wraps at
+    a fixed width, a button, a centered text box with units, and a tab
+    header with 4 tabs per row. None of the text changes between frames,
+    so once the captions were measured, a frame should only emit glyphs.
+    Uses the null backend from bench_null_context.h.
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/screen.h>
+#include <waylandgui/window.h>
+#include <waylandgui/layout.h>
+#include <waylandgui/label.h>
+#include <waylandgui/button.h>
+#include <waylandgui/textbox.h>
+#include <waylandgui/tabwidget.h>
+#include <waylandgui/theme.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "bench_null_context.h"
+
+using namespace waylandgui;
+
+static const int rows = 40, frames = 500;
+
+/// Screen without a window, which lays out widgets with the given context
+class BenchScreen : public Screen {
+public:
+    BenchScreen(NVGcontext *ctx) {
+        m_nvg_context = ctx;
+        m_size = Vector2i(1920, 2048);
+        set_theme(new Theme(ctx));
+    }
+
+    ~BenchScreen() {
+        /* Owned by main() */
+        m_nvg_context = nullptr;
+    }
+};
+
+int main() {
+    NVGcontext *ctx = create_null_context();
+    if (!ctx) {
+        fprintf(stderr, "Could not create NanoVG context!\n");
+        return 1;
+    }
+
+    /* Scope the widgets so that they are released before the context */ {
+        ref<BenchScreen> screen = new BenchScreen(ctx);
+        Window *window = new Window(screen, "Static text");
+        window->set_layout(new GridLayout(Orientation::Horizontal, 5, Alignment::Middle, 5, 2));
+
+        for (int i = 0; i < rows; ++i) {
+            std::string n = std::to_string(i);
+            new Label(window, "Label " + n);
+            Label *wrapped = new Label(window, "A longer description that wraps "
+                                               "onto several lines, number " + n);
+            wrapped->set_fixed_width(120);
+            new Button(window, "Button " + n);
+            TextBox *text_box = new TextBox(window, "Value " + n);
+            text_box->set_alignment(TextBox::Alignment::Center);
+            text_box->set_units("mm");
+            TabWidgetBase *tabs = new TabWidgetBase(window);
+            for (const char *caption : { "First", "Second", "Third", "Fourth" })
+                tabs->append_tab(caption);
+        }
+        screen->perform_layout();
+
+        auto frame = [&]() {
+            nvgBeginFrame(ctx, 1920, 2048, 1.f);
+            window->draw(ctx);
+            nvgEndFrame(ctx);
+        };
+
+        /* Warm up the glyph cache */
+        for (int i = 0; i < 10; ++i)
+            frame();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i)
+            frame();
+        auto end = std::chrono::steady_clock::now();
+
+        printf("Window with %i rows of static text widgets, %i frames:\n", rows, frames);
+        printf("  %.1f us per frame\n",
+               std::chrono::duration<double, std::micro>(end - start).count() / frames);
+    }
+
+    nvgDeleteInternal(ctx);
+    return 0;
+}
@@ -24,18 +24,13 @@ Button::Button(Widget *parent, const std::string &caption, int icon)
 
 Vector2i Button::preferred_size(NVGcontext *ctx) const {
     int font_size = m_font_size == -1 ? m_theme->m_button_font_size : m_font_size;
-    nvgFontSize(ctx, font_size);
-    nvgFontFace(ctx, "sans-bold");
-    float tw = nvgTextBounds(ctx, 0,0, m_caption.c_str(), nullptr, nullptr);
+    update_text_layout(ctx);
+    float tw = m_text_layout.advance();
     float iw = 0.0f, ih = font_size;
 
     if (m_icon) {
         if (nvg_is_font_icon(m_icon)) {
-            ih *= icon_scale();
-            nvgFontFace(ctx, "icons");
-            nvgFontSize(ctx, ih);
-            iw = nvgTextBounds(ctx, 0, 0, utf8(m_icon).data(), nullptr, nullptr)
-                + m_size.y() * 0.15f;
+            iw = m_icon_layout.advance() + m_size.y() * 0.15f;
         } else {
             int w, h;
             ih *= 0.9f;
@@ -46,6 +41,13 @@ Vector2i Button::preferred_size(NVGcontext *ctx) const {
     return Vector2i((int)(tw + iw) + 20, font_size + 10);
 }
 
+void Button::update_text_layout(NVGcontext *ctx) const {
+    int font_size = m_font_size == -1 ? m_theme->m_button_font_size : m_font_size;
+    m_text_layout.update(ctx, m_caption, "sans-bold", font_size);
+    if (m_icon && nvg_is_font_icon(m_icon))
+        m_icon_layout.update(ctx, utf8(m_icon), "icons", font_size * icon_scale());
+}
+
 bool Button::mouse_enter_event(const Vector2i &p, bool enter) {
     Widget::mouse_enter_event(p, enter);
     return true;
@@ -162,9 +164,8 @@ void Button::draw(NVGcontext *ctx) {
     nvgStroke(ctx);
 
     int font_size = m_font_size == -1 ? m_theme->m_button_font_size : m_font_size;
-    nvgFontSize(ctx, font_size);
-    nvgFontFace(ctx, "sans-bold");
-    float tw = nvgTextBounds(ctx, 0,0, m_caption.c_str(), nullptr, nullptr);
+    update_text_layout(ctx);
+    float tw = m_text_layout.advance();
 
     Vector2f center = Vector2f(m_pos) + Vector2f(m_size) * 0.5f;
     Vector2f text_pos(center.x() - tw * 0.5f, center.y() - 1);
@@ -174,14 +175,10 @@ void Button::draw(NVGcontext *ctx) {
         text_color = m_theme->m_disabled_text_color;
 
     if (m_icon) {
-        auto icon = utf8(m_icon);
-
         float iw, ih = font_size;
         if (nvg_is_font_icon(m_icon)) {
             ih *= icon_scale();
-            nvgFontSize(ctx, ih);
-            nvgFontFace(ctx, "icons");
-            iw = nvgTextBounds(ctx, 0, 0, icon.data(), nullptr, nullptr);
+            iw = m_icon_layout.advance();
         } else {
             int w, h;
             ih *= 0.9f;
@@ -191,7 +188,6 @@ void Button::draw(NVGcontext *ctx) {
         if (m_caption != "")
             iw += m_size.y() * 0.15f;
         nvgFillColor(ctx, text_color);
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
         Vector2f icon_pos = center;
         icon_pos.y() -= 1;
 
@@ -208,7 +204,8 @@ void Button::draw(NVGcontext *ctx) {
         }
 
         if (nvg_is_font_icon(m_icon)) {
-            nvgText(ctx, icon_pos.x(), icon_pos.y()+1, icon.data(), nullptr);
+            m_icon_layout.draw(ctx, icon_pos.x(), icon_pos.y()+1,
+                               NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
         } else {
             NVGpaint img_paint = nvgImagePattern(ctx,
                     icon_pos.x(), icon_pos.y() - ih/2, iw, ih, 0, m_icon, m_enabled ? 0.5f : 0.25f);
@@ -218,13 +215,10 @@ void Button::draw(NVGcontext *ctx) {
         }
     }
 
-    nvgFontSize(ctx, font_size);
-    nvgFontFace(ctx, "sans-bold");
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
     nvgFillColor(ctx, m_theme->m_text_color_shadow);
-    nvgText(ctx, text_pos.x(), text_pos.y(), m_caption.c_str(), nullptr);
+    m_text_layout.draw(ctx, text_pos.x(), text_pos.y(), NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
     nvgFillColor(ctx, text_color);
-    nvgText(ctx, text_pos.x(), text_pos.y() + 1, m_caption.c_str(), nullptr);
+    m_text_layout.draw(ctx, text_pos.x(), text_pos.y() + 1, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
 }
 
 NAMESPACE_END(waylandgui)
@@ -11,6 +11,9 @@
 #include <waylandgui/screen.h>
 
 #include <waylandgui/opengl.h>
+#include <waylandgui/executor.h>
+#include "task_queue.h"
+#include <stb_image.h>
 #include <map>
 #include <thread>
 #include <chrono>
@@ -41,9 +44,64 @@ void init() {
 }
 
 static bool mainloop_active = false;
+static std::thread::id mainloop_thread;
+
+TaskQueue m_async_queue;
+
+struct Timer {
+    uint32_t id;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::microseconds interval;
+    bool periodic;
+    std::function<void()> func;
+};
+
+std::mutex m_timer_mutex;
+std::vector<Timer> m_timers;
+uint32_t m_timer_counter = 0;
+
+/* Invoke all expired timers and return the time until the next deadline
+   in seconds, or a negative value if no timers are pending */
+static double run_timers() {
+    std::vector<std::function<void()>> expired;
+    auto now = std::chrono::steady_clock::now();
+
+    /* Collect expired timers */ {
+        std::lock_guard<std::mutex> guard(m_timer_mutex);
+        for (auto it = m_timers.begin(); it != m_timers.end(); ) {
+            if (it->deadline > now) {
+                ++it;
+                continue;
+            }
+            if (it->periodic) {
+                expired.push_back(it->func);
+                it->deadline += it->interval;
+                /* Skip missed deadlines instead of firing a burst */
+                if (it->deadline <= now)
+                    it->deadline = now + it->interval;
+                ++it;
+            } else {
+                expired.push_back(std::move(it->func));
+                it = m_timers.erase(it);
+            }
+        }
+    }
+
+    /* Run them without holding the lock so that callbacks may (un)register timers */
+    for (auto &f : expired)
+        f();
+
+    std::lock_guard<std::mutex> guard(m_timer_mutex);
+    if (m_timers.empty())
+        return -1.0;
+
+    auto next = m_timers.front().deadline;
+    for (const Timer &t : m_timers)
+        next = std::min(next, t.deadline);
 
-std::mutex m_async_mutex;
-std::vector<std::function<void()>> m_async_functions;
+    return std::max(0.0, std::chrono::duration<double>(
+        next - std::chrono::steady_clock::now()).count());
+}
 
 void mainloop(float refresh) {
     if (mainloop_active)
@@ -52,12 +110,19 @@ void mainloop(float refresh) {
     auto mainloop_iteration = []() {
         int num_screens = 0;
 
-        /* Run async functions */ {
-            std::lock_guard<std::mutex> guard(m_async_mutex);
-            for (auto &f : m_async_functions)
-                f();
-            m_async_functions.clear();
-        }
+        /* Run async functions. The pending tasks are detached from the queue
+           first, so producers never wait for them and they may enqueue
+           further work */
+        m_async_queue.consume([](Task &task) {
+            try {
+                task();
+            } catch (const std::exception &e) {
+                std::cerr << "Caught exception in async task: " << e.what() << std::endl;
+            }
+        });
+
+        /* Run expired timers */
+        double timeout = run_timers();
 
         for (auto kv : __waylandgui_screens) {
             Screen *screen = kv.second;
@@ -77,48 +142,29 @@ void mainloop(float refresh) {
             return;
         }
 
-        /* Wait for mouse/keyboard or empty refresh events */
-        glfwWaitEvents();
+        /* Wait for mouse/keyboard or empty refresh events, or until the
+           next timer expires. Block indefinitely if nothing is scheduled. */
+        if (timeout < 0)
+            glfwWaitEvents();
+        else if (timeout == 0)
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(timeout);
     };
 
     mainloop_active = true;
+    mainloop_thread = std::this_thread::get_id();
 
-    std::thread refresh_thread;
-    std::chrono::microseconds quantum;
-    size_t quantum_count = 1;
+    /* If requested, periodically refresh all screens to support
+       animations that are not driven by events */
+    uint32_t refresh_timer = 0;
     if (refresh >= 0) {
-        quantum = std::chrono::microseconds((int64_t)(refresh * 1'000));
-        while (quantum.count() > 50'000) {
-            quantum /= 2;
-            quantum_count *= 2;
-        }
-    } else {
-        quantum = std::chrono::microseconds(50'000);
-        quantum_count = std::numeric_limits<size_t>::max();
+        refresh_timer = add_timer(refresh, []() {
+            for (auto kv : __waylandgui_screens)
+                kv.second->redraw();
+        }, true);
     }
 
-    /* If there are no mouse/keyboard events, try to refresh the
-       view roughly every 50 ms (default); this is to support animations
-       such as progress bars while keeping the system load
-       reasonably low */
-    refresh_thread = std::thread(
-        [quantum, quantum_count]() {
-            while (true) {
-                for (size_t i = 0; i < quantum_count; ++i) {
-                    if (!mainloop_active)
-                        return;
-                    std::this_thread::sleep_for(quantum);
-                    for (auto kv : __waylandgui_screens) {
-                        if (kv.second->tooltip_fade_in_progress())
-                            kv.second->redraw();
-                    }
-                }
-                for (auto kv : __waylandgui_screens)
-                    kv.second->redraw();
-            }
-        }
-    );
-
     try {
         while (mainloop_active)
             mainloop_iteration();
@@ -130,16 +176,47 @@ void mainloop(float refresh) {
         leave();
     }
 
-    refresh_thread.join();
+    if (refresh_timer)
+        remove_timer(refresh_timer);
+    mainloop_thread = std::thread::id();
+}
+
+void async(Task task) {
+    /* Only the first task of a batch needs to wake up the main loop */
+    if (m_async_queue.push(std::move(task)))
+        glfwPostEmptyEvent();
+}
+
+uint32_t add_timer(float delay, const std::function<void()> &func, bool periodic) {
+    auto interval = std::chrono::microseconds((int64_t) (std::max(delay, 0.f) * 1'000));
+    uint32_t id;
+
+    /* Register timer */ {
+        std::lock_guard<std::mutex> guard(m_timer_mutex);
+        do {
+            id = ++m_timer_counter;
+        } while (id == 0);
+        m_timers.push_back(Timer{ id, std::chrono::steady_clock::now() + interval,
+                                  interval, periodic, func });
+    }
+
+    /* Wake up the main loop so that it can recompute its timeout */
+    if (mainloop_active && std::this_thread::get_id() != mainloop_thread)
+        glfwPostEmptyEvent();
+
+    return id;
 }
 
-void async(const std::function<void()> &func) {
-    std::lock_guard<std::mutex> guard(m_async_mutex);
-    m_async_functions.push_back(func);
+void remove_timer(uint32_t id) {
+    std::lock_guard<std::mutex> guard(m_timer_mutex);
+    m_timers.erase(std::remove_if(m_timers.begin(), m_timers.end(),
+                                  [id](const Timer &t) { return t.id == id; }),
+                   m_timers.end());
 }
 
 void leave() {
     mainloop_active = false;
+    glfwPostEmptyEvent();
 }
 
 bool active() {
@@ -218,6 +295,59 @@ load_image_directory(NVGcontext *ctx, const std::string &path) {
     return result;
 }
 
+ref<BackgroundTask>
+load_image_directory_async(NVGcontext *ctx, const std::string &path,
+                           const std::function<void(std::vector<std::pair<int, std::string>>)> &callback,
+                           Widget *owner) {
+    struct Image {
+        std::unique_ptr<uint8_t[], void(*)(void*)> data { nullptr, stbi_image_free };
+        int width, height;
+        std::string name;
+    };
+
+    return run_in_background(
+        [path]() {
+            /* Decode on a worker thread, same conventions as nvgCreateImage() */
+            std::vector<Image> images;
+            DIR *dp = opendir(path.c_str());
+            if (!dp)
+                throw std::runtime_error("Could not open image directory!");
+            struct dirent *ep;
+            while ((ep = readdir(dp))) {
+                const char *fname = ep->d_name;
+                if (strstr(fname, "png") == nullptr)
+                    continue;
+                std::string full_name = path + "/" + std::string(fname);
+                Image image;
+                int n;
+                stbi_set_unpremultiply_on_load(1);
+                stbi_convert_iphone_png_to_rgb(1);
+                image.data.reset(stbi_load(full_name.c_str(), &image.width, &image.height, &n, 4));
+                if (!image.data) {
+                    closedir(dp);
+                    throw std::runtime_error("Could not open image data!");
+                }
+                image.name = full_name.substr(0, full_name.length() - 4);
+                images.push_back(std::move(image));
+            }
+            closedir(dp);
+            return images;
+        },
+        [ctx, callback](std::vector<Image> images) {
+            /* Upload on the main loop thread */
+            std::vector<std::pair<int, std::string>> result;
+            for (auto &image : images) {
+                int img = nvgCreateImageRGBA(ctx, image.width, image.height, 0,
+                                             image.data.get());
+                if (img == 0)
+                    throw std::runtime_error("Could not open image data!");
+                result.push_back(std::make_pair(img, std::move(image.name)));
+            }
+            callback(std::move(result));
+        },
+        TaskPriority::Normal, owner);
+}
+
 std::string file_dialog(const std::vector<std::pair<std::string, std::string>> &filetypes, bool save) {
     auto result = file_dialog(filetypes, save, false);
     return result.empty() ? "" : result.front();
@@ -269,14 +399,16 @@ std::vector<std::string> file_dialog(const std::vector<std::pair<std::string, st
 }
 
 void Object::inc_ref() const {
-    m_ref_count++;
+    m_ref_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 void Object::dec_ref(bool dealloc) const noexcept {
-    --m_ref_count;
-    if (m_ref_count == 0 && dealloc) {
+    /* References are dropped on worker threads too, so only the thread
+       whose decrement reached zero may delete the object */
+    int ref_count = m_ref_count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    if (ref_count == 0 && dealloc) {
         delete this;
-    } else if (m_ref_count < 0) {
+    } else if (ref_count < 0) {
         fprintf(stderr, "Internal error: %p: object reference count < 0!\n", this);
         abort();
     }
@@ -0,0 +1,69 @@
+/*
+    src/damage.cpp -- Set of screen rectangles that need to be redrawn
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/damage.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+static Vector4i rect_union(const Vector4i &a, const Vector4i &b) {
+    int x0 = std::min(a[0], b[0]), y0 = std::min(a[1], b[1]),
+        x1 = std::max(a[0] + a[2], b[0] + b[2]),
+        y1 = std::max(a[1] + a[3], b[1] + b[3]);
+    return Vector4i(x0, y0, x1 - x0, y1 - y0);
+}
+
+static int64_t rect_area(const Vector4i &r) {
+    return (int64_t) r[2] * (int64_t) r[3];
+}
+
+void DamageRegion::add(const Vector2i &pos, const Vector2i &size) {
+    if (size.x() <= 0 || size.y() <= 0)
+        return;
+
+    Vector4i rect(pos.x(), pos.y(), size.x(), size.y());
+
+    /* Absorb existing rectangles as long as this wastes little area */
+    for (size_t i = 0; i < m_rects.size(); ) {
+        Vector4i merged = rect_union(m_rects[i], rect);
+        int64_t parts = rect_area(m_rects[i]) + rect_area(rect);
+        if (rect_area(merged) * 4 <= parts * 5) {
+            rect = merged;
+            m_rects.erase(m_rects.begin() + i);
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+
+    m_rects.push_back(rect);
+
+    if (m_rects.size() > MaxRects) {
+        Vector4i b = bounds();
+        m_rects.clear();
+        m_rects.push_back(b);
+    }
+}
+
+void DamageRegion::add(const DamageRegion &other) {
+    for (const Vector4i &r : other.m_rects)
+        add(Vector2i(r[0], r[1]), Vector2i(r[2], r[3]));
+}
+
+Vector4i DamageRegion::bounds() const {
+    if (m_rects.empty())
+        return Vector4i(0);
+    Vector4i result = m_rects[0];
+    for (size_t i = 1; i < m_rects.size(); ++i)
+        result = rect_union(result, m_rects[i]);
+    return result;
+}
+
+NAMESPACE_END(waylandgui)
@@ -85,6 +85,9 @@ public:
         m_shader->set_buffer("indices", VariableType::UInt32, {3*12}, indices);
         m_shader->set_buffer("position", VariableType::Float32, {8, 3}, positions);
         m_shader->set_buffer("color", VariableType::Float32, {8, 3}, colors);
+
+        // Look up the uniform that is set every frame once
+        m_mvp = m_shader->handle("mvp");
     }
 
     void set_rotation(float rotation) {
@@ -119,7 +122,7 @@ public:
 
         Matrix4f mvp = proj * view * model * model2;
 
-        m_shader->set_uniform("mvp", mvp);
+        m_shader->set_uniform(m_mvp, mvp);
 
         // Draw 12 triangles starting at index 0
         m_shader->begin();
@@ -129,6 +132,7 @@ public:
 
 private:
     ref<Shader> m_shader;
+    Shader::Handle m_mvp;
     float m_rotation;
 };
 
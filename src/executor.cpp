@@ -0,0 +1,111 @@
+/*
+    src/executor.cpp -- Background worker pool with main-thread continuations
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/executor.h>
+#include <waylandgui/widget.h>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/// Fixed-size pool of worker threads serving a priority queue
+class WorkerPool {
+public:
+    WorkerPool() {
+        unsigned int count = std::thread::hardware_concurrency();
+        /* Leave one core to the main loop thread */
+        count = count > 2 ? count - 1 : 1;
+        for (unsigned int i = 0; i < count; ++i)
+            m_threads.emplace_back([this]() { run(); });
+    }
+
+    ~WorkerPool() {
+        /* Pending work is discarded */ {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto &t : m_threads)
+            t.join();
+    }
+
+    void submit(BackgroundTask *task, Task &&work) {
+        /* Enqueue */ {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_queue.push_back(Item{ task, std::move(work), m_counter++ });
+            std::push_heap(m_queue.begin(), m_queue.end(), compare);
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    struct Item {
+        ref<BackgroundTask> task;
+        Task work;
+        uint64_t index;
+    };
+
+    /* Max-heap: higher priority first, then submission order */
+    static bool compare(const Item &a, const Item &b) {
+        if (a.task->priority() != b.task->priority())
+            return a.task->priority() < b.task->priority();
+        return a.index > b.index;
+    }
+
+    void run() {
+        while (true) {
+            Item item;
+
+            /* Dequeue */ {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+                if (m_stop)
+                    return;
+                std::pop_heap(m_queue.begin(), m_queue.end(), compare);
+                item = std::move(m_queue.back());
+                m_queue.pop_back();
+            }
+
+            if (!item.task->cancelled()) {
+                try {
+                    item.work();
+                } catch (const std::exception &e) {
+                    std::cerr << "Caught exception in background task: " << e.what() << std::endl;
+                    item.task->cancel();
+                }
+            }
+
+            /* A continuation (if any) marks non-cancelled tasks as finished */
+            if (item.task->cancelled())
+                item.task->set_finished();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Item> m_queue;
+    std::vector<std::thread> m_threads;
+    uint64_t m_counter = 0;
+    bool m_stop = false;
+};
+
+void submit_background(BackgroundTask *task, Task work, Widget *owner) {
+    /* Started on first use, torn down during static destruction */
+    static WorkerPool pool;
+
+    if (owner)
+        owner->attach_background_task(task);
+    pool.submit(task, std::move(work));
+}
+
+NAMESPACE_END(waylandgui)
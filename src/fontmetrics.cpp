@@ -0,0 +1,91 @@
+/*
+    src/fontmetrics.cpp -- Measures text with the fonts of a screen on any
+    thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/fontmetrics.h>
+#include <nanovg.h>
+#include <stdexcept>
+
+NAMESPACE_BEGIN(waylandgui)
+
+FontMetrics::Context::~Context() {
+    if (m_ctx)
+        m_metrics->release(m_ctx);
+}
+
+FontMetrics::~FontMetrics() {
+    detach();
+}
+
+void FontMetrics::attach(NVGcontext *ctx) {
+    detach();
+    NVGcontext *origin = nvgCreateMetrics(ctx);
+    if (!origin)
+        throw std::runtime_error("FontMetrics::attach(): could not create a NanoVG context!");
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_origin = origin;
+}
+
+void FontMetrics::detach() {
+    std::vector<NVGcontext *> contexts;
+    /* The lent contexts still measure with the fonts */ {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_lent == 0; });
+        contexts.swap(m_idle);
+        if (m_origin)
+            contexts.push_back(m_origin);
+        m_origin = nullptr;
+    }
+    for (NVGcontext *ctx : contexts)
+        nvgDeleteInternal(ctx);
+}
+
+bool FontMetrics::attached() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_origin != nullptr;
+}
+
+FontMetrics::Context FontMetrics::acquire(float pixel_ratio) {
+    NVGcontext *ctx = nullptr;
+    /* Reuse an idle context, or create one */ {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (!m_origin)
+            throw std::runtime_error("FontMetrics::acquire(): no fonts are attached!");
+        if (!m_idle.empty()) {
+            ctx = m_idle.back();
+            m_idle.pop_back();
+        } else {
+            ctx = nvgCreateMetrics(m_origin);
+            if (!ctx)
+                throw std::runtime_error("FontMetrics::acquire(): could not create a NanoVG context!");
+        }
+        m_lent++;
+    }
+
+    nvgBeginFrame(ctx, 0.f, 0.f, pixel_ratio);
+    return Context(this, ctx);
+}
+
+size_t FontMetrics::contexts() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_idle.size() + m_lent;
+}
+
+void FontMetrics::release(NVGcontext *ctx) {
+    /* Notify under the lock, detach() may destroy this instance as soon as
+       it is released */
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_idle.push_back(ctx);
+    m_lent--;
+    m_cv.notify_all();
+}
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,79 @@
+/*
+    src/framepacer.cpp -- Decides when a Screen may start its next frame
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/framepacer.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+
+NAMESPACE_BEGIN(waylandgui)
+
+double FramePacer::now() const {
+    return m_clock ? m_clock() : glfwGetTime();
+}
+
+double FramePacer::frame_delay() const {
+    if (m_frame_count == 0)
+        return 0.0;
+
+    if (m_mode == Mode::Timed) {
+        /* Nothing waits for the vertical blank, so start frames a whole
+           number of refresh periods apart, rounding the cap down. Outputs
+           that do not report their refresh rate still get paced */
+        double rate = m_refresh_rate > 0 ? m_refresh_rate : nominal_refresh_rate,
+               period = 1.0 / rate, n = 1.0;
+        if (m_max_fps > 0)
+            n = std::max(std::ceil(1.0 / (m_max_fps * period) - 1e-3), 1.0);
+        return std::max(m_last_start + n * period - now(), 0.0);
+    }
+
+    double earliest = 0.0;
+    bool paced = m_mode != Mode::Immediate && m_refresh_rate > 0;
+
+    if (m_mode == Mode::Simulated)
+        earliest = m_last_present;
+
+    if (m_max_fps > 0) {
+        double interval = 1.0 / m_max_fps;
+        if (paced) {
+            /* Present every n-th vertical blank, rounding the cap down. The
+               frame is presented at the vertical blank after it is started,
+               so start it one refresh period early. Otherwise, a cap at half
+               the refresh rate would only reach a third. */
+            double period = 1.0 / m_refresh_rate,
+                   n = std::max(std::ceil(interval / period - 1e-3), 1.0);
+            earliest = std::max(earliest, m_last_present + (n - 1) * period);
+        } else {
+            earliest = std::max(earliest, m_last_start + interval);
+        }
+    }
+
+    return std::max(earliest - now(), 0.0);
+}
+
+void FramePacer::frame_started() {
+    m_last_start = now();
+}
+
+void FramePacer::frame_presented() {
+    double t = now();
+
+    if (m_mode == Mode::Simulated && m_refresh_rate > 0) {
+        /* Round up to the next simulated vertical blank */
+        double period = 1.0 / m_refresh_rate;
+        t = (std::floor(t / period) + 1.0) * period;
+    }
+
+    m_last_present = t;
+    m_frame_count++;
+}
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,75 @@
+/*
+    src/framestats.cpp -- Per-frame timing statistics of a Screen
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/framestats.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+NAMESPACE_BEGIN(waylandgui)
+
+static double phase_value(const FrameTiming &timing, FrameStats::Phase phase) {
+    switch (phase) {
+        case FrameStats::Phase::Setup:    return timing.setup;
+        case FrameStats::Phase::Contents: return timing.contents;
+        case FrameStats::Phase::Widgets:  return timing.widgets;
+        case FrameStats::Phase::Flush:    return timing.flush;
+        case FrameStats::Phase::Swap:     return timing.swap;
+        case FrameStats::Phase::Total:    return timing.total;
+        case FrameStats::Phase::Latency:  return timing.latency;
+        default: throw std::runtime_error("FrameStats: invalid phase!");
+    }
+}
+
+FrameStats::FrameStats(size_t capacity) : m_frames(std::max(capacity, (size_t) 1)) { }
+
+void FrameStats::push(const FrameTiming &timing) {
+    m_frames[m_next] = timing;
+    m_next = (m_next + 1) % m_frames.size();
+    m_count = std::min(m_count + 1, m_frames.size());
+}
+
+double FrameStats::percentile(Phase phase, float p) const {
+    std::vector<double> values;
+    values.reserve(m_count);
+    for (size_t i = 0; i < m_count; ++i) {
+        double value = phase_value((*this)[i], phase);
+        if (value >= 0)
+            values.push_back(value);
+    }
+    if (values.empty())
+        return 0.0;
+
+    p = std::min(std::max(p, 0.f), 100.f);
+    size_t rank = (size_t) std::ceil(p / 100.f * values.size());
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void FrameStats::write_csv(const std::string &filename) const {
+    std::ofstream os(filename);
+    if (!os)
+        throw std::runtime_error("FrameStats::write_csv(): could not open \"" +
+                                 filename + "\" for writing!");
+
+    os << "frame,setup_ms,contents_ms,widgets_ms,flush_ms,swap_ms,total_ms,latency_ms\n";
+    for (size_t i = 0; i < m_count; ++i) {
+        const FrameTiming &t = (*this)[i];
+        os << i << ',' << t.setup << ',' << t.contents << ',' << t.widgets << ','
+           << t.flush << ',' << t.swap << ',' << t.total << ',';
+        if (t.latency >= 0)
+            os << t.latency;
+        os << '\n';
+    }
+}
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,131 @@
+/*
+    src/glyphrasterizer.cpp -- Rasterizes glyphs missing from the font atlas
+    on the background worker pool
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/glyphrasterizer.h>
+#include <waylandgui/executor.h>
+#include <GLFW/glfw3.h>
+#include <nanovg.h>
+#include <algorithm>
+#include <chrono>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/// Glyphs per task of the worker pool, so that a burst spreads over the workers
+static const size_t glyphs_per_batch = 16;
+
+GlyphRasterizer::~GlyphRasterizer() {
+    detach();
+}
+
+bool GlyphRasterizer::attach(NVGcontext *ctx) {
+    detach();
+    if (!ctx || !nvgSetGlyphRasterizer(ctx, enqueue, this, m_max_pending_frames))
+        return false;
+    m_ctx = ctx;
+    return true;
+}
+
+void GlyphRasterizer::detach() {
+    if (!m_ctx)
+        return;
+
+    std::vector<NVGglyphJob *> done;
+    /* The workers hold on to this instance */ {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_in_flight == 0; });
+        done.swap(m_done);
+    }
+    done.insert(done.end(), m_missed.begin(), m_missed.end());
+    m_missed.clear();
+    for (NVGglyphJob *job : done)
+        nvgDeleteGlyphJob(job);
+
+    /* Glyphs left pending are rasterized when drawn next */
+    nvgSetGlyphRasterizer(m_ctx, nullptr, nullptr, 0);
+    m_ctx = nullptr;
+}
+
+void GlyphRasterizer::set_max_pending_frames(int frames) {
+    m_max_pending_frames = std::max(frames, 0);
+    if (m_ctx)
+        nvgSetGlyphRasterizer(m_ctx, enqueue, this, m_max_pending_frames);
+}
+
+void GlyphRasterizer::enqueue(void *uptr, NVGglyphJob *job) {
+    ((GlyphRasterizer *) uptr)->m_missed.push_back(job);
+}
+
+void GlyphRasterizer::submit() {
+    if (m_missed.empty())
+        return;
+
+    /* Register the batches before any of them can finish */ {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_in_flight += m_missed.size();
+    }
+
+    for (size_t i = 0; i < m_missed.size(); i += glyphs_per_batch) {
+        std::vector<NVGglyphJob *> batch(
+            m_missed.begin() + i,
+            m_missed.begin() + std::min(i + glyphs_per_batch, m_missed.size()));
+        ref<BackgroundTask> task = new BackgroundTask(TaskPriority::High);
+
+        submit_background(task, [this, task, batch = std::move(batch)]() mutable {
+            for (NVGglyphJob *job : batch)
+                nvgRasterizeGlyph(job);
+            /* Hand over, notifying under the lock: detach() may return and
+               the owner be destroyed as soon as it is released, so nothing
+               of this instance is touched after that */ {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                m_done.insert(m_done.end(), batch.begin(), batch.end());
+                m_in_flight -= batch.size();
+                m_cv.notify_all();
+            }
+            task->set_finished();
+
+            /* Wake up the main loop, which redraws the text */
+            glfwPostEmptyEvent();
+        });
+    }
+    m_missed.clear();
+}
+
+bool GlyphRasterizer::finish(bool wait) {
+    if (!m_ctx)
+        return false;
+
+    std::vector<NVGglyphJob *> done;
+    /* Collect the finished batches */ {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait && m_in_flight > 0 && m_wait_budget > 0)
+            m_cv.wait_for(lock, std::chrono::duration<double>(m_wait_budget),
+                          [this]() { return m_in_flight == 0; });
+        done.swap(m_done);
+    }
+    if (done.empty())
+        return false;
+
+    int added = nvgFinishGlyphs(m_ctx, done.data(), (int) done.size());
+    m_glyphs_added += (size_t) added;
+    return added > 0;
+}
+
+size_t GlyphRasterizer::pending() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_in_flight + m_done.size() + m_missed.size();
+}
+
+int GlyphRasterizer::stalls() const {
+    return m_ctx ? nvgGlyphStalls(m_ctx) : 0;
+}
+
+NAMESPACE_END(waylandgui)
@@ -11,6 +11,7 @@
 */
 
 #include <waylandgui/imagepanel.h>
+#include <waylandgui/screen.h>
 #include <waylandgui/opengl.h>
 
 NAMESPACE_BEGIN(waylandgui)
@@ -19,6 +20,17 @@ ImagePanel::ImagePanel(Widget *parent)
     : Widget(parent), m_thumb_size(64), m_spacing(10), m_margin(10),
       m_mouse_index(-1) {}
 
+void ImagePanel::load_images(const std::string &path) {
+    load_image_directory_async(screen()->nvg_context(), path,
+        [this](Images images) {
+            m_images = std::move(images);
+            m_mouse_index = -1;
+            Screen *screen = this->screen();
+            screen->perform_layout();
+            screen->redraw();
+        }, this);
+}
+
 Vector2i ImagePanel::grid_size() const {
     int n_cols = 1 + std::max(0,
         (int) ((m_size.x() - 2 * m_margin - m_thumb_size) /
@@ -38,6 +38,9 @@ ImageView::ImageView(Widget *parent) : Canvas(parent, 1, false, false, false) {
 
     m_image_shader->set_buffer("position", VariableType::Float32, { 6, 2 },
                                positions);
+    m_matrix_image_handle = m_image_shader->handle("matrix_image");
+    m_matrix_background_handle = m_image_shader->handle("matrix_background");
+    m_background_color_handle = m_image_shader->handle("background_color");
     m_render_pass->set_cull_mode(RenderPass::CullMode::Disabled);
 
     m_image_border_color = m_theme->m_border_dark;
@@ -53,6 +56,17 @@ void ImageView::set_image(Texture *image) {
     m_image = image;
 }
 
+void ImageView::load_image(const std::string &filename) {
+    Texture::load_async(filename,
+        [this](Texture *image) {
+            set_image(image);
+            center();
+            screen()->redraw();
+        }, this,
+        Texture::InterpolationMode::Trilinear,
+        Texture::InterpolationMode::Nearest);
+}
+
 float ImageView::scale() const {
     return std::pow(2.f, m_scale / 5.f);
 }
@@ -221,9 +235,9 @@ void ImageView::draw_contents() {
         Matrix4f::scale(Vector3f(m_image->size().x() * scale,
                                  m_image->size().y() * scale, 1.f));
 
-    m_image_shader->set_uniform("matrix_image",      Matrix4f(matrix_image));
-    m_image_shader->set_uniform("matrix_background", Matrix4f(matrix_background));
-    m_image_shader->set_uniform("background_color",  m_image_background_color);
+    m_image_shader->set_uniform(m_matrix_image_handle,      Matrix4f(matrix_image));
+    m_image_shader->set_uniform(m_matrix_background_handle, Matrix4f(matrix_background));
+    m_image_shader->set_uniform(m_background_color_handle,  m_image_background_color);
 
     m_image_shader->begin();
     m_image_shader->draw_array(Shader::PrimitiveType::Triangle, 0, 6, false);
@@ -35,34 +35,29 @@ void Label::set_theme(Theme *theme) {
 Vector2i Label::preferred_size(NVGcontext *ctx) const {
     if (m_caption == "")
         return Vector2i(0);
-    nvgFontFace(ctx, m_font.c_str());
-    nvgFontSize(ctx, font_size());
+    update_text_layout(ctx);
     if (m_fixed_size.x() > 0) {
-        float bounds[4];
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
-        nvgTextBoxBounds(ctx, m_pos.x(), m_pos.y(), m_fixed_size.x(), m_caption.c_str(), nullptr, bounds);
+        const float *bounds = m_text_layout.bounds();
         return Vector2i(m_fixed_size.x(), bounds[3] - bounds[1]);
     } else {
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
-        return Vector2i(
-            nvgTextBounds(ctx, 0, 0, m_caption.c_str(), nullptr, nullptr) + 2,
-            font_size()
-        );
+        return Vector2i(m_text_layout.advance() + 2, font_size());
     }
 }
 
+void Label::update_text_layout(NVGcontext *ctx) const {
+    m_text_layout.update(ctx, m_caption, m_font, font_size(),
+                         std::max(m_fixed_size.x(), 0));
+}
+
 void Label::draw(NVGcontext *ctx) {
     Widget::draw(ctx);
-    nvgFontFace(ctx, m_font.c_str());
-    nvgFontSize(ctx, font_size());
+    update_text_layout(ctx);
     nvgFillColor(ctx, m_color);
-    if (m_fixed_size.x() > 0) {
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
-        nvgTextBox(ctx, m_pos.x(), m_pos.y(), m_fixed_size.x(), m_caption.c_str(), nullptr);
-    } else {
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
-        nvgText(ctx, m_pos.x(), m_pos.y() + m_size.y() * 0.5f, m_caption.c_str(), nullptr);
-    }
+    if (m_fixed_size.x() > 0)
+        m_text_layout.draw(ctx, m_pos.x(), m_pos.y(), NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    else
+        m_text_layout.draw(ctx, m_pos.x(), m_pos.y() + m_size.y() * 0.5f,
+                           NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
 }
 
 NAMESPACE_END(waylandgui)
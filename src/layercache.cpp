@@ -0,0 +1,240 @@
+/*
+    src/layercache.cpp -- Offscreen textures holding the rendered output of
+    widgets drawn as layers
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/layercache.h>
+#include <waylandgui/screen.h>
+#include <waylandgui/texture.h>
+#include <waylandgui/renderpass.h>
+#include <waylandgui/opengl.h>
+#define NANOVG_GLES3 1
+#include <nanovg_gl.h>
+#include <cmath>
+#include "opengl_check.h"
+
+NAMESPACE_BEGIN(waylandgui)
+
+LayerCache::~LayerCache() {
+    clear();
+}
+
+void LayerCache::set_budget(size_t bytes) {
+    m_budget = bytes;
+    make_room(0);
+}
+
+bool LayerCache::draw(NVGcontext *ctx, Widget *widget, Screen *screen) {
+    int margin = widget->layer_margin();
+    Vector2i size = widget->size() + 2 * margin;
+    float pixel_ratio = screen->pixel_ratio();
+    Vector2i fbsize((int) std::ceil(size.x() * pixel_ratio),
+                    (int) std::ceil(size.y() * pixel_ratio));
+    if (fbsize.x() <= 0 || fbsize.y() <= 0)
+        return false;
+
+    /* The widget may have been moved to another screen */
+    if (widget->m_layer_cache && widget->m_layer_cache != this)
+        widget->m_layer_cache->release(widget);
+
+    auto it = m_layers.find(widget);
+    if (it != m_layers.end() &&
+        (it->second.fbsize != fbsize || it->second.pixel_ratio != pixel_ratio ||
+         it->second.ctx != ctx)) {
+        erase(it);
+        it = m_layers.end();
+    }
+
+    Layer *layer = it != m_layers.end() ? &it->second : nullptr;
+    if (!layer) {
+        layer = allocate(ctx, widget, fbsize, pixel_ratio);
+        if (!layer)
+            return false;
+        widget->m_layer_valid = false;
+    }
+    layer->last_used = m_frame;
+
+    /* Widgets draw themselves at m_pos in their parent's coordinate system */
+    Vector2i origin = widget->position() - margin;
+    if (!widget->m_layer_valid)
+        render(ctx, widget, *layer, origin, size, screen);
+
+    /* The margin holds output that ignores the scissor (e.g. drop shadows) */
+    nvgSave(ctx);
+    if (margin > 0)
+        nvgResetScissor(ctx);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, origin.x(), origin.y(), size.x(), size.y());
+    nvgFillPaint(ctx, nvgImagePattern(ctx, origin.x(), origin.y(), size.x(),
+                                      size.y(), 0.f, layer->image, 1.f));
+    nvgFill(ctx);
+    nvgRestore(ctx);
+    return true;
+}
+
+void LayerCache::render(NVGcontext *ctx, Widget *widget, Layer &layer,
+                        const Vector2i &origin, const Vector2i &size,
+                        Screen *screen) {
+    NVGparams *params = nvgInternalParams(ctx);
+    const Vector4i &scissor_rect = screen->m_repaint_rect;
+
+    /* Submit everything drawn so far to the screen's framebuffer */
+    params->renderFlush(params->userPtr);
+    nvglScissorRectGLES3(ctx, 0, 0, -1, -1);
+
+    layer.render_pass->set_viewport(Vector2i(0), layer.fbsize);
+    layer.render_pass->begin();
+    CHK(glDisable(GL_SCISSOR_TEST));
+    CHK(glClearColor(0.f, 0.f, 0.f, 0.f));
+    CHK(glClearDepthf(1.f));
+    CHK(glClearStencil(0));
+    CHK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT));
+    params->renderViewport(params->userPtr, (float) size.x(), (float) size.y(),
+                           layer.pixel_ratio);
+
+    /* Don't record the layer's contents into retained ancestors, which only
+       need the composited quad */
+    int recordings = nvgSuspendDisplayLists(ctx);
+    nvgSave(ctx);
+    nvgReset(ctx);
+    nvgTranslate(ctx, -origin.x(), -origin.y());
+
+    /* Invalidations while drawing (e.g. by animated children) must stick */
+    widget->m_layer_valid = true;
+    int placeholders = nvgGlyphPlaceholders(ctx);
+    if (widget->m_retained)
+        widget->draw_retained(ctx);
+    else
+        widget->draw(ctx);
+
+    /* Render again once the glyphs that were left out are rasterized */
+    if (nvgGlyphPlaceholders(ctx) != placeholders)
+        widget->m_layer_valid = false;
+
+    nvgRestore(ctx);
+    nvgResumeDisplayLists(ctx, recordings);
+
+    params->renderFlush(params->userPtr);
+    layer.render_pass->end();
+
+    nvglScissorRectGLES3(ctx, scissor_rect[0], scissor_rect[1],
+                         scissor_rect[2], scissor_rect[3]);
+    params->renderViewport(params->userPtr, (float) screen->width(),
+                           (float) screen->height(), screen->pixel_ratio());
+}
+
+LayerCache::Layer *LayerCache::allocate(NVGcontext *ctx, Widget *widget,
+                                        const Vector2i &fbsize,
+                                        float pixel_ratio) {
+    /* All layers share one depth/stencil buffer that fits the largest one */
+    Vector2i stencil_size = m_stencil ? max(fbsize, m_stencil->size()) : fbsize;
+    size_t stencil_bpp = m_stencil ? m_stencil->bytes_per_pixel() : 8,
+           stencil_growth = stencil_bpp * (size_t) stencil_size.x() *
+                            (size_t) stencil_size.y() - m_stencil_bytes,
+           bytes = (size_t) fbsize.x() * (size_t) fbsize.y() * 4;
+
+    if (!make_room(bytes + stencil_growth))
+        return nullptr;
+
+    if (!m_stencil) {
+        m_stencil = new Texture(
+            Texture::PixelFormat::DepthStencil,
+            Texture::ComponentFormat::Float32,
+            stencil_size,
+            Texture::InterpolationMode::Nearest,
+            Texture::InterpolationMode::Nearest,
+            Texture::WrapMode::ClampToEdge,
+            1,
+            Texture::TextureFlags::RenderTarget
+        );
+    } else if (stencil_size != m_stencil->size()) {
+        /* Keeps the renderbuffer handle, so existing framebuffers stay valid */
+        m_stencil->resize(stencil_size);
+    }
+    m_memory_usage -= m_stencil_bytes;
+    m_stencil_bytes = m_stencil->bytes_per_pixel() *
+                      (size_t) stencil_size.x() * (size_t) stencil_size.y();
+    m_memory_usage += m_stencil_bytes;
+
+    Layer layer;
+    layer.color = new Texture(
+        Texture::PixelFormat::RGBA,
+        Texture::ComponentFormat::UInt8,
+        fbsize,
+        Texture::InterpolationMode::Bilinear,
+        Texture::InterpolationMode::Bilinear,
+        Texture::WrapMode::ClampToEdge,
+        1,
+        Texture::TextureFlags::ShaderRead | Texture::TextureFlags::RenderTarget
+    );
+    layer.render_pass = new RenderPass({ layer.color }, m_stencil, m_stencil,
+                                       nullptr, false);
+
+    /* NanoVG renders upside down into textures, with premultiplied alpha */
+    layer.image = nvglCreateImageFromHandleGLES3(
+        ctx, layer.color->texture_handle(), fbsize.x(), fbsize.y(),
+        NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED | NVG_IMAGE_NODELETE);
+    if (layer.image == 0)
+        return nullptr;
+
+    layer.ctx = ctx;
+    layer.fbsize = fbsize;
+    layer.pixel_ratio = pixel_ratio;
+    layer.bytes = bytes;
+    m_memory_usage += bytes;
+
+    widget->m_layer_cache = this;
+    return &(m_layers[widget] = std::move(layer));
+}
+
+bool LayerCache::make_room(size_t bytes) {
+    while (m_memory_usage + bytes > m_budget) {
+        auto victim = m_layers.end();
+        for (auto it = m_layers.begin(); it != m_layers.end(); ++it) {
+            if (it->second.last_used < m_frame &&
+                (victim == m_layers.end() ||
+                 it->second.last_used < victim->second.last_used))
+                victim = it;
+        }
+        if (victim == m_layers.end())
+            return false;
+
+        /* Retained ancestors may have recorded the composited quad */
+        victim->first->invalidate_display_list();
+        erase(victim);
+    }
+    return true;
+}
+
+void LayerCache::release(Widget *widget) {
+    auto it = m_layers.find(widget);
+    if (it != m_layers.end())
+        erase(it);
+}
+
+void LayerCache::erase(std::unordered_map<Widget *, Layer>::iterator it) {
+    Layer &layer = it->second;
+    if (layer.image)
+        nvgDeleteImage(layer.ctx, layer.image);
+    m_memory_usage -= layer.bytes;
+    it->first->m_layer_cache = nullptr;
+    it->first->m_layer_valid = false;
+    m_layers.erase(it);
+}
+
+void LayerCache::clear() {
+    while (!m_layers.empty())
+        erase(m_layers.begin());
+    m_stencil = nullptr;
+    m_memory_usage -= m_stencil_bytes;
+    m_stencil_bytes = 0;
+}
+
+NAMESPACE_END(waylandgui)
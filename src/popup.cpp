@@ -24,9 +24,15 @@ void Popup::perform_layout(NVGcontext *ctx) {
     if (m_layout || m_children.size() != 1) {
         Widget::perform_layout(ctx);
     } else {
+        /* Same bookkeeping as Widget::perform_layout(), which Screen relies
+           on to tell which windows need to be laid out again */
+        invalidate_display_list();
+        m_spatial_index_valid = false;
+        m_layout_dirty = false;
+        m_laid_out = true;
         m_children[0]->set_position(Vector2i(0));
         m_children[0]->set_size(m_size);
-        m_children[0]->perform_layout(ctx);
+        m_children[0]->update_layout(ctx);
     }
     if (m_side == Side::Left)
         m_anchor_pos[0] -= size()[0];
@@ -36,8 +42,18 @@ void Popup::refresh_relative_placement() {
     if (!m_parent_window)
         return;
     m_parent_window->refresh_relative_placement();
-    m_visible &= m_parent_window->visible_recursive();
-    m_pos = m_parent_window->position() + m_anchor_pos - Vector2i(0, m_anchor_offset);
+    bool visible = m_visible && m_parent_window->visible_recursive();
+    Vector2i pos = m_parent_window->position() + m_anchor_pos - Vector2i(0, m_anchor_offset);
+    if (visible != m_visible || pos != m_pos) {
+        m_visible = visible;
+        m_pos = pos;
+        if (m_parent)
+            m_parent->invalidate_spatial_index();
+    }
+}
+
+int Popup::layer_margin() const {
+    return std::max(Window::layer_margin(), m_anchor_size + 1);
 }
 
 void Popup::draw(NVGcontext* ctx) {
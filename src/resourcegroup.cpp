@@ -0,0 +1,62 @@
+/*
+    src/resourcegroup.cpp -- Fonts, glyph atlas and GL objects shared by
+    several screens
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/resourcegroup.h>
+#include <waylandgui/screen.h>
+#include <waylandgui/theme.h>
+#include <algorithm>
+
+NAMESPACE_BEGIN(waylandgui)
+
+ResourceGroup::~ResourceGroup() {
+    /* Screens hold a reference, so none is left by now */
+    m_glyph_rasterizer.detach();
+}
+
+GLFWwindow *ResourceGroup::share_window() const {
+    return m_screens.empty() ? nullptr : m_screens.front()->glfw_window();
+}
+
+NVGcontext *ResourceGroup::share_context() const {
+    return m_screens.empty() ? nullptr : m_screens.front()->nvg_context();
+}
+
+void ResourceGroup::add(Screen *screen) {
+    if (!m_theme) {
+        m_theme = new Theme(screen->nvg_context());
+        m_font_metrics.attach(screen->nvg_context());
+    }
+    m_screens.push_back(screen);
+}
+
+void ResourceGroup::remove(Screen *screen) {
+    auto it = std::find(m_screens.begin(), m_screens.end(), screen);
+    if (it == m_screens.end())
+        return;
+    m_screens.erase(it);
+
+    /* The rasterizer hands glyphs to the shared atlas through the context
+       that attached it, so move it to one that stays around */
+    if (m_glyph_rasterizer.context() == screen->nvg_context()) {
+        m_glyph_rasterizer.detach();
+        if (!m_screens.empty())
+            m_glyph_rasterizer.attach(m_screens.front()->nvg_context());
+    }
+
+    /* The fonts of the theme go away along with the last context */
+    if (m_screens.empty()) {
+        m_font_metrics.detach();
+        m_theme = nullptr;
+    }
+}
+
+NAMESPACE_END(waylandgui)
@@ -0,0 +1,132 @@
+/*
+    src/resourcepack.cpp -- Resource files mapped into memory from a pack
+    that is built along with the library
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/resourcepack.h>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/* Keep in sync with resources/pack_resources.cpp */
+static const size_t header_size = 16, entry_size = 64, name_size = 56, alignment = 4096;
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+ResourcePack::ResourcePack(const std::string &path) : m_path(path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("ResourcePack: could not open \"" + path + "\"");
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) header_size) {
+        m_size = (size_t) st.st_size;
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m_data == MAP_FAILED)
+            m_data = nullptr;
+    }
+    close(fd);
+
+    const uint8_t *data = (const uint8_t *) m_data;
+    if (!data || memcmp(data, "WGUIPACK", 8) != 0 || read_u32(data + 8) != 1) {
+        if (m_data)
+            munmap(m_data, m_size);
+        throw std::runtime_error("ResourcePack: \"" + path + "\" is not a resource pack");
+    }
+
+    /* Pages are loaded as resources are used, without reading ahead into
+       the resources that are not */
+    madvise(m_data, m_size, MADV_RANDOM);
+
+    size_t count = read_u32(data + 12);
+    for (size_t i = 0; i < count && header_size + (i + 1) * entry_size <= m_size; ++i) {
+        const uint8_t *entry = data + header_size + i * entry_size;
+        size_t offset = read_u32(entry + name_size), size = read_u32(entry + name_size + 4);
+        if (offset > m_size || size > m_size - offset)
+            continue;
+        std::string name((const char *) entry, strnlen((const char *) entry, name_size));
+        m_resources[name] = Resource { data + offset, size };
+    }
+}
+
+ResourcePack::~ResourcePack() {
+    if (m_data)
+        munmap(m_data, m_size);
+}
+
+ResourcePack::Resource ResourcePack::get(const std::string &name) const {
+    auto it = m_resources.find(name);
+    return it != m_resources.end() ? it->second : Resource();
+}
+
+void ResourcePack::evict(const std::string &name) const {
+    Resource resource = get(name);
+    if (!resource.data || resource.size == 0)
+        return;
+    /* Resources are padded to the alignment of the pack. Pages of the
+       system may be larger, so drop only those that lie within the padded
+       resource and leave ones shared with its neighbours alone */
+    uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE),
+              start = (uintptr_t) resource.data,
+              end = start + (resource.size + alignment - 1) / alignment * alignment;
+    start = (start + page - 1) / page * page;
+    end = end / page * page;
+    if (start < end)
+        madvise((void *) start, end - start, MADV_DONTNEED);
+}
+
+/// Map the first pack found where \ref ResourcePack::builtin() looks
+static ResourcePack *find_builtin() {
+    std::vector<std::string> paths;
+    if (const char *env = getenv("WAYLANDGUI_RESOURCE_PACK"))
+        paths.push_back(env);
+
+    /* Next to the library, e.g. in the build tree */
+    Dl_info info;
+    if (dladdr((void *) &ResourcePack::builtin, &info) && info.dli_fname) {
+        std::string library = info.dli_fname;
+        size_t slash = library.find_last_of('/');
+        paths.push_back((slash == std::string::npos ? std::string(".")
+                                                    : library.substr(0, slash)) + "/waylandgui.pack");
+    }
+
+#if defined(WAYLANDGUI_RESOURCE_PACK_PATH)
+    paths.push_back(WAYLANDGUI_RESOURCE_PACK_PATH);
+#endif
+
+    for (const std::string &path : paths) {
+        if (access(path.c_str(), R_OK) == 0)
+            return new ResourcePack(path);
+    }
+
+    std::string tried;
+    for (const std::string &path : paths)
+        tried += "\n  " + path;
+    throw std::runtime_error("ResourcePack::builtin(): could not find waylandgui.pack, tried:" + tried);
+}
+
+const ResourcePack &ResourcePack::builtin() {
+    /* Looked for again by the next call if this one throws */
+    static std::unique_ptr<ResourcePack> pack(find_builtin());
+    return *pack;
+}
+
+NAMESPACE_END(waylandgui)
@@ -21,6 +21,10 @@
 
 #define NANOVG_GLES3_IMPLEMENTATION
 #include <nanovg_gl.h>
+#define GLFW_EXPOSE_NATIVE_EGL
+#include <GLFW/glfw3native.h>
+#include <EGL/eglext.h>
+#include <cstring>
 # include "opengl_check.h"
 
 #if !defined(GL_RGBA_FLOAT_MODE)
@@ -40,6 +44,52 @@ static float get_pixel_ratio(GLFWwindow *window) {
     return xscale;
 }
 
+/* Maximum buffer age for which partial redraws are attempted */
+static const size_t max_buffer_age = 4;
+
+/* EGL extensions used for partial redraws, queried once per process */
+struct EGLDamageSupport {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    bool buffer_age = false;
+    PFNEGLSETDAMAGEREGIONKHRPROC set_damage_region = nullptr;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_buffers_with_damage = nullptr;
+};
+
+static bool egl_has_extension(const char *extensions, const char *name) {
+    size_t len = strlen(name);
+    for (const char *p = extensions; p && (p = strstr(p, name)) != nullptr; p += len) {
+        bool start = p == extensions || p[-1] == ' ';
+        bool end = p[len] == ' ' || p[len] == '\0';
+        if (start && end)
+            return true;
+    }
+    return false;
+}
+
+static const EGLDamageSupport &egl_damage_support() {
+    static EGLDamageSupport support = []() {
+        EGLDamageSupport s;
+        s.display = glfwGetEGLDisplay();
+        if (s.display == EGL_NO_DISPLAY)
+            return s;
+        const char *ext = eglQueryString(s.display, EGL_EXTENSIONS);
+
+        s.buffer_age = egl_has_extension(ext, "EGL_EXT_buffer_age") ||
+                       egl_has_extension(ext, "EGL_KHR_partial_update");
+        if (egl_has_extension(ext, "EGL_KHR_partial_update"))
+            s.set_damage_region = (PFNEGLSETDAMAGEREGIONKHRPROC)
+                eglGetProcAddress("eglSetDamageRegionKHR");
+        if (egl_has_extension(ext, "EGL_KHR_swap_buffers_with_damage"))
+            s.swap_buffers_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)
+                eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+        else if (egl_has_extension(ext, "EGL_EXT_swap_buffers_with_damage"))
+            s.swap_buffers_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)
+                eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+        return s;
+    }();
+    return support;
+}
+
 
 Screen::Screen()
     : Widget(nullptr), m_glfw_window(nullptr), m_nvg_context(nullptr),
@@ -51,11 +101,12 @@ Screen::Screen()
 
 Screen::Screen(const Vector2i &size, const std::string &caption, bool resizable,
                bool fullscreen, bool depth_buffer, bool stencil_buffer,
-               bool float_buffer, unsigned int gl_major, unsigned int gl_minor)
+               bool float_buffer, unsigned int gl_major, unsigned int gl_minor,
+               ResourceGroup *resources)
     : Widget(nullptr), m_glfw_window(nullptr), m_nvg_context(nullptr),
       m_cursor(Cursor::Arrow), m_background(0.3f, 0.3f, 0.32f, 1.f), m_caption(caption),
       m_shutdown_glfw(false), m_fullscreen(fullscreen), m_depth_buffer(depth_buffer),
-      m_stencil_buffer(stencil_buffer), m_redraw(false) {
+      m_stencil_buffer(stencil_buffer), m_redraw(false), m_resources(resources) {
     memset(m_cursors, 0, sizeof(GLFWcursor *) * (int) Cursor::CursorCount);
 
     // Was GLFW_OPENGL_ES_API but that causes wayland windows to not display
@@ -87,15 +138,18 @@ Screen::Screen(const Vector2i &size, const std::string &caption, bool resizable,
     glfwWindowHint(GLFW_RESIZABLE, resizable ? GL_TRUE : GL_FALSE);
     glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE);
 
+    /* Screens of a resource group share the objects of their GL contexts */
+    GLFWwindow *share = m_resources ? m_resources->share_window() : nullptr;
+
     for (int i = 0; i < 2; ++i) {
         if (fullscreen) {
             GLFWmonitor *monitor = glfwGetPrimaryMonitor();
             const GLFWvidmode *mode = glfwGetVideoMode(monitor);
             m_glfw_window = glfwCreateWindow(mode->width, mode->height,
-                                             caption.c_str(), monitor, nullptr);
+                                             caption.c_str(), monitor, share);
         } else {
             m_glfw_window = glfwCreateWindow(size.x(), size.y(),
-                                             caption.c_str(), nullptr, nullptr);
+                                             caption.c_str(), nullptr, share);
         }
     }
 
@@ -119,7 +173,7 @@ Screen::Screen(const Vector2i &size, const std::string &caption, bool resizable,
     CHK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
                 GL_STENCIL_BUFFER_BIT));
 
-    glfwSwapInterval(0);
+    set_frame_pacing(m_frame_pacer.mode());
     glfwSwapBuffers(m_glfw_window);
 
     /* Propagate GLFW events to the appropriate Screen instance */
@@ -222,6 +276,7 @@ Screen::Screen(const Vector2i &size, const std::string &caption, bool resizable,
 
             Screen *s = it->second;
             // focus_event: 0 when false, 1 when true
+            s->flush_input_events();
             s->focus_event(focused != 0);
         }
     );
@@ -259,13 +314,23 @@ void Screen::initialize(GLFWwindow *window, bool shutdown_glfw) {
     flags |= NVG_DEBUG;
 #endif
 
-    m_nvg_context = nvgCreateGLES3(flags);
+    NVGcontext *share = m_resources ? m_resources->share_context() : nullptr;
+    if (share)
+        m_nvg_context = nvgCreateSharedGLES3(share, flags);
+    else
+        m_nvg_context = nvgCreateGLES3(flags);
 
     if (!m_nvg_context)
         throw std::runtime_error("Could not initialize NanoVG!");
 
     m_visible = glfwGetWindowAttrib(window, GLFW_VISIBLE) != 0;
-    set_theme(new Theme(m_nvg_context));
+    if (m_resources) {
+        m_resources->add(this);
+        set_theme(m_resources->theme());
+    } else {
+        set_theme(new Theme(m_nvg_context));
+        m_font_metrics.attach(m_nvg_context);
+    }
     m_mouse_pos = Vector2i(0);
     m_mouse_state = m_modifiers = 0;
     m_drag_active = false;
@@ -284,11 +349,22 @@ void Screen::initialize(GLFWwindow *window, bool shutdown_glfw) {
 
 Screen::~Screen() {
     __waylandgui_screens.erase(m_glfw_window);
+    if (m_tooltip_timer)
+        remove_timer(m_tooltip_timer);
+    if (m_frame_timer)
+        remove_timer(m_frame_timer);
     for (size_t i = 0; i < (size_t) Cursor::CursorCount; ++i) {
         if (m_cursors[i])
             glfwDestroyCursor(m_cursors[i]);
     }
 
+    /* Release layer textures while the GL context still exists */
+    m_layer_cache.clear();
+    m_glyph_rasterizer.detach();
+    m_font_metrics.detach();
+    if (m_resources)
+        m_resources->remove(this);
+
     if (m_nvg_context) {
         nvgDeleteGLES3(m_nvg_context);
     }
@@ -338,18 +414,236 @@ void Screen::draw_setup() {
     CHK(glViewport(0, 0, m_fbsize[0], m_fbsize[1]));
 }
 
+void Screen::begin_damage_frame(bool full) {
+    DamageRegion damage;
+    if (full)
+        damage.add(Vector2i(0), m_size);
+    else
+        std::swap(damage, m_damage);
+    m_damage.clear();
+    m_repaint_rect = Vector4i(0, 0, -1, -1);
+
+    const EGLDamageSupport &egl = egl_damage_support();
+    EGLSurface surface = egl.display != EGL_NO_DISPLAY
+                             ? glfwGetEGLSurface(m_glfw_window) : EGL_NO_SURFACE;
+
+    if (!full && egl.buffer_age && surface != EGL_NO_SURFACE) {
+        /* The back buffer holds the frame from 'age' swaps ago (0: undefined
+           contents). Repaint everything that changed since then. */
+        EGLint age = 0;
+        eglQuerySurface(egl.display, surface, EGL_BUFFER_AGE_EXT, &age);
+
+        if (age > 0 && (size_t) age <= max_buffer_age &&
+            (size_t) age - 1 <= m_damage_history.size()) {
+            DamageRegion repaint = damage;
+            for (size_t i = 0; i + 1 < (size_t) age; ++i)
+                repaint.add(m_damage_history[m_damage_history.size() - 1 - i]);
+
+            /* Convert to framebuffer pixels (origin at the bottom left) */
+            Vector4i b = repaint.bounds();
+            float ratio = m_pixel_ratio;
+            int x0 = std::max((int) std::floor(b[0] * ratio), 0),
+                y0 = std::max((int) std::floor(b[1] * ratio), 0),
+                x1 = std::min((int) std::ceil((b[0] + b[2]) * ratio), m_fbsize.x()),
+                y1 = std::min((int) std::ceil((b[1] + b[3]) * ratio), m_fbsize.y());
+
+            if (x1 > x0 && y1 > y0 &&
+                (int64_t) (x1 - x0) * (y1 - y0) < (int64_t) m_fbsize.x() * m_fbsize.y())
+                m_repaint_rect = Vector4i(x0, m_fbsize.y() - y1, x1 - x0, y1 - y0);
+        }
+    }
+
+    if (m_repaint_rect[2] >= 0) {
+        if (egl.set_damage_region)
+            egl.set_damage_region(egl.display, surface, &m_repaint_rect[0], 1);
+        CHK(glEnable(GL_SCISSOR_TEST));
+        CHK(glScissor(m_repaint_rect[0], m_repaint_rect[1],
+                      m_repaint_rect[2], m_repaint_rect[3]));
+    }
+    nvglScissorRectGLES3(m_nvg_context, m_repaint_rect[0], m_repaint_rect[1],
+                         m_repaint_rect[2], m_repaint_rect[3]);
+
+    m_damage_history.push_back(damage);
+    if (m_damage_history.size() > max_buffer_age)
+        m_damage_history.erase(m_damage_history.begin());
+    m_frame_damage = std::move(damage);
+}
+
 void Screen::draw_teardown() {
-    glfwSwapBuffers(m_glfw_window);
+    if (m_repaint_rect[2] >= 0) {
+        CHK(glDisable(GL_SCISSOR_TEST));
+        nvglScissorRectGLES3(m_nvg_context, 0, 0, -1, -1);
+    }
+
+    const EGLDamageSupport &egl = egl_damage_support();
+    const std::vector<Vector4i> &rects = m_frame_damage.rects();
+    bool full = rects.size() == 1 && rects[0] == Vector4i(0, 0, m_size.x(), m_size.y());
+
+    if (egl.swap_buffers_with_damage && !full && !rects.empty()) {
+        /* Tell the compositor which parts of the surface changed */
+        std::vector<EGLint> egl_rects;
+        egl_rects.reserve(rects.size() * 4);
+        for (const Vector4i &r : rects) {
+            int x0 = (int) std::floor(r[0] * m_pixel_ratio),
+                y0 = (int) std::floor(r[1] * m_pixel_ratio),
+                x1 = (int) std::ceil((r[0] + r[2]) * m_pixel_ratio),
+                y1 = (int) std::ceil((r[1] + r[3]) * m_pixel_ratio);
+            egl_rects.insert(egl_rects.end(), { x0, m_fbsize.y() - y1, x1 - x0, y1 - y0 });
+        }
+        egl.swap_buffers_with_damage(egl.display, glfwGetEGLSurface(m_glfw_window),
+                                     egl_rects.data(), (EGLint) rects.size());
+    } else {
+        glfwSwapBuffers(m_glfw_window);
+    }
 }
 
 void Screen::draw_all() {
-    if (m_redraw) {
-        m_redraw = false;
+    /* Deliver coalesced pointer input before deciding whether to draw */
+    flush_input_events();
+
+    /* Text drawn without glyphs rasterized in the meantime is drawn again */
+    if (glyphs_arrived(false))
+        m_redraw = true;
+
+    if (!m_redraw && m_damage.empty())
+        return;
+
+    double delay = m_frame_pacer.frame_delay();
+    if (delay > 0) {
+        /* Too early for another frame: the main loop will call draw_all()
+           again once this timer has fired */
+        if (!m_frame_timer)
+            m_frame_timer = add_timer((float) (delay * 1000), [this]() { m_frame_timer = 0; });
+        return;
+    }
+
+    /* Layout changes may move widgets anywhere on the screen */
+    if (update_pending_layout())
+        m_redraw = true;
+
+    /* Give glyphs in flight a moment to make it into this frame */
+    if (glyphs_arrived(true))
+        m_redraw = true;
+
+    bool full = m_redraw || !m_partial_redraw;
+    m_redraw = false;
+    m_frame_pacer.frame_started();
+
+    if (!m_frame_stats) {
         draw_setup();
+        begin_damage_frame(full);
         draw_contents();
         draw_widgets();
         draw_teardown();
+    } else {
+        FrameTiming &timing = m_frame_timing;
+        timing.flush = 0;
+
+        double t0 = glfwGetTime();
+        draw_setup();
+        begin_damage_frame(full);
+        double t1 = glfwGetTime();
+        draw_contents();
+        double t2 = glfwGetTime();
+        draw_widgets();
+        double t3 = glfwGetTime();
+        draw_teardown();
+        double t4 = glfwGetTime();
+
+        timing.setup = (t1 - t0) * 1000;
+        timing.contents = (t2 - t1) * 1000;
+        timing.widgets = (t3 - t2) * 1000 - timing.flush;
+        timing.swap = (t4 - t3) * 1000;
+        timing.total = (t4 - t0) * 1000;
+        timing.latency = m_first_event_time >= 0 ? (t4 - m_first_event_time) * 1000 : -1;
+        m_first_event_time = -1;
+
+        m_frame_stats->push(timing);
     }
+
+    glyph_rasterizer().submit();
+    m_frame_pacer.frame_presented();
+}
+
+bool Screen::glyphs_arrived(bool wait) {
+    GlyphRasterizer &rasterizer = glyph_rasterizer();
+    rasterizer.finish(wait);
+
+    /* Another screen of the group may have added the glyphs, so compare
+       counts rather than relying on the return value of finish() */
+    if (rasterizer.glyphs_added() == m_glyphs_added)
+        return false;
+    m_glyphs_added = rasterizer.glyphs_added();
+
+    /* Only text that was drawn without some glyph needs drawing again */
+    int placeholders = nvgGlyphPlaceholders(m_nvg_context);
+    if (placeholders == m_glyph_placeholders)
+        return false;
+    m_glyph_placeholders = placeholders;
+    return true;
+}
+
+bool Screen::set_background_glyphs(bool enabled) {
+    GlyphRasterizer &rasterizer = glyph_rasterizer();
+    if (!enabled) {
+        rasterizer.detach();
+        return true;
+    }
+    return rasterizer.attached() || rasterizer.attach(m_nvg_context);
+}
+
+int Screen::glyph_miss_stalls() const {
+    return m_nvg_context ? nvgGlyphStalls(m_nvg_context) : 0;
+}
+
+void Screen::add_damage(const Vector2i &pos, const Vector2i &size) {
+    /* Grow by a pixel to cover antialiased edges */
+    Vector2i p0 = max(pos - 1, Vector2i(0)),
+             p1 = min(pos + size + 1, m_size);
+    if (p1.x() <= p0.x() || p1.y() <= p0.y())
+        return;
+    m_damage.add(p0, p1 - p0);
+}
+
+void Screen::set_frame_pacing(FramePacer::Mode mode) {
+    m_frame_pacer.set_mode(mode);
+    if (!m_glfw_window)
+        return;
+
+    GLFWmonitor *monitor = glfwGetWindowMonitor(m_glfw_window);
+    if (!monitor)
+        monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode *video_mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    if (video_mode && video_mode->refreshRate > 0 && mode != FramePacer::Mode::Simulated)
+        m_frame_pacer.set_refresh_rate(video_mode->refreshRate);
+
+    GLFWwindow *current = glfwGetCurrentContext();
+    glfwMakeContextCurrent(m_glfw_window);
+    glfwSwapInterval(mode == FramePacer::Mode::VSync ? 1 : 0);
+    glfwMakeContextCurrent(current);
+}
+
+void Screen::set_frame_stats_enabled(bool enabled, size_t capacity) {
+    if (!enabled)
+        m_frame_stats.reset();
+    else if (!m_frame_stats || m_frame_stats->capacity() != capacity)
+        m_frame_stats.reset(new FrameStats(capacity));
+    m_first_event_time = m_event_time = -1;
+}
+
+void Screen::mark_input_event() {
+    /* Coalesced motion and scrolling keep the time of their first sample */
+    if (m_frame_stats && (m_pending_input == PendingInput::None || m_event_time < 0))
+        m_event_time = glfwGetTime();
+}
+
+void Screen::input_handled(bool redraw) {
+    if (!redraw)
+        return;
+    m_redraw = true;
+    /* Only events that lead to a frame count for its latency */
+    if (m_first_event_time < 0)
+        m_first_event_time = m_event_time;
 }
 
 void Screen::draw_contents() {
@@ -364,6 +658,7 @@ void Screen::nvg_flush() {
 
 void Screen::draw_widgets() {
     nvgBeginFrame(m_nvg_context, m_size[0], m_size[1], m_pixel_ratio);
+    m_layer_cache.new_frame();
 
     draw(m_nvg_context);
 
@@ -371,38 +666,16 @@ void Screen::draw_widgets() {
 
     if (elapsed > 0.5f) {
         /* Draw tooltips */
-        const Widget *widget = find_widget(m_mouse_pos);
+        const Widget *widget = hover_widget();
         if (widget && !widget->tooltip().empty()) {
-            int tooltip_width = 150;
-
-            float bounds[4];
-            nvgFontFace(m_nvg_context, "sans");
-            nvgFontSize(m_nvg_context, 15.0f);
-            nvgTextAlign(m_nvg_context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
-            nvgTextLineHeight(m_nvg_context, 1.1f);
-            Vector2i pos = widget->absolute_position() +
-                           Vector2i(widget->width() / 2, widget->height() + 10);
+            prepare_tooltip(widget);
+            const TooltipLayout &tt = m_tooltip;
+            const float *bounds = tt.bounds;
+            int h = tt.h;
 
-            nvgTextBounds(m_nvg_context, pos.x(), pos.y(),
-                          widget->tooltip().c_str(), nullptr, bounds);
-
-            int h = (bounds[2] - bounds[0]) / 2;
-            if (h > tooltip_width / 2) {
-                nvgTextAlign(m_nvg_context, NVG_ALIGN_CENTER | NVG_ALIGN_TOP);
-                nvgTextBoxBounds(m_nvg_context, pos.x(), pos.y(), tooltip_width,
-                                widget->tooltip().c_str(), nullptr, bounds);
-
-                h = (bounds[2] - bounds[0]) / 2;
-            }
-            int shift = 0;
-
-            if (pos.x() - h - 8 < 0) {
-                /* Keep tooltips on screen */
-                shift = pos.x() - h - 8;
-                pos.x() -= shift;
-                bounds[0] -= shift;
-                bounds[2] -= shift;
-            }
+            /* Keep drawing frames until the fade-in is complete */
+            if (elapsed < 1.0)
+                update_tooltip_timer();
 
             nvgGlobalAlpha(m_nvg_context,
                            std::min(1.0, 2 * (elapsed - 0.5f)) * 0.8);
@@ -413,20 +686,31 @@ void Screen::draw_widgets() {
                            (int) (bounds[2] - bounds[0]) + 8,
                            (int) (bounds[3] - bounds[1]) + 8, 3);
 
-            int px = (int) ((bounds[2] + bounds[0]) / 2) - h + shift;
+            int px = (int) ((bounds[2] + bounds[0]) / 2) - h + tt.shift;
             nvgMoveTo(m_nvg_context, px, bounds[1] - 10);
             nvgLineTo(m_nvg_context, px + 7, bounds[1] + 1);
             nvgLineTo(m_nvg_context, px - 7, bounds[1] + 1);
             nvgFill(m_nvg_context);
 
             nvgFillColor(m_nvg_context, Color(255, 255));
+            nvgFontFace(m_nvg_context, "sans");
+            nvgFontSize(m_nvg_context, 15.0f);
             nvgFontBlur(m_nvg_context, 0.0f);
-            nvgTextBox(m_nvg_context, pos.x() - h, pos.y(), tooltip_width,
-                       widget->tooltip().c_str(), nullptr);
+            nvgTextAlign(m_nvg_context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            const char *text = tt.text.c_str();
+            for (const TooltipLayout::Row &row : tt.rows)
+                nvgText(m_nvg_context, row.x, row.y, text + row.begin,
+                        text + row.end);
         }
     }
 
-    nvgEndFrame(m_nvg_context);
+    if (m_frame_stats) {
+        double t0 = glfwGetTime();
+        nvgEndFrame(m_nvg_context);
+        m_frame_timing.flush = (glfwGetTime() - t0) * 1000;
+    } else {
+        nvgEndFrame(m_nvg_context);
+    }
 }
 
 bool Screen::keyboard_event(int key, int scancode, int action, int modifiers) {
@@ -466,38 +750,100 @@ void Screen::redraw() {
 void Screen::cursor_pos_callback_event(double x, double y) {
     Vector2i p((int) x, (int) y);
 
-    p = Vector2i(Vector2f(p) / m_pixel_ratio);
+    p = Vector2i(Vector2f(p) / m_pixel_ratio) - Vector2i(1, 2);
 
     m_last_interaction = glfwGetTime();
-    try {
-        p -= Vector2i(1, 2);
-
-        bool ret = false;
-        if (!m_drag_active) {
-            Widget *widget = find_widget(p);
-            if (widget != nullptr && widget->cursor() != m_cursor) {
-                m_cursor = widget->cursor();
-                glfwSetCursor(m_glfw_window, m_cursors[(int) m_cursor]);
-            }
-        } else {
-            ret = m_drag_widget->mouse_drag_event(
-                p - m_drag_widget->parent()->absolute_position(), p - m_mouse_pos,
-                m_mouse_state, m_modifiers);
-        }
+    update_tooltip_timer();
+
+    /* Merge with preceding motion samples; the combined event is dispatched
+       before the next non-motion event or frame, whichever comes first */
+    if (m_pending_input == PendingInput::Scroll)
+        flush_input_events();
+    mark_input_event();
+    m_pending_input = PendingInput::Motion;
+    m_motion_history.push_back(p);
+
+    if (!m_coalesce_input)
+        flush_input_events();
+}
 
-        if (!ret)
-            ret = mouse_motion_event(p, p - m_mouse_pos, m_mouse_state, m_modifiers);
+void Screen::invalidate_input_targets() {
+    /* Events are delivered along the focus path or to the widget under the
+       cursor; conservatively discard their recorded NanoVG output */
+    if (m_drag_widget)
+        m_drag_widget->invalidate_display_list();
+    if (!m_focus_path.empty())
+        m_focus_path.front()->invalidate_display_list();
+    Widget *widget = find_widget(m_mouse_pos);
+    if (widget)
+        widget->invalidate_display_list();
+}
 
-        m_mouse_pos = p;
-        m_redraw |= ret;
+void Screen::flush_input_events() {
+    PendingInput pending = m_pending_input;
+    m_pending_input = PendingInput::None;
+
+    try {
+        if (pending == PendingInput::Motion)
+            dispatch_motion(m_motion_history.back());
+        else if (pending == PendingInput::Scroll)
+            dispatch_scroll(m_pending_scroll);
     } catch (const std::exception &e) {
         std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
+
+    m_motion_history.clear();
+    m_pending_scroll = Vector2f(0.f);
+}
+
+void Screen::dispatch_motion(const Vector2i &p) {
+    bool ret = false;
+    if (!m_drag_active) {
+        Widget *widget = find_widget(p);
+        /* Track the widget under the cursor for tooltips as a byproduct */
+        m_hover_widget = widget;
+        m_hover_stale = false;
+        if (widget != nullptr && widget->cursor() != m_cursor) {
+            m_cursor = widget->cursor();
+            glfwSetCursor(m_glfw_window, m_cursors[(int) m_cursor]);
+        }
+    } else {
+        m_hover_stale = true;
+        Vector2i pos = m_drag_widget->position();
+        ret = m_drag_widget->mouse_drag_event(
+            p - m_drag_widget->parent()->absolute_position(), p - m_mouse_pos,
+            m_mouse_state, m_modifiers);
+
+        /* Dragging a window only moves it, which keeps its recorded NanoVG
+           output and layer valid */
+        if (ret && m_drag_widget->position() != pos &&
+            dynamic_cast<Window *>(m_drag_widget)) {
+            m_drag_widget->parent()->invalidate_display_list();
+            m_mouse_pos = p;
+            input_handled(true);
+            return;
+        }
+    }
+
+    if (!ret)
+        ret = mouse_motion_event(p, p - m_mouse_pos, m_mouse_state, m_modifiers);
+
+    m_mouse_pos = p;
+    if (ret) {
+        /* The handler may have changed what lies under the cursor */
+        m_hover_stale = true;
+        invalidate_input_targets();
+    }
+    input_handled(ret);
 }
 
 void Screen::mouse_button_callback_event(int button, int action, int modifiers) {
+    flush_input_events();
     m_modifiers = modifiers;
     m_last_interaction = glfwGetTime();
+    m_hover_stale = true;
+    mark_input_event();
+    update_tooltip_timer();
 
     #if defined(__APPLE__)
         if (button == GLFW_MOUSE_BUTTON_1 && modifiers == GLFW_MOD_CONTROL)
@@ -522,9 +868,10 @@ void Screen::mouse_button_callback_event(int button, int action, int modifiers)
         auto drop_widget = find_widget(m_mouse_pos);
         if (m_drag_active && action == GLFW_RELEASE &&
             drop_widget != m_drag_widget) {
-            m_redraw |= m_drag_widget->mouse_button_event(
+            m_drag_widget->invalidate_display_list();
+            input_handled(m_drag_widget->mouse_button_event(
                 m_mouse_pos - m_drag_widget->parent()->absolute_position(), button,
-                false, m_modifiers);
+                false, m_modifiers));
         }
 
         if (drop_widget != nullptr && drop_widget->cursor() != m_cursor) {
@@ -546,56 +893,93 @@ void Screen::mouse_button_callback_event(int button, int action, int modifiers)
             m_drag_widget = nullptr;
         }
 
-        m_redraw |= mouse_button_event(m_mouse_pos, button,
-                                       action == GLFW_PRESS, m_modifiers);
+        bool ret = mouse_button_event(m_mouse_pos, button,
+                                      action == GLFW_PRESS, m_modifiers);
+        if (ret)
+            invalidate_input_targets();
+        input_handled(ret);
     } catch (const std::exception &e) {
         std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
 }
 
 void Screen::key_callback_event(int key, int scancode, int action, int mods) {
+    flush_input_events();
     m_last_interaction = glfwGetTime();
+    m_hover_stale = true;
+    mark_input_event();
+    update_tooltip_timer();
     try {
-        m_redraw |= keyboard_event(key, scancode, action, mods);
+        bool ret = keyboard_event(key, scancode, action, mods);
+        if (ret)
+            invalidate_input_targets();
+        input_handled(ret);
     } catch (const std::exception &e) {
         std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
 }
 
 void Screen::char_callback_event(unsigned int codepoint) {
+    flush_input_events();
     m_last_interaction = glfwGetTime();
+    m_hover_stale = true;
+    mark_input_event();
+    update_tooltip_timer();
     try {
-        m_redraw |= keyboard_character_event(codepoint);
+        bool ret = keyboard_character_event(codepoint);
+        if (ret)
+            invalidate_input_targets();
+        input_handled(ret);
     } catch (const std::exception &e) {
         std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
 }
 
 void Screen::drop_callback_event(int count, const char **filenames) {
+    flush_input_events();
     std::vector<std::string> arg(count);
     for (int i = 0; i < count; ++i)
         arg[i] = filenames[i];
-    m_redraw |= drop_event(arg);
+    mark_input_event();
+    m_hover_stale = true;
+    bool ret = drop_event(arg);
+    if (ret)
+        invalidate_input_targets();
+    input_handled(ret);
 }
 
 void Screen::scroll_callback_event(double x, double y) {
     m_last_interaction = glfwGetTime();
-    try {
-        if (m_focus_path.size() > 1) {
-            const Window *window =
-                dynamic_cast<Window *>(m_focus_path[m_focus_path.size() - 2]);
-            if (window && window->modal()) {
-                if (!window->contains(m_mouse_pos))
-                    return;
-            }
+    m_hover_stale = true;
+    update_tooltip_timer();
+
+    if (m_pending_input == PendingInput::Motion)
+        flush_input_events();
+    mark_input_event();
+    m_pending_input = PendingInput::Scroll;
+    m_pending_scroll += Vector2f((float) x, (float) y);
+
+    if (!m_coalesce_input)
+        flush_input_events();
+}
+
+void Screen::dispatch_scroll(const Vector2f &rel) {
+    if (m_focus_path.size() > 1) {
+        const Window *window =
+            dynamic_cast<Window *>(m_focus_path[m_focus_path.size() - 2]);
+        if (window && window->modal()) {
+            if (!window->contains(m_mouse_pos))
+                return;
         }
-        m_redraw |= scroll_event(m_mouse_pos, Vector2f(x, y));
-    } catch (const std::exception &e) {
-        std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
+    bool ret = scroll_event(m_mouse_pos, rel);
+    if (ret)
+        invalidate_input_targets();
+    input_handled(ret);
 }
 
 void Screen::resize_callback_event(int, int) {
+    flush_input_events();
     Vector2i fb_size, size;
     glfwGetFramebufferSize(m_glfw_window, &fb_size[0], &fb_size[1]);
     glfwGetWindowSize(m_glfw_window, &size[0], &size[1]);
@@ -606,12 +990,15 @@ void Screen::resize_callback_event(int, int) {
     m_size = Vector2i(Vector2f(m_size) / m_pixel_ratio);
 
     m_last_interaction = glfwGetTime();
+    m_hover_stale = true;
+    mark_input_event();
 
     try {
         resize_event(m_size);
     } catch (const std::exception &e) {
         std::cerr << "Caught exception in event handler: " << e.what() << std::endl;
     }
+    input_handled(true);
     redraw();
 }
 
@@ -644,9 +1031,34 @@ void Screen::dispose_window(Window *window) {
     remove_child(window);
 }
 
+void Screen::perform_layout() {
+    /* Measure everything again, e.g. after the theme was modified in place */
+    reset_layout();
+    perform_layout(m_nvg_context);
+}
+
+bool Screen::update_pending_layout() {
+    if (!m_layout_dirty)
+        return false;
+    m_layout_dirty = false;
+
+    /* Windows keep their size; only those laid out before are updated */
+    bool changed = false;
+    for (size_t i = 0; i < m_children.size(); ++i) {
+        Widget *child = m_children[i];
+        if (child->m_laid_out && child->m_layout_dirty) {
+            child->update_layout(m_nvg_context);
+            changed = true;
+        }
+    }
+    if (changed)
+        m_hover_stale = true;
+    return changed;
+}
+
 void Screen::center_window(Window *window) {
     if (window->size() == 0) {
-        window->set_size(window->preferred_size(m_nvg_context));
+        window->set_size(window->cached_preferred_size(m_nvg_context));
         window->perform_layout(m_nvg_context);
     }
     window->set_position((m_size - window->size()) / 2);
@@ -655,6 +1067,7 @@ void Screen::center_window(Window *window) {
 void Screen::move_window_to_front(Window *window) {
     m_children.erase(std::remove(m_children.begin(), m_children.end(), window), m_children.end());
     m_children.push_back(window);
+    m_spatial_index_valid = false;
     /* Brute force topological sort (no problem for a few windows..) */
     bool changed = false;
     do {
@@ -674,13 +1087,110 @@ void Screen::move_window_to_front(Window *window) {
     } while (changed);
 }
 
+void Screen::update_tooltip_timer() {
+    if (m_tooltip_timer)
+        remove_timer(m_tooltip_timer);
+
+    double elapsed = glfwGetTime() - m_last_interaction;
+    float delay = elapsed < 0.5 ? (float) (0.5 - elapsed) * 1000.f : 1000.f / 60.f;
+
+    m_tooltip_timer = add_timer(delay, [this]() {
+        m_tooltip_timer = 0;
+        const Widget *widget = hover_widget();
+        if (widget && !widget->tooltip().empty())
+            redraw();
+    });
+}
+
 bool Screen::tooltip_fade_in_progress() const {
     double elapsed = glfwGetTime() - m_last_interaction;
     if (elapsed < 0.25f || elapsed > 1.25f)
         return false;
-    /* Temporarily increase the frame rate to fade in the tooltip */
-    const Widget *widget = find_widget(m_mouse_pos);
-    return widget && !widget->tooltip().empty();
+    /* Temporarily increase the frame rate to fade in the tooltip. This only
+       consults the cached hover state and never walks the widget tree */
+    return !m_hover_stale && m_hover_widget &&
+           m_hover_widget->visible() && !m_hover_widget->tooltip().empty();
+}
+
+const Widget *Screen::hover_widget() {
+    if (m_hover_stale) {
+        m_hover_widget = find_widget(m_mouse_pos);
+        m_hover_stale = false;
+    }
+
+    /* Removals mark the widget stale, but it may have been hidden since */
+    const Widget *widget = m_hover_widget;
+    while (widget && widget != this && widget->visible())
+        widget = widget->parent();
+
+    return widget == this ? m_hover_widget : nullptr;
+}
+
+void Screen::prepare_tooltip(const Widget *widget) {
+    Vector2i pos = widget->absolute_position() +
+                   Vector2i(widget->width() / 2, widget->height() + 10);
+
+    TooltipLayout &tt = m_tooltip;
+    if (tt.widget == widget && tt.anchor == pos &&
+        tt.pixel_ratio == m_pixel_ratio && tt.text == widget->tooltip())
+        return;
+
+    tt.widget = widget;
+    tt.text = widget->tooltip();
+    tt.anchor = pos;
+    tt.pixel_ratio = m_pixel_ratio;
+    tt.rows.clear();
+
+    const int tooltip_width = 150;
+    const char *text = tt.text.c_str(), *end = text + tt.text.size();
+    float *bounds = tt.bounds;
+
+    nvgSave(m_nvg_context);
+    nvgFontFace(m_nvg_context, "sans");
+    nvgFontSize(m_nvg_context, 15.0f);
+    nvgTextAlign(m_nvg_context, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    nvgTextLineHeight(m_nvg_context, 1.1f);
+
+    nvgTextBounds(m_nvg_context, pos.x(), pos.y(), text, end, bounds);
+
+    int h = (bounds[2] - bounds[0]) / 2;
+    bool centered = h > tooltip_width / 2;
+    if (centered) {
+        nvgTextAlign(m_nvg_context, NVG_ALIGN_CENTER | NVG_ALIGN_TOP);
+        nvgTextBoxBounds(m_nvg_context, pos.x(), pos.y(), tooltip_width,
+                         text, end, bounds);
+
+        h = (bounds[2] - bounds[0]) / 2;
+    }
+    int shift = 0;
+
+    if (pos.x() - h - 8 < 0) {
+        /* Keep tooltips on screen */
+        shift = pos.x() - h - 8;
+        pos.x() -= shift;
+        bounds[0] -= shift;
+        bounds[2] -= shift;
+    }
+    tt.h = h;
+    tt.shift = shift;
+
+    /* Break the text into rows the way nvgTextBox() would, so that drawing
+       the tooltip only has to emit the glyphs */
+    float lineh = 0.f, x = (float) (pos.x() - h), y = (float) pos.y();
+    nvgTextMetrics(m_nvg_context, nullptr, nullptr, &lineh);
+    NVGtextRow rows[4];
+    int nrows;
+    while ((nrows = nvgTextBreakLines(m_nvg_context, text, end, tooltip_width,
+                                      rows, 4)) > 0) {
+        for (int i = 0; i < nrows; ++i) {
+            float rx = centered ? x + tooltip_width * .5f - rows[i].width * .5f : x;
+            tt.rows.push_back({ (size_t) (rows[i].start - tt.text.c_str()),
+                                (size_t) (rows[i].end - tt.text.c_str()), rx, y });
+            y += lineh * 1.1f;
+        }
+        text = rows[nrows - 1].next;
+    }
+    nvgRestore(m_nvg_context);
 }
 
 Texture::PixelFormat Screen::pixel_format() const {
@@ -23,4 +23,19 @@ std::string Shader::Buffer::to_string() const {
     return result;
 }
 
+Shader::Handle Shader::handle(const std::string &name) const {
+    auto it = m_handles.find(name);
+    if (it == m_handles.end())
+        throw std::runtime_error(
+            "Shader::handle(): could not find argument named \"" + name + "\"");
+    return Handle(it->second);
+}
+
+Shader::Buffer &Shader::buffer(Handle handle, const char *method) {
+    if (handle.m_index >= m_buffers.size())
+        throw std::runtime_error(std::string("Shader::") + method +
+                                 "(): invalid handle for shader \"" + m_name + "\"");
+    return m_buffers[handle.m_index];
+}
+
 NAMESPACE_END(waylandgui)
@@ -90,14 +90,16 @@ Shader::Shader(RenderPass *render_pass,
 
     auto register_buffer = [&](BufferType type, const std::string &name,
                                int index, GLenum gl_type) {
-        if (m_buffers.find(name) != m_buffers.end())
+        if (m_handles.find(name) != m_handles.end())
             throw std::runtime_error(
                 "Shader::Shader(): duplicate attribute/uniform name in shader code!");
         else if (name == "indices")
             throw std::runtime_error(
                 "Shader::Shader(): argument name 'indices' is reserved!");
 
-        Buffer &buf = m_buffers[name];
+        m_handles[name] = (uint32_t) m_buffers.size();
+        Buffer &buf = m_buffers.emplace_back();
+        buf.name = name;
         for (int i = 0; i < 3; ++i)
             buf.shape[i] = 1;
         buf.ndim = 1;
@@ -223,7 +225,9 @@ Shader::Shader(RenderPass *render_pass,
         register_buffer(UniformBuffer, uniform_name, index, type);
     }
 
-    Buffer &buf = m_buffers["indices"];
+    m_handles["indices"] = (uint32_t) m_buffers.size();
+    Buffer &buf = m_buffers.emplace_back();
+    buf.name = "indices";
     buf.index = -1;
     buf.ndim = 1;
     buf.shape[0] = 0;
@@ -242,12 +246,20 @@ void Shader::set_buffer(const std::string &name,
                         size_t ndim,
                         const size_t *shape,
                         const void *data) {
-    auto it = m_buffers.find(name);
-    if (it == m_buffers.end())
+    auto it = m_handles.find(name);
+    if (it == m_handles.end())
         throw std::runtime_error(
             "Shader::set_buffer(): could not find argument named \"" + name + "\"");
 
-    Buffer &buf = m_buffers[name];
+    set_buffer(Handle(it->second), dtype, ndim, shape, data);
+}
+
+void Shader::set_buffer(Handle handle,
+                        VariableType dtype,
+                        size_t ndim,
+                        const size_t *shape,
+                        const void *data) {
+    Buffer &buf = buffer(handle, "set_buffer");
 
     bool mismatch = ndim != buf.ndim || dtype != buf.dtype;
     for (size_t i = (buf.type == UniformBuffer ? 0 : 1); i < ndim; ++i)
@@ -260,16 +272,22 @@ void Shader::set_buffer(const std::string &name,
         for (size_t i = 0; i < 3; ++i)
             arg.shape[i] = i < arg.ndim ? shape[i] : 1;
         arg.dtype = dtype;
-        throw std::runtime_error("Buffer::set_buffer(\"" + name +
+        throw std::runtime_error("Buffer::set_buffer(\"" + buf.name +
                                  "\"): shape/dtype mismatch: expected " + buf.to_string() +
                                  ", got " + arg.to_string());
     }
 
     size_t size = type_size(dtype);
-    for (size_t i = 0; i < 3; ++i) {
+    for (size_t i = 0; i < ndim; ++i)
+        size *= shape[i];
+
+    /* The program keeps the value that begin() uploaded last */
+    if (buf.type == UniformBuffer && buf.buffer && buf.size == size &&
+        memcmp(buf.buffer, data, size) == 0)
+        return;
+
+    for (size_t i = 0; i < 3; ++i)
         buf.shape[i] = i < ndim ? shape[i] : 1;
-        size *= buf.shape[i];
-    }
 
     if (buf.type == UniformBuffer) {
         if (buf.buffer && buf.size != size) {
@@ -287,7 +305,7 @@ void Shader::set_buffer(const std::string &name,
             CHK(glGenBuffers(1, &buffer_id));
             buf.buffer = (void *) ((uintptr_t) buffer_id);
         }
-        GLenum buf_type = (name == "indices")
+        GLenum buf_type = (buf.type == IndexBuffer)
             ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
         CHK(glBindBuffer(buf_type, buffer_id));
         CHK(glBufferData(buf_type, size, data, GL_DYNAMIC_DRAW));
@@ -300,14 +318,18 @@ void Shader::set_buffer(const std::string &name,
 }
 
 void Shader::set_texture(const std::string &name, Texture *texture) {
-    auto it = m_buffers.find(name);
-    if (it == m_buffers.end())
+    auto it = m_handles.find(name);
+    if (it == m_handles.end())
         throw std::runtime_error(
             "Shader::set_texture(): could not find argument named \"" + name + "\"");
-    Buffer &buf = m_buffers[name];
+    set_texture(Handle(it->second), texture);
+}
+
+void Shader::set_texture(Handle handle, Texture *texture) {
+    Buffer &buf = buffer(handle, "set_texture");
     if (!(buf.type == VertexTexture || buf.type == FragmentTexture))
         throw std::runtime_error(
-            "Shader::set_texture(): argument named \"" + name + "\" is not a texture!");
+            "Shader::set_texture(): argument named \"" + buf.name + "\" is not a texture!");
 
     buf.buffer = (void *) ((uintptr_t) texture->texture_handle());
     buf.dirty  = true;
@@ -318,14 +340,13 @@ void Shader::begin() {
 
     CHK(glUseProgram(m_shader_handle));
 
-    for (auto &[key, buf] : m_buffers) {
-        bool indices = key == "indices";
+    for (Buffer &buf : m_buffers) {
         if (!buf.buffer) {
-            if (!indices)
+            if (buf.type != IndexBuffer)
                 fprintf(stderr,
                         "Shader::begin(): shader \"%s\" has an unbound "
                         "argument \"%s\"!\n",
-                        m_name.c_str(), key.c_str());
+                        m_name.c_str(), buf.name.c_str());
             continue;
         }
 
@@ -357,7 +378,7 @@ void Shader::begin() {
                 }
 
                 if (buf.ndim != 2)
-                    throw std::runtime_error("\"" + m_name + "\": vertex attribute \"" + key +
+                    throw std::runtime_error("\"" + m_name + "\": vertex attribute \"" + buf.name +
                                              "\" has an invalid shapeension (expected ndim=2, got " +
                                              std::to_string(buf.ndim) + ")");
 
@@ -375,8 +396,10 @@ void Shader::begin() {
                 break;
 
             case UniformBuffer:
+                if (!buf.dirty)
+                    break;
                 if (buf.ndim > 2)
-                    throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + key +
+                    throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + buf.name +
                                              "\" has an invalid shapeension (expected ndim=0/1/2, got " +
                                              std::to_string(buf.ndim) + ")");
                 switch (buf.dtype) {
@@ -442,12 +465,12 @@ void Shader::begin() {
                 }
 
                 if (uniform_error)
-                    throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + key +
+                    throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + buf.name +
                                              "\" has an unsupported dtype/shape configuration: " + buf.to_string());
                 break;
 
             default:
-                throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + key +
+                throw std::runtime_error("\"" + m_name + "\": uniform attribute \"" + buf.name +
                                          "\" has an unsupported dtype/shape configuration:" + buf.to_string());
         }
 
@@ -464,7 +487,7 @@ void Shader::end() {
     if (m_blend_mode == BlendMode::AlphaBlend)
         CHK(glDisable(GL_BLEND));
     
-    for (const auto &[key, buf] : m_buffers) {
+    for (const Buffer &buf : m_buffers) {
         if (buf.type != VertexBuffer)
             continue;
         CHK(glDisableVertexAttribArray(buf.index));
@@ -0,0 +1,124 @@
+/*
+    src/spatialindex.cpp -- Uniform grid over the children of a widget that
+    speeds up hit-testing
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/spatialindex.h>
+#include <waylandgui/widget.h>
+#include <climits>
+#include <cmath>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/// Children that can be hit (the others are not entered into the grid)
+static bool hittable(const Widget *child) {
+    return child->visible() && child->width() > 0 && child->height() > 0;
+}
+
+void SpatialIndex::build(const std::vector<Widget *> &children) {
+    m_offsets.clear();
+    m_items.clear();
+    m_cells = Vector2i(0);
+
+    Vector2i lo(INT_MAX), hi(INT_MIN);
+    size_t count = 0;
+    for (const Widget *child : children) {
+        if (!hittable(child))
+            continue;
+        lo = min(lo, child->position());
+        hi = max(hi, child->position() + child->size());
+        count++;
+    }
+    if (count == 0)
+        return;
+
+    /* Aim for about one child per cell, with cells of the same aspect ratio
+       as the bounding box */
+    Vector2i extent = hi - lo;
+    double aspect = (double) extent.x() / (double) extent.y();
+    Vector2i grid(
+        std::max(1, std::min(extent.x(), (int) std::ceil(std::sqrt(count * aspect)))),
+        std::max(1, std::min(extent.y(), (int) std::ceil(std::sqrt(count / aspect)))));
+
+    /* Large, overlapping children (e.g. a background panel) are entered into
+       every cell they cover; coarsen the grid if that gets out of hand */
+    Vector2i cell_size;
+    size_t entries;
+    while (true) {
+        cell_size = Vector2i((extent.x() + grid.x() - 1) / grid.x(),
+                             (extent.y() + grid.y() - 1) / grid.y());
+        entries = 0;
+        for (const Widget *child : children) {
+            if (!hittable(child))
+                continue;
+            Vector2i c0 = child->position() - lo,
+                     c1 = child->position() + child->size() - 1 - lo;
+            entries += (size_t) (c1.x() / cell_size.x() - c0.x() / cell_size.x() + 1) *
+                       (size_t) (c1.y() / cell_size.y() - c0.y() / cell_size.y() + 1);
+        }
+        if (entries <= 4 * count || (grid.x() == 1 && grid.y() == 1))
+            break;
+        grid = Vector2i(std::max(1, grid.x() / 2), std::max(1, grid.y() / 2));
+    }
+
+    m_origin = lo;
+    m_cell_size = cell_size;
+    m_cells = Vector2i((extent.x() + cell_size.x() - 1) / cell_size.x(),
+                       (extent.y() + cell_size.y() - 1) / cell_size.y());
+    size_t cells = (size_t) m_cells.x() * (size_t) m_cells.y();
+
+    /* Two passes: count the entries of each cell, then fill them in. Visiting
+       the children in order keeps the entries of each cell sorted */
+    m_offsets.assign(cells + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            for (size_t i = 0; i < cells; ++i)
+                m_offsets[i + 1] += m_offsets[i];
+            m_items.resize(entries);
+        }
+        for (size_t i = 0; i < children.size(); ++i) {
+            const Widget *child = children[i];
+            if (!hittable(child))
+                continue;
+            Vector2i c0 = child->position() - lo,
+                     c1 = child->position() + child->size() - 1 - lo;
+            int x0 = c0.x() / cell_size.x(), x1 = c1.x() / cell_size.x(),
+                y0 = c0.y() / cell_size.y(), y1 = c1.y() / cell_size.y();
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    size_t cell = (size_t) y * m_cells.x() + x;
+                    if (pass == 0)
+                        m_offsets[cell + 1]++;
+                    else
+                        m_items[m_offsets[cell]++] = (uint32_t) i;
+                }
+            }
+        }
+    }
+
+    /* The fill pass advanced each offset to the start of the next cell */
+    for (size_t i = cells; i > 0; --i)
+        m_offsets[i] = m_offsets[i - 1];
+    m_offsets[0] = 0;
+}
+
+SpatialIndex::Range SpatialIndex::query(const Vector2i &p) const {
+    Vector2i d = p - m_origin;
+    if (d.x() < 0 || d.y() < 0)
+        return { nullptr, nullptr };
+    int x = d.x() / m_cell_size.x(), y = d.y() / m_cell_size.y();
+    if (x >= m_cells.x() || y >= m_cells.y())
+        return { nullptr, nullptr };
+    size_t cell = (size_t) y * m_cells.x() + x;
+    const uint32_t *items = m_items.data();
+    return { items + m_offsets[cell], items + m_offsets[cell + 1] };
+}
+
+NAMESPACE_END(waylandgui)
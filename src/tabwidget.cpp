@@ -30,9 +30,12 @@ void TabWidgetBase::remove_tab(int id) {
     int index = tab_index(id);
     bool close_active = index == m_active_tab;
     m_tab_captions.erase(m_tab_captions.begin() + index);
+    if (index < (int) m_tab_layouts.size())
+        m_tab_layouts.erase(m_tab_layouts.begin() + index);
     m_tab_ids.erase(m_tab_ids.begin() + index);
     if (index <= m_active_tab)
         m_active_tab = std::max(0, m_active_tab - 1);
+    invalidate_layout();
     TabWidgetBase::perform_layout(screen()->nvg_context());
     if (m_close_callback)
         m_close_callback(id);
@@ -45,7 +48,10 @@ void TabWidgetBase::remove_tab(int id) {
 int TabWidgetBase::insert_tab(int index, const std::string &caption) {
     int id = m_tab_counter++;
     m_tab_captions.insert(m_tab_captions.begin() + index, caption);
+    if (index <= (int) m_tab_layouts.size())
+        m_tab_layouts.insert(m_tab_layouts.begin() + index, TextLayout());
     m_tab_ids.insert(m_tab_ids.begin() + index, id);
+    invalidate_layout();
     TabWidgetBase::perform_layout(screen()->nvg_context());
     if (index < m_active_tab)
         m_active_tab++;
@@ -71,38 +77,33 @@ int TabWidgetBase::tab_index(int id) const {
 
 void TabWidgetBase::update_visibility() { /* No-op */ }
 
+const TextLayout &TabWidgetBase::tab_layout(NVGcontext *ctx, size_t index) const {
+    if (m_tab_layouts.size() != m_tab_captions.size())
+        m_tab_layouts.resize(m_tab_captions.size());
+    m_tab_layouts[index].update(ctx, m_tab_captions[index], m_font, font_size());
+    return m_tab_layouts[index];
+}
+
 void TabWidgetBase::perform_layout(NVGcontext* ctx) {
-    m_tab_offsets.clear();
-    nvgFontFace(ctx, m_font.c_str());
-    nvgFontSize(ctx, font_size());
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    m_close_layout.update(ctx, utf8(FA_TIMES_CIRCLE), "icons", font_size());
+    m_close_width = m_close_layout.advance();
 
     m_tab_offsets.clear();
     int width = 0;
-    float unused[4];
-    for (const std::string &label : m_tab_captions) {
-        int label_width = nvgTextBounds(ctx, 0, 0, label.c_str(), nullptr, unused);
+    for (size_t i = 0; i < m_tab_captions.size(); ++i) {
+        int label_width = tab_layout(ctx, i).advance();
         m_tab_offsets.push_back(width);
         width += label_width + 2 * m_theme->m_tab_button_horizontal_padding;
         if (m_tabs_closeable)
             width += m_close_width;
     }
     m_tab_offsets.push_back(width);
-
-    nvgFontFace(ctx, "icons");
-    m_close_width =
-        nvgTextBounds(ctx, 0, 0, utf8(FA_TIMES_CIRCLE).data(), nullptr, unused);
 }
 
 Vector2i TabWidgetBase::preferred_size(NVGcontext* ctx) const {
-    nvgFontFace(ctx, m_font.c_str());
-    nvgFontSize(ctx, font_size());
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
-
     int width = 0;
-    for (const std::string &label : m_tab_captions) {
-        float unused[4];
-        int label_width = nvgTextBounds(ctx, 0, 0, label.c_str(), nullptr, unused);
+    for (size_t i = 0; i < m_tab_captions.size(); ++i) {
+        int label_width = tab_layout(ctx, i).advance();
         width += label_width + 2 * m_theme->m_tab_button_horizontal_padding;
         if (m_tabs_closeable)
             width += m_close_width;
@@ -134,8 +135,6 @@ void TabWidgetBase::draw(NVGcontext* ctx) {
 
     nvgSave(ctx);
     nvgIntersectScissor(ctx, m_pos.x(), m_pos.y(), m_size.x(), tab_height);
-    nvgFontSize(ctx, font_size());
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
     for (size_t i = 0; i< m_tab_captions.size(); ++i) {
         int x_pos = m_pos.x() + m_tab_offsets[i],
             y_pos = m_pos.y(),
@@ -167,9 +166,7 @@ void TabWidgetBase::draw(NVGcontext* ctx) {
         x_pos += m_theme->m_tab_button_horizontal_padding;
         y_pos += m_theme->m_tab_button_vertical_padding + 1;
         nvgFillColor(ctx, m_theme->m_text_color);
-        nvgFontFace(ctx, m_font.c_str());
-
-        nvgText(ctx, x_pos, y_pos, m_tab_captions[i].c_str(), nullptr);
+        tab_layout(ctx, i).draw(ctx, x_pos, y_pos, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
 
         if (m_tabs_closeable) {
             x_pos = m_pos.x() + m_tab_offsets[i + 1] -
@@ -183,8 +180,8 @@ void TabWidgetBase::draw(NVGcontext* ctx) {
                   offset_x = highlight ? 0.f : (fs * .40f),
                   offset_y = highlight ? 0.f : (fs * .21f);
             nvgFontSize(ctx, fs);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
             nvgText(ctx, x_pos + offset_x, y_pos + offset_y + .5f, utf8(icon).data(), nullptr);
-            nvgFontSize(ctx, font_size());
         }
     }
     if (m_tab_drag_index != -1 && m_tab_drag_start != m_tab_drag_end) {
@@ -348,6 +345,8 @@ bool TabWidgetBase::mouse_motion_event(const Vector2i &p, const Vector2i &rel,
             if ((m_tab_drag_index < index && p.x() - m_pos.y() > mid) ||
                 (m_tab_drag_index > index && p.x() - m_pos.y() < mid)) {
                 std::swap(m_tab_captions[index], m_tab_captions[m_tab_drag_index]);
+                if (m_tab_layouts.size() == m_tab_captions.size())
+                    std::swap(m_tab_layouts[index], m_tab_layouts[m_tab_drag_index]);
                 std::swap(m_tab_ids[index], m_tab_ids[m_tab_drag_index]);
                 TabWidgetBase::perform_layout(screen()->nvg_context());
                 m_tab_drag_index = index;
@@ -380,7 +379,7 @@ void TabWidget::perform_layout(NVGcontext* ctx) {
     for (Widget *child : m_children) {
         child->set_position(Vector2i(m_padding, m_padding + tab_height + 1));
         child->set_size(m_size - Vector2i(2*m_padding, 2*m_padding + tab_height + 1));
-        child->perform_layout(ctx);
+        child->update_layout(ctx);
     }
 }
 
@@ -398,7 +397,7 @@ Vector2i TabWidget::preferred_size(NVGcontext* ctx) const {
     Vector2i base_size = TabWidgetBase::preferred_size(ctx),
              content_size = Vector2i(0);
     for (Widget *child : m_children)
-        content_size = max(content_size, child->preferred_size(ctx));
+        content_size = max(content_size, child->cached_preferred_size(ctx));
 
     return Vector2i(
         std::max(base_size.x(), content_size.x() + 2 * m_padding),
@@ -0,0 +1,163 @@
+/*
+    src/task_queue.h -- Lock-free multi-producer/single-consumer task queue
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <waylandgui/common.h>
+#include <atomic>
+
+NAMESPACE_BEGIN(waylandgui)
+
+/**
+ * \brief Lock-free queue of \ref Task instances with many producers and a
+ * single consumer.
+ *
+ * Producers push onto an intrusive singly linked stack using a single
+ * compare-and-swap. The consumer detaches the whole stack with one atomic
+ * exchange and reverses it, which restores submission order and lets it run
+ * the batch without touching shared state.
+ *
+ * List nodes are recycled through a pool shared by all queues: the consumer
+ * returns a drained batch with one compare-and-swap, and each producer
+ * thread grabs the entire pool at once into a thread-local cache. Since
+ * nodes are only ever taken from the pool with an atomic exchange, the pool
+ * does not suffer from the ABA problem.
+ */
+class TaskQueue {
+public:
+    TaskQueue() = default;
+    TaskQueue(const TaskQueue &) = delete;
+    TaskQueue &operator=(const TaskQueue &) = delete;
+
+    ~TaskQueue() {
+        Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+        if (!node)
+            return;
+        for (Node *it = node; it; it = it->next)
+            it->task.reset();
+        release(node);
+    }
+
+    /**
+     * \brief Append a task (may be called from any thread)
+     *
+     * \return \c true if the queue was empty beforehand, i.e. when the
+     *     consumer needs to be woken up.
+     */
+    bool push(Task &&task) {
+        Node *node = alloc_node();
+        node->task = std::move(task);
+        node->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(node->next, node,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed))
+            ;
+        return node->next == nullptr;
+    }
+
+    /**
+     * \brief Detach all queued tasks and pass them to \c func in submission
+     * order (consumer thread only)
+     *
+     * Tasks that are queued while the batch is being processed are left for
+     * the next call. \c func must not throw.
+     *
+     * \return The number of processed tasks
+     */
+    template <typename Func> size_t consume(Func &&func) {
+        Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+        if (!node)
+            return 0;
+
+        /* Reverse the detached stack to obtain FIFO order */
+        Node *first = nullptr, *last = node;
+        while (node) {
+            Node *next = node->next;
+            node->next = first;
+            first = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        for (node = first; node; node = node->next) {
+            func(node->task);
+            node->task.reset();
+            count++;
+        }
+
+        /* Hand the whole batch back to the node pool */
+        release(first, last);
+
+        return count;
+    }
+
+    /// Is the queue currently empty?
+    bool empty() const { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+private:
+    struct Node {
+        Node *next;
+        Task task;
+    };
+
+    /// Number of nodes allocated at once when the pool runs dry
+    static constexpr size_t BlockSize = 256;
+
+    /// Per-thread list of recycled nodes
+    struct NodeCache {
+        Node *head = nullptr;
+
+        /* Hand unused nodes back to the pool when the thread exits */
+        ~NodeCache() {
+            if (head)
+                release(head);
+        }
+    };
+
+    static Node *alloc_node() {
+        thread_local NodeCache cache;
+        if (!cache.head)
+            cache.head = s_pool.exchange(nullptr, std::memory_order_acquire);
+        if (!cache.head) {
+            /* Nodes are allocated in blocks and never freed, so the pool
+               retains the high-water mark of pending tasks */
+            Node *block = new Node[BlockSize];
+            for (size_t i = 0; i + 1 < BlockSize; ++i)
+                block[i].next = &block[i + 1];
+            block[BlockSize - 1].next = nullptr;
+            cache.head = block;
+        }
+        Node *node = cache.head;
+        cache.head = node->next;
+        return node;
+    }
+
+    /// Return a null-terminated list of nodes with empty tasks to the pool
+    static void release(Node *first) {
+        Node *last = first;
+        while (last->next)
+            last = last->next;
+        release(first, last);
+    }
+
+    static void release(Node *first, Node *last) {
+        last->next = s_pool.load(std::memory_order_relaxed);
+        while (!s_pool.compare_exchange_weak(last->next, first,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed))
+            ;
+    }
+
+    std::atomic<Node *> m_head { nullptr };
+    static inline std::atomic<Node *> s_pool { nullptr };
+};
+
+NAMESPACE_END(waylandgui)
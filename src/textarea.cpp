@@ -24,10 +24,32 @@ TextArea::TextArea(Widget *parent) : Widget(parent),
   m_selection_start(-1), m_selection_end(-1) { }
 
 void TextArea::append(const std::string &text) {
-    NVGcontext *ctx = screen()->nvg_context();
+    append(measure(screen()->nvg_context(), text, m_font, font_size()));
+}
 
-    nvgFontSize(ctx, font_size());
-    nvgFontFace(ctx, m_font.c_str());
+void TextArea::append(const MeasuredText &text) {
+    for (const MeasuredText::Run &run : text.runs) {
+        m_blocks.push_back(Block { m_offset, run.width, run.text, m_foreground_color });
+
+        m_offset.x() += run.width;
+        m_max_size = max(m_max_size, m_offset);
+        if (run.newline) {
+            m_offset = Vector2i(0, m_offset.y() + font_size());
+            m_max_size = max(m_max_size, m_offset);
+        }
+    }
+
+    invalidate_layout();
+    VScrollPanel *vscroll = dynamic_cast<VScrollPanel *>(m_parent);
+    if (vscroll)
+        vscroll->perform_layout(screen()->nvg_context());
+}
+
+TextArea::MeasuredText TextArea::measure(NVGcontext *ctx, const std::string &text,
+                                         const std::string &font, float font_size) {
+    MeasuredText measured;
+    nvgFontSize(ctx, font_size);
+    nvgFontFace(ctx, font.c_str());
 
     const char *str = text.c_str();
     do {
@@ -40,25 +62,17 @@ void TextArea::append(const std::string &text) {
         if (line.empty())
             continue;
         int width = nvgTextBounds(ctx, 0, 0, line.c_str(), nullptr, nullptr);
-        m_blocks.push_back(Block { m_offset, width, line, m_foreground_color });
-
-        m_offset.x() += width;
-        m_max_size = max(m_max_size, m_offset);
-        if (*str == '\n') {
-            m_offset = Vector2i(0, m_offset.y() + font_size());
-            m_max_size = max(m_max_size, m_offset);
-        }
+        measured.runs.push_back(MeasuredText::Run { std::move(line), width, *str == '\n' });
     } while (*str++ != 0);
 
-    VScrollPanel *vscroll = dynamic_cast<VScrollPanel *>(m_parent);
-    if (vscroll)
-        vscroll->perform_layout(ctx);
+    return measured;
 }
 
 void TextArea::clear() {
     m_blocks.clear();
     m_offset = m_max_size = 0;
     m_selection_start = m_selection_end = -1;
+    invalidate_layout();
 }
 
 bool TextArea::keyboard_event(int key, int /* scancode */, int action, int modifiers) {
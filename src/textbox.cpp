@@ -68,14 +68,16 @@ Vector2i TextBox::preferred_size(NVGcontext *ctx) const {
         float uh = size[1] * 0.4f;
         uw = w * uh / h;
     } else if (!m_units.empty()) {
-        uw = nvgTextBounds(ctx, 0, 0, m_units.c_str(), nullptr, nullptr);
+        m_units_layout.update(ctx, m_units, "sans", font_size());
+        uw = m_units_layout.advance();
     }
     float sw = 0;
     if (m_spinnable) {
         sw = 14.f;
     }
 
-    float ts = nvgTextBounds(ctx, 0, 0, m_value.c_str(), nullptr, nullptr);
+    m_text_layout.update(ctx, m_value, "sans", font_size());
+    float ts = m_text_layout.advance();
     size[0] = size[1] + ts + uw + sw;
     return size;
 }
@@ -136,11 +138,11 @@ void TextBox::draw(NVGcontext* ctx) {
         nvgFill(ctx);
         unit_width += 2;
     } else if (!m_units.empty()) {
-        unit_width = nvgTextBounds(ctx, 0, 0, m_units.c_str(), nullptr, nullptr);
+        m_units_layout.update(ctx, m_units, "sans", font_size());
+        unit_width = m_units_layout.advance();
         nvgFillColor(ctx, Color(255, m_enabled ? 64 : 32));
-        nvgTextAlign(ctx, NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
-        nvgText(ctx, m_pos.x() + m_size.x() - x_spacing, draw_pos.y(),
-                m_units.c_str(), nullptr);
+        m_units_layout.draw(ctx, m_pos.x() + m_size.x() - x_spacing, draw_pos.y(),
+                            NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
         unit_width += 2;
     }
 
@@ -178,22 +180,22 @@ void TextBox::draw(NVGcontext* ctx) {
         nvgFontFace(ctx, "sans");
     }
 
+    int align = NVG_ALIGN_MIDDLE;
     switch (m_alignment) {
         case Alignment::Left:
-            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
+            align |= NVG_ALIGN_LEFT;
             draw_pos.x() += x_spacing + spin_arrows_width;
             break;
         case Alignment::Right:
-            nvgTextAlign(ctx, NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
+            align |= NVG_ALIGN_RIGHT;
             draw_pos.x() += m_size.x() - unit_width - x_spacing;
             break;
         case Alignment::Center:
-            nvgTextAlign(ctx, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
+            align |= NVG_ALIGN_CENTER;
             draw_pos.x() += m_size.x() * 0.5f;
             break;
     }
 
-    nvgFontSize(ctx, font_size());
     nvgFillColor(ctx, m_enabled && (!m_committed || !m_value.empty()) ?
         m_theme->m_text_color :
         m_theme->m_disabled_text_color);
@@ -211,26 +213,32 @@ void TextBox::draw(NVGcontext* ctx) {
     draw_pos.x() += m_text_offset;
 
     if (m_committed) {
-        nvgText(ctx, draw_pos.x(), draw_pos.y(), m_value.empty() ? m_placeholder.c_str() : m_value.c_str(), nullptr);
+        m_text_layout.update(ctx, m_value.empty() ? m_placeholder : m_value,
+                             "sans", font_size());
+        m_text_layout.draw(ctx, draw_pos.x(), draw_pos.y(), align);
     } else {
-        const int max_glyphs = 1024;
-        NVGglyphPosition glyphs[max_glyphs];
-        float text_bound[4];
-        nvgTextBounds(ctx, draw_pos.x(), draw_pos.y(), m_value_temp.c_str(),
-                      nullptr, text_bound);
-        float lineh = text_bound[3] - text_bound[1];
+        m_text_layout.update(ctx, m_value_temp, "sans", font_size());
+        const std::vector<TextLayout::Glyph> &glyphs = m_text_layout.glyphs(ctx);
+        const float *text_bound = m_text_layout.bounds();
+        float lineh = text_bound[3] - text_bound[1], lastx = text_bound[2];
+        int nglyphs = (int) glyphs.size();
+
+        /* Glyph positions are relative to the start of the text */
+        float shift = 0.f;
+        if (align & NVG_ALIGN_CENTER)
+            shift = -m_text_layout.advance() * 0.5f;
+        else if (align & NVG_ALIGN_RIGHT)
+            shift = -m_text_layout.advance();
+        float origin = draw_pos.x() + shift;
 
         // find cursor positions
-        int nglyphs =
-            nvgTextGlyphPositions(ctx, draw_pos.x(), draw_pos.y(),
-                                  m_value_temp.c_str(), nullptr, glyphs, max_glyphs);
-        update_cursor(ctx, text_bound[2], glyphs, nglyphs);
+        update_cursor(origin, lastx, glyphs.data(), nglyphs);
 
         // compute text offset
         int prev_cpos = m_cursor_pos > 0 ? m_cursor_pos - 1 : 0;
         int next_cpos = m_cursor_pos < nglyphs ? m_cursor_pos + 1 : nglyphs;
-        float prev_cx = cursor_index_to_position(prev_cpos, text_bound[2], glyphs, nglyphs);
-        float next_cx = cursor_index_to_position(next_cpos, text_bound[2], glyphs, nglyphs);
+        float prev_cx = origin + cursor_index_to_position(prev_cpos, lastx, glyphs.data(), nglyphs);
+        float next_cx = origin + cursor_index_to_position(next_cpos, lastx, glyphs.data(), nglyphs);
 
         if (next_cx > clip_x + clip_width)
             m_text_offset -= next_cx - (clip_x + clip_width) + 1;
@@ -238,22 +246,17 @@ void TextBox::draw(NVGcontext* ctx) {
             m_text_offset += clip_x - prev_cx + 1;
 
         draw_pos.x() = old_draw_pos.x() + m_text_offset;
+        origin = draw_pos.x() + shift;
 
         // draw text with offset
-        nvgText(ctx, draw_pos.x(), draw_pos.y(), m_value_temp.c_str(), nullptr);
-        nvgTextBounds(ctx, draw_pos.x(), draw_pos.y(), m_value_temp.c_str(),
-                      nullptr, text_bound);
-
-        // recompute cursor positions
-        nglyphs = nvgTextGlyphPositions(ctx, draw_pos.x(), draw_pos.y(),
-                m_value_temp.c_str(), nullptr, glyphs, max_glyphs);
+        m_text_layout.draw(ctx, draw_pos.x(), draw_pos.y(), align);
 
         if (m_cursor_pos > -1) {
             if (m_selection_pos > -1) {
-                float caretx = cursor_index_to_position(m_cursor_pos, text_bound[2],
-                                                    glyphs, nglyphs);
-                float selx = cursor_index_to_position(m_selection_pos, text_bound[2],
-                                                  glyphs, nglyphs);
+                float caretx = origin + cursor_index_to_position(m_cursor_pos, lastx,
+                                                                 glyphs.data(), nglyphs);
+                float selx = origin + cursor_index_to_position(m_selection_pos, lastx,
+                                                               glyphs.data(), nglyphs);
 
                 if (caretx > selx)
                     std::swap(caretx, selx);
@@ -266,7 +269,8 @@ void TextBox::draw(NVGcontext* ctx) {
                 nvgFill(ctx);
             }
 
-            float caretx = cursor_index_to_position(m_cursor_pos, text_bound[2], glyphs, nglyphs);
+            float caretx = origin + cursor_index_to_position(m_cursor_pos, lastx,
+                                                             glyphs.data(), nglyphs);
 
             // draw cursor
             nvgBeginPath(ctx);
@@ -321,6 +325,7 @@ bool TextBox::mouse_button_event(const Vector2i &p, int button, bool down,
                 if (time - m_last_click < 0.25) {
                     /* Double-click: reset to default value */
                     m_value = m_default_value;
+                    invalidate_layout();
                     if (m_callback)
                         m_callback(m_value);
 
@@ -385,6 +390,8 @@ bool TextBox::focus_event(bool focused) {
 
             if (m_callback && !m_callback(m_value))
                 m_value = backup;
+            if (m_value != backup)
+                invalidate_layout();
 
             m_valid_format = true;
             m_committed = true;
@@ -562,8 +569,8 @@ bool TextBox::delete_selection() {
     return false;
 }
 
-void TextBox::update_cursor(NVGcontext *, float lastx,
-                           const NVGglyphPosition *glyphs, int size) {
+void TextBox::update_cursor(float origin, float lastx,
+                           const TextLayout::Glyph *glyphs, int size) {
     // handle mouse cursor events
     if (m_mouse_down_pos.x() != -1) {
         if (m_mouse_down_modifier == GLFW_MOD_SHIFT) {
@@ -573,7 +580,7 @@ void TextBox::update_cursor(NVGcontext *, float lastx,
             m_selection_pos = -1;
 
         m_cursor_pos =
-            position_to_cursor_index(m_mouse_down_pos.x(), lastx, glyphs, size);
+            position_to_cursor_index(m_mouse_down_pos.x() - origin, lastx, glyphs, size);
 
         m_mouse_down_pos = Vector2i(-1, -1);
     } else if (m_mouse_drag_pos.x() != -1) {
@@ -581,7 +588,7 @@ void TextBox::update_cursor(NVGcontext *, float lastx,
             m_selection_pos = m_cursor_pos;
 
         m_cursor_pos =
-            position_to_cursor_index(m_mouse_drag_pos.x(), lastx, glyphs, size);
+            position_to_cursor_index(m_mouse_drag_pos.x() - origin, lastx, glyphs, size);
     } else {
         // set cursor to last character
         if (m_cursor_pos == -2)
@@ -593,7 +600,7 @@ void TextBox::update_cursor(NVGcontext *, float lastx,
 }
 
 float TextBox::cursor_index_to_position(int index, float lastx,
-                                        const NVGglyphPosition *glyphs, int size) {
+                                        const TextLayout::Glyph *glyphs, int size) {
     float pos = 0;
     if (index == size)
         pos = lastx; // last character
@@ -604,7 +611,9 @@ float TextBox::cursor_index_to_position(int index, float lastx,
 }
 
 int TextBox::position_to_cursor_index(float posx, float lastx,
-                                      const NVGglyphPosition *glyphs, int size) {
+                                      const TextLayout::Glyph *glyphs, int size) {
+    if (size == 0)
+        return 0;
     int m_cursor_id = 0;
     float caretx = glyphs[m_cursor_id].x;
     for (int j = 1; j < size; j++) {
@@ -0,0 +1,111 @@
+/*
+    src/textlayout.cpp -- Measured text that widgets keep between frames
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <waylandgui/textlayout.h>
+#include <nanovg.h>
+
+NAMESPACE_BEGIN(waylandgui)
+
+void TextLayout::apply_font(NVGcontext *ctx) const {
+    nvgFontFaceId(ctx, m_font_id);
+    nvgFontSize(ctx, m_font_size);
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+}
+
+bool TextLayout::update(NVGcontext *ctx, const std::string &text, const std::string &font,
+                        float font_size, float wrap_width) {
+    const void *fonts = nvgFontStash(ctx);
+    float scale = nvgTextScale(ctx);
+    if (fonts == m_fonts && scale == m_scale && font_size == m_font_size &&
+        wrap_width == m_wrap_width && font == m_font && text == m_text)
+        return false;
+
+    m_fonts = fonts;
+    m_scale = scale;
+    m_text = text;
+    m_font = font;
+    m_font_size = font_size;
+    m_wrap_width = wrap_width;
+    m_font_id = nvgFindFont(ctx, font.c_str());
+    m_rows.clear();
+    m_glyphs.clear();
+    m_glyphs_valid = false;
+
+    const char *begin = m_text.c_str(), *end = begin + m_text.size();
+    apply_font(ctx);
+    nvgTextLineHeight(ctx, 1.f);
+    nvgTextMetrics(ctx, nullptr, nullptr, &m_line_height);
+    m_advance = nvgTextBounds(ctx, 0, 0, begin, end, m_bounds);
+
+    if (wrap_width <= 0) {
+        if (!m_text.empty())
+            m_rows.push_back({ 0, (uint32_t) m_text.size(), m_advance });
+        return true;
+    }
+
+    nvgTextBoxBounds(ctx, 0, 0, wrap_width, begin, end, m_bounds);
+    NVGtextRow rows[8];
+    int nrows;
+    while ((nrows = nvgTextBreakLines(ctx, begin, end, wrap_width, rows, 8)) > 0) {
+        for (int i = 0; i < nrows; ++i)
+            m_rows.push_back({ (uint32_t) (rows[i].start - m_text.c_str()),
+                               (uint32_t) (rows[i].end - m_text.c_str()),
+                               rows[i].width });
+        begin = rows[nrows - 1].next;
+    }
+    return true;
+}
+
+const std::vector<TextLayout::Glyph> &TextLayout::glyphs(NVGcontext *ctx) const {
+    if (m_glyphs_valid)
+        return m_glyphs;
+    m_glyphs_valid = true;
+    if (m_text.empty())
+        return m_glyphs;
+
+    /* There are never more glyphs than bytes */
+    std::vector<NVGglyphPosition> positions(m_text.size());
+    const char *text = m_text.c_str();
+    apply_font(ctx);
+    int count = nvgTextGlyphPositions(ctx, 0, 0, text, text + m_text.size(),
+                                      positions.data(), (int) positions.size());
+
+    m_glyphs.resize(count);
+    for (int i = 0; i < count; ++i)
+        m_glyphs[i] = { (uint32_t) (positions[i].str - text), positions[i].x,
+                        positions[i].minx, positions[i].maxx };
+    return m_glyphs;
+}
+
+void TextLayout::draw(NVGcontext *ctx, float x, float y, int align) const {
+    if (m_rows.empty())
+        return;
+
+    const int halign = NVG_ALIGN_LEFT | NVG_ALIGN_CENTER | NVG_ALIGN_RIGHT;
+    nvgFontFaceId(ctx, m_font_id);
+    nvgFontSize(ctx, m_font_size);
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | (align & ~halign));
+
+    /* Single rows are aligned at the origin, wrapped ones within the box */
+    float box = m_wrap_width > 0 ? m_wrap_width : 0.f;
+    const char *text = m_text.c_str();
+    for (const Row &row : m_rows) {
+        float rx = x;
+        if (align & NVG_ALIGN_CENTER)
+            rx += (box - row.width) * .5f;
+        else if (align & NVG_ALIGN_RIGHT)
+            rx += box - row.width;
+        nvgText(ctx, rx, y, text + row.begin, text + row.end);
+        y += m_line_height;
+    }
+}
+
+NAMESPACE_END(waylandgui)
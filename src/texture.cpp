@@ -26,6 +26,32 @@ Texture::Texture(PixelFormat pixel_format,
     init();
 }
 
+/// Image decoded by stb-image, ready to be uploaded
+struct DecodedImage {
+    using Holder = std::unique_ptr<uint8_t[], void(*)(void*)>;
+
+    Holder data { nullptr, stbi_image_free };
+    Vector2i size;
+    Texture::PixelFormat pixel_format;
+
+    explicit DecodedImage(const std::string &filename) {
+        int n = 0;
+        data = Holder(stbi_load(filename.c_str(), &size.x(), &size.y(), &n, 0),
+                      stbi_image_free);
+        if (!data)
+            throw std::runtime_error("Could not load texture data from file \"" + filename + "\".");
+
+        switch (n) {
+            case 1: pixel_format = Texture::PixelFormat::R;    break;
+            case 2: pixel_format = Texture::PixelFormat::RA;   break;
+            case 3: pixel_format = Texture::PixelFormat::RGB;  break;
+            case 4: pixel_format = Texture::PixelFormat::RGBA; break;
+            default:
+                throw std::runtime_error("Texture::Texture(): unsupported channel count!");
+        }
+    }
+};
+
 Texture::Texture(const std::string &filename,
                  InterpolationMode min_interpolation_mode,
                  InterpolationMode mag_interpolation_mode,
@@ -37,26 +63,34 @@ Texture::Texture(const std::string &filename,
       m_samples(1),
       m_flags(TextureFlags::ShaderRead),
       m_mipmap_manual(false) {
-    int n = 0;
-    using Holder = std::unique_ptr<uint8_t[], void(*)(void*)>;
-    Holder texture_data(stbi_load(filename.c_str(), &m_size.x(), &m_size.y(), &n, 0),
-                        stbi_image_free);
-    if (!texture_data)
-        throw std::runtime_error("Could not load texture data from file \"" + filename + "\".");
-
-    switch (n) {
-        case 1: m_pixel_format = PixelFormat::R;    break;
-        case 2: m_pixel_format = PixelFormat::RA;   break;
-        case 3: m_pixel_format = PixelFormat::RGB;  break;
-        case 4: m_pixel_format = PixelFormat::RGBA; break;
-        default:
-            throw std::runtime_error("Texture::Texture(): unsupported channel count!");
-    }
-    PixelFormat pixel_format = m_pixel_format;
+    DecodedImage image(filename);
+    m_size = image.size;
+    m_pixel_format = image.pixel_format;
     init();
-    if (m_pixel_format != pixel_format)
+    if (m_pixel_format != image.pixel_format)
         throw std::runtime_error("Texture::Texture(): pixel format not supported by the hardware!");
-    upload((const uint8_t *) texture_data.get());
+    upload((const uint8_t *) image.data.get());
+}
+
+ref<BackgroundTask> Texture::load_async(const std::string &filename,
+                                        const std::function<void(Texture *)> &callback,
+                                        Widget *owner,
+                                        InterpolationMode min_interpolation_mode,
+                                        InterpolationMode mag_interpolation_mode,
+                                        WrapMode wrap_mode) {
+    return run_in_background(
+        [filename]() { return DecodedImage(filename); },
+        [callback, min_interpolation_mode, mag_interpolation_mode,
+         wrap_mode](DecodedImage image) {
+            ref<Texture> texture = new Texture(
+                image.pixel_format, ComponentFormat::UInt8, image.size,
+                min_interpolation_mode, mag_interpolation_mode, wrap_mode);
+            if (texture->pixel_format() != image.pixel_format)
+                throw std::runtime_error("Texture::load_async(): pixel format not supported by the hardware!");
+            texture->upload((const uint8_t *) image.data.get());
+            callback(texture);
+        },
+        TaskPriority::Normal, owner);
 }
 
 size_t Texture::bytes_per_pixel() const {
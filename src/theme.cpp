@@ -14,10 +14,27 @@
 #include <waylandgui/theme.h>
 #include <waylandgui/opengl.h>
 #include <waylandgui/icons.h>
-#include <waylandgui_resources.h>
+#if defined(WAYLANDGUI_RESOURCE_PACK)
+#  include <waylandgui/resourcepack.h>
+#else
+#  include <waylandgui_resources.h>
+#endif
+#if defined(WAYLANDGUI_BAKED_GLYPHS)
+#  include <atomic>
+#  include <iostream>
+#endif
 
 NAMESPACE_BEGIN(waylandgui)
 
+#if defined(WAYLANDGUI_BAKED_GLYPHS)
+static void add_baked_glyphs(NVGcontext *ctx, const uint8_t *data, size_t size) {
+    static std::atomic<bool> reported { false };
+    if (nvgAddBakedGlyphs(ctx, data, (int) size) < 0 && !reported.exchange(true))
+        std::cerr << "Warning: the baked glyph atlas does not fit into a font atlas "
+                     "page, glyphs will be rasterized when first drawn" << std::endl;
+}
+#endif
+
 Theme::Theme(NVGcontext *ctx) {
     m_standard_font_size                 = 16;
     m_button_font_size                   = 20;
@@ -78,6 +95,18 @@ Theme::Theme(NVGcontext *ctx) {
     m_text_box_up_icon                  = FA_CHEVRON_UP;
     m_text_box_down_icon                = FA_CHEVRON_DOWN;
 
+#if defined(WAYLANDGUI_RESOURCE_PACK)
+    /* The fonts are used in place, the pack stays mapped */
+    const ResourcePack &pack = ResourcePack::builtin();
+    auto create_font = [&](const char *name, const char *file) {
+        ResourcePack::Resource font = pack.get(file);
+        return font.data ? nvgCreateFontMem(ctx, name, (uint8_t *) font.data, (int) font.size, 0) : -1;
+    };
+    m_font_sans_regular = create_font("sans", "Roboto-Regular.ttf");
+    m_font_sans_bold = create_font("sans-bold", "Roboto-Bold.ttf");
+    m_font_icons = create_font("icons", "FontAwesome-Solid.ttf");
+    m_font_mono_regular = create_font("mono", "Inconsolata-Regular.ttf");
+#else
     m_font_sans_regular = nvgCreateFontMem(ctx, "sans", (uint8_t *) roboto_regular_ttf,
                                            roboto_regular_ttf_size, 0);
     m_font_sans_bold = nvgCreateFontMem(ctx, "sans-bold", (uint8_t *) roboto_bold_ttf,
@@ -86,10 +115,25 @@ Theme::Theme(NVGcontext *ctx) {
                                     fontawesome_solid_ttf_size, 0);
     m_font_mono_regular = nvgCreateFontMem(ctx, "mono", (uint8_t *) inconsolata_regular_ttf,
                                            inconsolata_regular_ttf_size, 0);
+#endif
 
     if (m_font_sans_regular == -1 || m_font_sans_bold == -1 ||
         m_font_icons == -1 || m_font_mono_regular == -1)
         throw std::runtime_error("Could not load fonts!");
+
+#if defined(WAYLANDGUI_BAKED_GLYPHS)
+    /* Glyphs that were rasterized at build time (see WAYLANDGUI_BAKED_GLYPH_SETS) */
+#  if defined(WAYLANDGUI_RESOURCE_PACK)
+    ResourcePack::Resource atlas = pack.get("glyph_atlas.bin");
+    if (atlas.data) {
+        add_baked_glyphs(ctx, atlas.data, atlas.size);
+        /* The glyphs were copied into the font atlas */
+        pack.evict("glyph_atlas.bin");
+    }
+#  else
+    add_baked_glyphs(ctx, glyph_atlas_bin, glyph_atlas_bin_size);
+#  endif
+#endif
 }
 
 NAMESPACE_END(waylandgui)
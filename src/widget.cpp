@@ -15,6 +15,8 @@
 #include <waylandgui/window.h>
 #include <waylandgui/opengl.h>
 #include <waylandgui/screen.h>
+#include <waylandgui/spatialindex.h>
+#include <cmath>
 
 /* Uncomment the following definition to draw red bounding
    boxes around widgets (useful for debugging drawing code) */
@@ -33,6 +35,9 @@ Widget::Widget(Widget *parent)
 }
 
 Widget::~Widget() {
+    for (auto &task : m_background_tasks)
+        task->cancel();
+
     if (std::uncaught_exceptions() > 0) {
         /* If a widget constructor throws an exception, it is immediately
            dealloated but may still be referenced by a parent. Be conservative
@@ -44,12 +49,18 @@ Widget::~Widget() {
         if (child)
             child->dec_ref();
     }
+    if (m_display_list)
+        nvgDeleteDisplayList(m_display_list);
+    if (m_layer_cache)
+        m_layer_cache->release(this);
+    delete m_spatial_index;
 }
 
 void Widget::set_theme(Theme *theme) {
     if (m_theme.get() == theme)
         return;
     m_theme = theme;
+    invalidate_layout();
     for (auto child : m_children)
         child->set_theme(theme);
 }
@@ -65,46 +76,100 @@ Vector2i Widget::preferred_size(NVGcontext *ctx) const {
         return m_size;
 }
 
+Vector2i Widget::cached_preferred_size(NVGcontext *ctx) const {
+    int font_size = this->font_size();
+    if (!m_preferred_size_valid || m_preferred_size_ctx != ctx ||
+        m_preferred_size_theme != m_theme.get() ||
+        m_preferred_size_font != font_size) {
+        m_preferred_size_cache = preferred_size(ctx);
+        m_preferred_size_theme = m_theme.get();
+        m_preferred_size_ctx = ctx;
+        m_preferred_size_font = font_size;
+        m_preferred_size_valid = true;
+    }
+    return m_preferred_size_cache;
+}
+
+void Widget::invalidate_layout() {
+    for (Widget *widget = this; widget; widget = widget->m_parent) {
+        widget->m_preferred_size_valid = false;
+        widget->m_layout_dirty = true;
+        widget->m_display_list_valid = false;
+        widget->m_layer_valid = false;
+    }
+}
+
+void Widget::reset_layout() {
+    m_preferred_size_valid = false;
+    m_layout_dirty = true;
+    for (auto c : m_children)
+        c->reset_layout();
+}
+
 void Widget::perform_layout(NVGcontext *ctx) {
+    invalidate_display_list();
+    m_spatial_index_valid = false;
+    m_layout_dirty = false;
+    m_laid_out = true;
     if (m_layout) {
         m_layout->perform_layout(ctx, this);
     } else {
         for (auto c : m_children) {
-            Vector2i pref = c->preferred_size(ctx), fix = c->fixed_size();
+            Vector2i pref = c->cached_preferred_size(ctx), fix = c->fixed_size();
             c->set_size(Vector2i(
                 fix[0] ? fix[0] : pref[0],
                 fix[1] ? fix[1] : pref[1]
             ));
-            c->perform_layout(ctx);
+            c->update_layout(ctx);
         }
     }
 }
 
-Widget *Widget::find_widget(const Vector2i &p) {
-    for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        Widget *child = *it;
-        if (child->visible() && child->contains(p - m_pos))
-            return child->find_widget(p - m_pos);
+/**
+ * Call \c func for the visible children that contain \c p (relative to
+ * their parent) from the topmost to the bottommost, until it returns true
+ */
+template <typename Func>
+static bool for_each_child_at(const std::vector<Widget *> &children,
+                              const SpatialIndex *index, const Vector2i &p,
+                              Func func) {
+    if (index) {
+        SpatialIndex::Range range = index->query(p);
+        for (const uint32_t *it = range.second; it != range.first; ) {
+            Widget *child = children[*--it];
+            if (child->visible() && child->contains(p) && func(child))
+                return true;
+        }
+    } else {
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            Widget *child = *it;
+            if (child->visible() && child->contains(p) && func(child))
+                return true;
+        }
     }
+    return false;
+}
+
+Widget *Widget::find_widget(const Vector2i &p) {
+    Widget *result = nullptr;
+    for_each_child_at(m_children, children_index(), p - m_pos, [&](Widget *child) {
+        result = child->find_widget(p - m_pos);
+        return true;
+    });
+    if (result)
+        return result;
     return contains(p) ? this : nullptr;
 }
 
 const Widget *Widget::find_widget(const Vector2i &p) const {
-    for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        Widget *child = *it;
-        if (child->visible() && child->contains(p - m_pos))
-            return child->find_widget(p - m_pos);
-    }
-    return contains(p) ? this : nullptr;
+    return const_cast<Widget *>(this)->find_widget(p);
 }
 
 bool Widget::mouse_button_event(const Vector2i &p, int button, bool down, int modifiers) {
-    for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        Widget *child = *it;
-        if (child->visible() && child->contains(p - m_pos) &&
-            child->mouse_button_event(p - m_pos, button, down, modifiers))
-            return true;
-    }
+    if (for_each_child_at(m_children, children_index(), p - m_pos, [&](Widget *child) {
+            return child->mouse_button_event(p - m_pos, button, down, modifiers);
+        }))
+        return true;
     if (button == GLFW_MOUSE_BUTTON_1 && down && !m_focused)
         request_focus();
     return false;
@@ -113,10 +178,9 @@ bool Widget::mouse_button_event(const Vector2i &p, int button, bool down, int mo
 bool Widget::mouse_motion_event(const Vector2i &p, const Vector2i &rel, int button, int modifiers) {
     bool handled = false;
 
-    for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        Widget *child = *it;
+    auto visit = [&](Widget *child) {
         if (!child->visible())
-            continue;
+            return;
 
         bool contained      = child->contains(p - m_pos),
              prev_contained = child->contains(p - m_pos - rel);
@@ -126,20 +190,39 @@ bool Widget::mouse_motion_event(const Vector2i &p, const Vector2i &rel, int butt
 
         if (contained || prev_contained)
             handled |= child->mouse_motion_event(p - m_pos, rel, button, modifiers);
+    };
+
+    if (const SpatialIndex *index = children_index()) {
+        /* Merge the candidates at the current and previous position,
+           visiting them from the topmost to the bottommost */
+        SpatialIndex::Range cur  = index->query(p - m_pos),
+                            prev = index->query(p - m_pos - rel);
+        if (cur == prev)
+            prev.first = prev.second;
+        const uint32_t *a = cur.second, *b = prev.second;
+        while (a != cur.first || b != prev.first) {
+            uint32_t i;
+            if (b == prev.first || (a != cur.first && a[-1] >= b[-1])) {
+                i = *--a;
+                if (b != prev.first && b[-1] == i)
+                    --b;
+            } else {
+                i = *--b;
+            }
+            visit(m_children[i]);
+        }
+    } else {
+        for (auto it = m_children.rbegin(); it != m_children.rend(); ++it)
+            visit(*it);
     }
 
     return handled;
 }
 
 bool Widget::scroll_event(const Vector2i &p, const Vector2f &rel) {
-    for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        Widget *child = *it;
-        if (!child->visible())
-            continue;
-        if (child->contains(p - m_pos) && child->scroll_event(p - m_pos, rel))
-            return true;
-    }
-    return false;
+    return for_each_child_at(m_children, children_index(), p - m_pos, [&](Widget *child) {
+        return child->scroll_event(p - m_pos, rel);
+    });
 }
 
 bool Widget::mouse_drag_event(const Vector2i &, const Vector2i &, int, int) {
@@ -147,11 +230,15 @@ bool Widget::mouse_drag_event(const Vector2i &, const Vector2i &, int, int) {
 }
 
 bool Widget::mouse_enter_event(const Vector2i &, bool enter) {
+    if (m_mouse_focus != enter)
+        invalidate_display_list();
     m_mouse_focus = enter;
     return false;
 }
 
 bool Widget::focus_event(bool focused) {
+    if (m_focused != focused)
+        invalidate_display_list();
     m_focused = focused;
     return false;
 }
@@ -170,6 +257,8 @@ void Widget::add_child(int index, Widget * widget) {
     widget->inc_ref();
     widget->set_parent(this);
     widget->set_theme(m_theme);
+    invalidate_layout();
+    m_spatial_index_valid = false;
 }
 
 void Widget::add_child(Widget * widget) {
@@ -182,6 +271,11 @@ void Widget::remove_child(const Widget *widget) {
                      m_children.end());
     if (m_children.size() == child_count)
         throw std::runtime_error("Widget::remove_child(): widget not found!");
+    invalidate_layout();
+    m_spatial_index_valid = false;
+    /* The screen may be tracking a widget of this subtree under the cursor */
+    if (Screen *screen = this->screen())
+        screen->m_hover_stale = true;
     widget->dec_ref();
 }
 
@@ -190,6 +284,11 @@ void Widget::remove_child_at(int index) {
         throw std::runtime_error("Widget::remove_child_at(): out of bounds!");
     Widget *widget = m_children[index];
     m_children.erase(m_children.begin() + index);
+    invalidate_layout();
+    m_spatial_index_valid = false;
+    /* The screen may be tracking a widget of this subtree under the cursor */
+    if (Screen *screen = this->screen())
+        screen->m_hover_stale = true;
     widget->dec_ref();
 }
 
@@ -234,6 +333,98 @@ void Widget::request_focus() {
     ((Screen *) widget)->update_focus(this);
 }
 
+void Widget::mark_dirty(const Vector2i &pos, const Vector2i &size) {
+    invalidate_display_list();
+    if (!visible_recursive())
+        return;
+    Screen *screen = this->screen();
+    if (screen)
+        screen->add_damage(absolute_position() + pos, size);
+}
+
+void Widget::set_retained(bool value) {
+    m_retained = value;
+    if (!value && m_display_list) {
+        nvgDeleteDisplayList(m_display_list);
+        m_display_list = nullptr;
+    }
+    invalidate_display_list();
+}
+
+void Widget::invalidate_display_list() {
+    for (Widget *widget = this; widget; widget = widget->m_parent) {
+        widget->m_display_list_valid = false;
+        widget->m_layer_valid = false;
+    }
+}
+
+void Widget::set_cache_as_layer(bool value) {
+    m_cache_as_layer = value;
+    if (!value && m_layer_cache)
+        m_layer_cache->release(this);
+    invalidate_display_list();
+}
+
+void Widget::set_spatial_index(bool value) {
+    if (value && !m_spatial_index) {
+        m_spatial_index = new SpatialIndex();
+        m_spatial_index_valid = false;
+    } else if (!value) {
+        delete m_spatial_index;
+        m_spatial_index = nullptr;
+    }
+}
+
+const SpatialIndex *Widget::children_index() const {
+    if (m_spatial_index && !m_spatial_index_valid) {
+        m_spatial_index->build(m_children);
+        m_spatial_index_valid = true;
+    }
+    return m_spatial_index;
+}
+
+void Widget::draw_retained(NVGcontext *ctx) {
+    /* Widgets draw themselves at m_pos in their parent's coordinate system */
+    Vector2f offset(m_pos - m_display_list_pos);
+    if (m_display_list_valid &&
+        nvgReplayDisplayList(ctx, m_display_list, offset.x(), offset.y()))
+        return;
+
+    if (!m_display_list)
+        m_display_list = nvgCreateDisplayList();
+    if (!m_display_list) {
+        draw(ctx);
+        return;
+    }
+
+    /* Invalidations while drawing (e.g. by animated children) must stick */
+    m_display_list_valid = true;
+    m_display_list_pos = m_pos;
+    nvgBeginDisplayList(ctx, m_display_list);
+    draw(ctx);
+    if (!nvgEndDisplayList(ctx))
+        m_display_list_valid = false;
+}
+
+void Widget::draw_layer(NVGcontext *ctx) {
+    Screen *screen = this->screen();
+    if (screen && screen->m_layer_cache.draw(ctx, this, screen))
+        return;
+    if (m_retained)
+        draw_retained(ctx);
+    else
+        draw(ctx);
+}
+
+void Widget::attach_background_task(BackgroundTask *task) {
+    /* Forget about tasks that have already completed */
+    m_background_tasks.erase(
+        std::remove_if(m_background_tasks.begin(), m_background_tasks.end(),
+                       [](const ref<BackgroundTask> &t) { return t->finished(); }),
+        m_background_tasks.end());
+    m_background_tasks.push_back(task);
+}
+
 void Widget::draw(NVGcontext *ctx) {
     #if defined(WAYLANDGUI_SHOW_WIDGET_BOUNDS)
         nvgStrokeWidth(ctx, 1.0f);
@@ -248,19 +439,46 @@ void Widget::draw(NVGcontext *ctx) {
         return;
 
     nvgTranslate(ctx, m_pos.x(), m_pos.y());
+
+    /* Skip children that lie outside of the scissor rectangle, along with
+       their subtrees (e.g. the hidden rows of a scrolled VScrollPanel) */
+    float bounds[4];
+    bool clip = nvgCurrentScissor(ctx, bounds);
+    Vector2i clip_min, clip_max;
+    if (clip) {
+        clip_min = Vector2i((int) std::floor(bounds[0]), (int) std::floor(bounds[1]));
+        clip_max = Vector2i((int) std::ceil(bounds[0] + bounds[2]),
+                            (int) std::ceil(bounds[1] + bounds[3]));
+    }
+
     for (auto child : m_children) {
         if (!child->visible())
             continue;
+        if (clip) {
+            int margin = child->layer_margin();
+            Vector2i lo = child->m_pos - margin,
+                     hi = child->m_pos + child->m_size + margin;
+            if (hi.x() <= clip_min.x() || hi.y() <= clip_min.y() ||
+                lo.x() >= clip_max.x() || lo.y() >= clip_max.y())
+                continue;
+        }
         #if !defined(WAYLANDGUI_SHOW_WIDGET_BOUNDS)
-            nvgSave(ctx);
-            nvgIntersectScissor(ctx, child->m_pos.x(), child->m_pos.y(),
-                                child->m_size.x(), child->m_size.y());
+            /* Like nvgSave() + nvgIntersectScissor(), but the full NanoVG
+               state is only copied if the child changes more than the
+               transform and scissor */
+            nvgPushClip(ctx, child->m_pos.x(), child->m_pos.y(),
+                        child->m_size.x(), child->m_size.y());
         #endif
 
-        child->draw(ctx);
+        if (child->m_cache_as_layer)
+            child->draw_layer(ctx);
+        else if (child->m_retained)
+            child->draw_retained(ctx);
+        else
+            child->draw(ctx);
 
         #if !defined(WAYLANDGUI_SHOW_WIDGET_BOUNDS)
-            nvgRestore(ctx);
+            nvgPopClip(ctx);
         #endif
     }
     nvgTranslate(ctx, -m_pos.x(), -m_pos.y());
@@ -22,16 +22,15 @@ Window::Window(Widget *parent, const std::string &title)
       m_drag(false) { }
 
 Vector2i Window::preferred_size(NVGcontext *ctx) const {
+    /* Hide the button panel from the layout without invalidating anything */
     if (m_button_panel)
-        m_button_panel->set_visible(false);
+        m_button_panel->m_visible = false;
     Vector2i result = Widget::preferred_size(ctx);
     if (m_button_panel)
-        m_button_panel->set_visible(true);
+        m_button_panel->m_visible = true;
 
-    nvgFontSize(ctx, 18.0f);
-    nvgFontFace(ctx, "sans-bold");
-    float bounds[4];
-    nvgTextBounds(ctx, 0, 0, m_title.c_str(), nullptr, bounds);
+    m_title_layout.update(ctx, m_title, "sans-bold", 18.0f);
+    const float *bounds = m_title_layout.bounds();
 
     return Vector2i(
         std::max(result.x(), (int) (bounds[2]-bounds[0] + 20)),
@@ -51,17 +50,17 @@ void Window::perform_layout(NVGcontext *ctx) {
     if (!m_button_panel) {
         Widget::perform_layout(ctx);
     } else {
-        m_button_panel->set_visible(false);
+        m_button_panel->m_visible = false;
         Widget::perform_layout(ctx);
         for (auto w : m_button_panel->children()) {
             w->set_fixed_size(Vector2i(22, 22));
             w->set_font_size(15);
         }
-        m_button_panel->set_visible(true);
+        m_button_panel->m_visible = true;
         m_button_panel->set_size(Vector2i(width(), 22));
         m_button_panel->set_position(Vector2i(
-            width() - (m_button_panel->preferred_size(ctx).x() + 5), 3));
-        m_button_panel->perform_layout(ctx);
+            width() - (m_button_panel->cached_preferred_size(ctx).x() + 5), 3));
+        m_button_panel->update_layout(ctx);
     }
 }
 
@@ -123,20 +122,19 @@ void Window::draw(NVGcontext *ctx) {
         nvgStrokeColor(ctx, m_theme->m_window_header_sep_bot);
         nvgStroke(ctx);
 
-        nvgFontSize(ctx, 18.0f);
-        nvgFontFace(ctx, "sans-bold");
-        nvgTextAlign(ctx, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
+        m_title_layout.update(ctx, m_title, "sans-bold", 18.0f);
+        const int align = NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE;
 
         nvgFontBlur(ctx, 2);
         nvgFillColor(ctx, m_theme->m_drop_shadow);
-        nvgText(ctx, m_pos.x() + m_size.x() / 2,
-                m_pos.y() + hh / 2, m_title.c_str(), nullptr);
+        m_title_layout.draw(ctx, m_pos.x() + m_size.x() / 2,
+                            m_pos.y() + hh / 2, align);
 
         nvgFontBlur(ctx, 0);
         nvgFillColor(ctx, m_focused ? m_theme->m_window_title_focused
                                     : m_theme->m_window_title_unfocused);
-        nvgText(ctx, m_pos.x() + m_size.x() / 2, m_pos.y() + hh / 2 - 1,
-                m_title.c_str(), nullptr);
+        m_title_layout.draw(ctx, m_pos.x() + m_size.x() / 2,
+                            m_pos.y() + hh / 2 - 1, align);
     }
 
     nvgRestore(ctx);
@@ -168,6 +166,7 @@ bool Window::mouse_drag_event(const Vector2i &, const Vector2i &rel,
         m_pos += rel;
         m_pos = max(m_pos, Vector2i(0));
         m_pos = min(m_pos, parent()->size() - m_size);
+        parent()->invalidate_spatial_index();
         return true;
     }
     return false;
@@ -192,4 +191,8 @@ void Window::refresh_relative_placement() {
     /* Overridden in \ref Popup */
 }
 
+int Window::layer_margin() const {
+    return m_theme->m_window_drop_shadow_size;
+}
+
 NAMESPACE_END(waylandgui)